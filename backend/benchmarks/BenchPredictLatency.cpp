@@ -0,0 +1,125 @@
+// Per-event scoring latency of the XGBoostModel prediction paths.
+// Build with -DBUILD_BENCHMARKS=ON and run: BenchPredictLatency [rows] [features] [iterations]
+#include "../ml/CompiledEnsemble.h"
+#include "../ml/XGBoostModel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace MLPipeline;
+
+namespace {
+    struct LatencyStats {
+        double mean_ns = 0.0;
+        double p50_ns = 0.0;
+        double p99_ns = 0.0;
+    };
+
+    LatencyStats measure(size_t iterations, const std::function<void(size_t)>& call) {
+        std::vector<double> samples(iterations);
+        for (size_t i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            call(i);
+            auto end = std::chrono::steady_clock::now();
+            samples[i] = std::chrono::duration<double, std::nano>(end - start).count();
+        }
+        LatencyStats stats;
+        for (double s : samples) stats.mean_ns += s;
+        stats.mean_ns /= static_cast<double>(iterations);
+        std::sort(samples.begin(), samples.end());
+        stats.p50_ns = samples[iterations / 2];
+        stats.p99_ns = samples[std::min(iterations - 1, iterations * 99 / 100)];
+        return stats;
+    }
+
+    void report(const char* name, const LatencyStats& stats) {
+        std::printf("%-28s mean %10.0f ns   p50 %10.0f ns   p99 %10.0f ns\n",
+                    name, stats.mean_ns, stats.p50_ns, stats.p99_ns);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    size_t cols = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 24;
+    size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20000;
+
+    std::mt19937 rng(42);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<float> X(rows * cols);
+    std::vector<float> y(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        float signal = 0.0f;
+        for (size_t j = 0; j < cols; ++j) {
+            X[i * cols + j] = noise(rng);
+            if (j < 3) signal += X[i * cols + j];
+        }
+        y[i] = signal + 0.5f * noise(rng) > 0.0f ? 1.0f : 0.0f;
+    }
+
+    XGBoostConfig config;
+    config.n_rounds = 100;
+    config.max_depth = 6;
+    config.nthread = 1;
+
+    XGBoostModel model;
+    model.fit(DenseMatrixView(X.data(), rows, cols), y, config);
+
+    std::vector<std::vector<float>> nested_row(1, std::vector<float>(cols));
+    volatile int sink = 0;
+
+    // Warm up XGBoost's per-thread prediction buffers before timing.
+    for (size_t i = 0; i < 100; ++i) sink = sink + model.predict_one(&X[(i % rows) * cols]);
+
+    report("predict(nested vector)", measure(iterations, [&](size_t i) {
+        const float* row = &X[(i % rows) * cols];
+        nested_row[0].assign(row, row + cols);
+        sink = sink + model.predict(nested_row)[0];
+    }));
+    report("predict(DenseMatrixView)", measure(iterations, [&](size_t i) {
+        sink = sink + model.predict(DenseMatrixView(&X[(i % rows) * cols], 1, cols))[0];
+    }));
+    report("predict_one", measure(iterations, [&](size_t i) {
+        sink = sink + model.predict_one(&X[(i % rows) * cols]);
+    }));
+
+    const size_t batch = 64;
+    LatencyStats batched = measure(iterations / batch + 1, [&](size_t i) {
+        size_t start = (i * batch) % (rows - batch);
+        sink = sink + static_cast<int>(model.predict_batch_inplace(DenseMatrixView(&X[start * cols], batch, cols))[0]);
+    });
+    batched.mean_ns /= batch;
+    batched.p50_ns /= batch;
+    batched.p99_ns /= batch;
+    report("predict_batch_inplace (/row)", batched);
+
+    CompiledEnsemble compiled = CompiledEnsemble::compile(model);
+    DenseMatrixView all(X.data(), rows, cols);
+    std::vector<float> expected = model.predict_raw(all);
+    std::vector<float> actual = compiled.predict_raw(all);
+    float max_diff = 0.0f;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        max_diff = std::max(max_diff, std::fabs(expected[i] - actual[i]));
+    }
+    std::printf("compiled ensemble: %zu trees, %zu nodes, max |diff| vs predict_raw %.3g\n",
+                compiled.num_trees(), compiled.num_nodes(), static_cast<double>(max_diff));
+
+    report("compiled predict_raw (1 row)", measure(iterations, [&](size_t i) {
+        sink = sink + static_cast<int>(compiled.predict_raw(DenseMatrixView(&X[(i % rows) * cols], 1, cols))[0]);
+    }));
+    std::vector<float> margins(batch);
+    LatencyStats compiled_batch = measure(iterations / batch + 1, [&](size_t i) {
+        size_t start = (i * batch) % (rows - batch);
+        compiled.predict_margin(DenseMatrixView(&X[start * cols], batch, cols), margins.data());
+        sink = sink + static_cast<int>(margins[0]);
+    });
+    compiled_batch.mean_ns /= batch;
+    compiled_batch.p50_ns /= batch;
+    compiled_batch.p99_ns /= batch;
+    report("compiled margins (/row)", compiled_batch);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Allocation-free calendar arithmetic on timestamps of the form
+// "YYYY-MM-DD", "YYYY/MM/DD" or either followed by "[T ]HH:MM[:SS]".
+// Nothing here touches the C library's timezone state, so it is safe to
+// call from any number of threads.
+namespace CalendarUtils {
+    struct ParsedTimestamp {
+        int year = 0;
+        int month = 0;
+        int day = 0;
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+        bool valid = false;
+    };
+
+    enum Session {
+        ASIA = 0,           // 00:00 - 07:59
+        EUROPE = 1,         // 08:00 - 12:59
+        EUROPE_US = 2,      // 13:00 - 16:59
+        US = 3,             // 17:00 - 21:59
+        OFF_HOURS = 4       // 22:00 - 23:59
+    };
+
+    constexpr int EUROPE_OPEN_MINUTE = 8 * 60;
+    constexpr int US_OPEN_MINUTE = 13 * 60;
+    constexpr int EUROPE_CLOSE_MINUTE = 17 * 60;
+    constexpr int US_CLOSE_MINUTE = 22 * 60;
+
+    // Days since 1970-01-01 in the proleptic Gregorian calendar (H. Hinnant's days_from_civil).
+    constexpr int64_t daysFromCivil(int year, int month, int day) noexcept {
+        const int64_t y = static_cast<int64_t>(year) - (month <= 2);
+        const int64_t era = (y - (y < 0) * 399) / 400;
+        const int64_t yoe = y - era * 400;
+        const int64_t mp = (month + 9) % 12;
+        const int64_t doy = (153 * mp + 2) / 5 + day - 1;
+        const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    // 0 = Sunday ... 6 = Saturday, matching std::tm::tm_wday.
+    constexpr int weekdayFromDays(int64_t days) noexcept {
+        return static_cast<int>((days % 7 + 11) % 7);
+    }
+
+    constexpr int sessionBucket(int minuteOfDay) noexcept {
+        return (minuteOfDay >= EUROPE_OPEN_MINUTE) + (minuteOfDay >= US_OPEN_MINUTE) +
+               (minuteOfDay >= EUROPE_CLOSE_MINUTE) + (minuteOfDay >= US_CLOSE_MINUTE);
+    }
+
+    namespace detail {
+        inline bool parseDigits(const char* s, size_t len, size_t pos, size_t count, int& out) noexcept {
+            if (pos + count > len) return false;
+            int value = 0;
+            for (size_t i = pos; i < pos + count; ++i) {
+                unsigned digit = static_cast<unsigned>(s[i] - '0');
+                if (digit > 9) return false;
+                value = value * 10 + static_cast<int>(digit);
+            }
+            out = value;
+            return true;
+        }
+    }
+
+    inline ParsedTimestamp parseTimestamp(const char* s, size_t len) noexcept {
+        ParsedTimestamp ts;
+        if (!detail::parseDigits(s, len, 0, 4, ts.year) ||
+            !detail::parseDigits(s, len, 5, 2, ts.month) ||
+            !detail::parseDigits(s, len, 8, 2, ts.day)) {
+            return ts;
+        }
+        if ((s[4] != '-' && s[4] != '/') || s[7] != s[4]) return ts;
+        if (ts.month < 1 || ts.month > 12 || ts.day < 1 || ts.day > 31) return ts;
+
+        if (len > 10 && (s[10] == 'T' || s[10] == ' ')) {
+            if (!detail::parseDigits(s, len, 11, 2, ts.hour) || len < 14 || s[13] != ':' ||
+                !detail::parseDigits(s, len, 14, 2, ts.minute)) {
+                return ts;
+            }
+            if (len > 16 && s[16] == ':' && !detail::parseDigits(s, len, 17, 2, ts.second)) {
+                return ts;
+            }
+            if (ts.hour > 23 || ts.minute > 59 || ts.second > 60) return ts;
+        }
+
+        ts.valid = true;
+        return ts;
+    }
+
+    inline ParsedTimestamp parseTimestamp(const std::string& s) noexcept {
+        return parseTimestamp(s.data(), s.size());
+    }
+
+    inline int64_t daysSinceEpoch(const ParsedTimestamp& ts) noexcept {
+        return daysFromCivil(ts.year, ts.month, ts.day);
+    }
+
+    inline int dayOfWeek(const ParsedTimestamp& ts) noexcept {
+        return weekdayFromDays(daysSinceEpoch(ts));
+    }
+
+    inline int minuteOfDay(const ParsedTimestamp& ts) noexcept {
+        return ts.hour * 60 + ts.minute;
+    }
+
+    // Fractional days since 1970-01-01, used for distances between timestamps.
+    inline double fractionalDays(const ParsedTimestamp& ts) noexcept {
+        return static_cast<double>(daysSinceEpoch(ts)) +
+               (ts.hour * 3600 + ts.minute * 60 + ts.second) / 86400.0;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "PreprocessedRow.h"
+#include "LabeledEvent.h"
+
+namespace EventIndexUtils {
+    inline bool hasValidEntryIndex(const LabeledEvent& event, const std::vector<PreprocessedRow>& rows) {
+        return event.entry_index >= 0 &&
+               event.entry_index < static_cast<int>(rows.size()) &&
+               rows[event.entry_index].timestamp == event.entry_time;
+    }
+
+    // First row position for each timestamp, matching a front-to-back linear search.
+    inline std::unordered_map<std::string, int> buildTimestampIndex(const std::vector<PreprocessedRow>& rows) {
+        std::unordered_map<std::string, int> index;
+        index.reserve(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            index.emplace(rows[i].timestamp, static_cast<int>(i));
+        }
+        return index;
+    }
+
+    // Row position of every event's entry (-1 when it cannot be matched), aligned with labeledEvents.
+    // Uses the index carried on the event and only builds a timestamp index if some event lacks one.
+    inline std::vector<int> resolveEntryIndices(
+        const std::vector<PreprocessedRow>& rows,
+        const std::vector<LabeledEvent>& labeledEvents
+    ) {
+        std::vector<int> indices(labeledEvents.size(), -1);
+        bool needsLookup = false;
+
+        for (size_t i = 0; i < labeledEvents.size(); ++i) {
+            if (hasValidEntryIndex(labeledEvents[i], rows)) {
+                indices[i] = labeledEvents[i].entry_index;
+            } else {
+                needsLookup = true;
+            }
+        }
+
+        if (!needsLookup || rows.empty()) {
+            return indices;
+        }
+
+        auto timestampIndex = buildTimestampIndex(rows);
+        for (size_t i = 0; i < labeledEvents.size(); ++i) {
+            if (indices[i] >= 0) continue;
+            auto it = timestampIndex.find(labeledEvents[i].entry_time);
+            if (it != timestampIndex.end()) {
+                indices[i] = it->second;
+            }
+        }
+        return indices;
+    }
+
+    // Row position of the bar an event's label was resolved on, given its entry position:
+    // the index carried on the event when it is consistent, else entry + periods_to_exit,
+    // clamped to the series.
+    inline int resolveExitIndex(const LabeledEvent& event, int entryIndex, size_t rowCount) {
+        if (entryIndex < 0 || rowCount == 0) return -1;
+        const int last = static_cast<int>(rowCount) - 1;
+        if (event.exit_index >= entryIndex && event.exit_index <= last) {
+            return event.exit_index;
+        }
+        long long exit = static_cast<long long>(entryIndex) + std::max(0, event.periods_to_exit);
+        return static_cast<int>(std::min<long long>(exit, last));
+    }
+}
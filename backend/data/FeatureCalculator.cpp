@@ -3,7 +3,6 @@
 #include <algorithm>
 #include <numeric>
 #include <stdexcept>
-#include <ctime>
 #include <iostream>
 
 const std::string FeatureCalculator::CLOSE_TO_CLOSE_RETURN_1D = "close_to_close_return_1d";
@@ -22,6 +21,20 @@ const std::string FeatureCalculator::CLOSE_OVER_HIGH_5D = "close_over_high_5d";
 const std::string FeatureCalculator::SLOPE_LR_10D = "slope_lr_10d";
 const std::string FeatureCalculator::DAY_OF_WEEK = "day_of_week";
 const std::string FeatureCalculator::DAYS_SINCE_LAST_EVENT = "days_since_last_event";
+const std::string FeatureCalculator::HOUR_OF_DAY = "hour_of_day";
+const std::string FeatureCalculator::MINUTE_OF_DAY = "minute_of_day";
+const std::string FeatureCalculator::MONTH_OF_YEAR = "month_of_year";
+const std::string FeatureCalculator::SESSION_BUCKET = "session_bucket";
+const std::string FeatureCalculator::EVENTS_LAST_20_BARS = "events_last_20_bars";
+const std::string FeatureCalculator::EVENTS_LAST_50_BARS = "events_last_50_bars";
+
+namespace {
+    double fractionalDaysAt(const std::vector<std::string>& timestamps, int idx) {
+        if (idx < 0 || idx >= (int)timestamps.size()) return NAN;
+        CalendarUtils::ParsedTimestamp ts = CalendarUtils::parseTimestamp(timestamps[idx]);
+        return ts.valid ? CalendarUtils::fractionalDays(ts) : NAN;
+    }
+}
 
 std::map<std::string, double> FeatureCalculator::calculateFeatures(
     const std::vector<double>& prices,
@@ -34,6 +47,27 @@ std::map<std::string, double> FeatureCalculator::calculateFeatures(
     std::map<std::string, double> features;
     int idx = eventIndices[eventIdx];
     
+    CalendarUtils::ParsedTimestamp ts;
+    bool tsParsed = false;
+    auto calendar = [&](int (*extract)(const CalendarUtils::ParsedTimestamp&)) -> double {
+        if (!tsParsed) {
+            if (idx >= 0 && idx < (int)timestamps.size()) ts = CalendarUtils::parseTimestamp(timestamps[idx]);
+            tsParsed = true;
+        }
+        return ts.valid ? extract(ts) : NAN;
+    };
+    
+    std::vector<int> sortedEvents;
+    auto eventRows = [&]() -> const std::vector<int>& {
+        if (eventStarts) return *eventStarts;
+        if (std::is_sorted(eventIndices.begin(), eventIndices.end())) return eventIndices;
+        if (sortedEvents.empty()) {
+            sortedEvents = eventIndices;
+            std::sort(sortedEvents.begin(), sortedEvents.end());
+        }
+        return sortedEvents;
+    };
+    
     for (const auto& feat : selectedFeatures) {
         double value = NAN;
         if (feat == CLOSE_TO_CLOSE_RETURN_1D) value = closeToCloseReturn1D(prices, idx);
@@ -50,7 +84,14 @@ std::map<std::string, double> FeatureCalculator::calculateFeatures(
         else if (feat == PRICE_RANGE_5D) value = priceRangeND(prices, idx, 5);
         else if (feat == CLOSE_OVER_HIGH_5D) value = closeOverHighND(prices, idx, 5);
         else if (feat == SLOPE_LR_10D) value = slopeLRND(prices, idx, 10);
-        else if (feat == DAY_OF_WEEK) value = dayOfWeek(timestamps, idx);
+        else if (feat == DAY_OF_WEEK) value = calendar(&dayOfWeek);
+        else if (feat == HOUR_OF_DAY) value = calendar(&hourOfDay);
+        else if (feat == MINUTE_OF_DAY) value = calendar(&minuteOfDay);
+        else if (feat == MONTH_OF_YEAR) value = calendar(&monthOfYear);
+        else if (feat == SESSION_BUCKET) value = calendar(&sessionBucket);
+        else if (feat == DAYS_SINCE_LAST_EVENT) value = daysSinceLastEvent(timestamps, eventRows(), idx);
+        else if (feat == EVENTS_LAST_20_BARS) value = eventsInLastNBars(eventRows(), idx, 20);
+        else if (feat == EVENTS_LAST_50_BARS) value = eventsInLastNBars(eventRows(), idx, 50);
         
         features[feat] = value;
     }
@@ -199,14 +240,87 @@ double FeatureCalculator::slopeLRND(const std::vector<double>& prices, int idx,
 
 int FeatureCalculator::dayOfWeek(const std::vector<std::string>& timestamps, int idx) {
     if (idx < 0 || idx >= (int)timestamps.size()) return -1;
-    std::tm tm = {};
-    std::string s = timestamps[idx].substr(0, 10);
-    sscanf(s.c_str(), "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
-    tm.tm_year -= 1900;
-    tm.tm_mon -= 1;
-    tm.tm_hour = 0;
-    tm.tm_min = 0;
-    tm.tm_sec = 0;
-    std::mktime(&tm);
-    return tm.tm_wday;
+    CalendarUtils::ParsedTimestamp ts = CalendarUtils::parseTimestamp(timestamps[idx]);
+    if (!ts.valid) return -1;
+    return dayOfWeek(ts);
+}
+
+bool FeatureCalculator::isEventTimingFeature(const std::string& feature) {
+    return feature == DAYS_SINCE_LAST_EVENT || feature == EVENTS_LAST_20_BARS || feature == EVENTS_LAST_50_BARS;
+}
+
+FeatureCalculator::EventTimingFeatures FeatureCalculator::calculateEventTimingFeatures(
+    const std::vector<std::string>& timestamps,
+    const std::vector<int>& eventIndices
+) {
+    const size_t n = eventIndices.size();
+    EventTimingFeatures result;
+    result.days_since_last_event.assign(n, NAN);
+    result.events_last_20_bars.assign(n, 0.0);
+    result.events_last_50_bars.assign(n, 0.0);
+    if (n == 0) return result;
+    
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    if (!std::is_sorted(eventIndices.begin(), eventIndices.end())) {
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return eventIndices[a] < eventIndices[b]; });
+    }
+    
+    double seriesStart = fractionalDaysAt(timestamps, 0);
+    double prevDays = seriesStart;
+    double currentDays = seriesStart;
+    int currentRow = -1;
+    size_t earlier = 0;  // events on rows before the current one
+    size_t tail20 = 0, tail50 = 0;
+    
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = order[k];
+        int row = eventIndices[i];
+        if (row != currentRow) {
+            if (currentRow >= 0) prevDays = currentDays;
+            earlier = k;
+            currentRow = row;
+            currentDays = fractionalDaysAt(timestamps, row);
+        }
+        while (eventIndices[order[tail20]] < row - 20) ++tail20;
+        while (eventIndices[order[tail50]] < row - 50) ++tail50;
+        
+        result.days_since_last_event[i] = currentDays - prevDays;
+        result.events_last_20_bars[i] = static_cast<double>(earlier - tail20);
+        result.events_last_50_bars[i] = static_cast<double>(earlier - tail50);
+    }
+    return result;
+}
+
+double FeatureCalculator::daysSinceLastEvent(const std::vector<std::string>& timestamps, const std::vector<int>& sortedEventRows, int idx) {
+    auto it = std::lower_bound(sortedEventRows.begin(), sortedEventRows.end(), idx);
+    int prevRow = (it == sortedEventRows.begin()) ? 0 : *std::prev(it);
+    return fractionalDaysAt(timestamps, idx) - fractionalDaysAt(timestamps, prevRow);
+}
+
+int FeatureCalculator::eventsInLastNBars(const std::vector<int>& sortedEventRows, int idx, int n) {
+    auto end = std::lower_bound(sortedEventRows.begin(), sortedEventRows.end(), idx);
+    auto begin = std::lower_bound(sortedEventRows.begin(), end, idx - n);
+    return static_cast<int>(end - begin);
+}
+
+int FeatureCalculator::dayOfWeek(const CalendarUtils::ParsedTimestamp& ts) {
+    return CalendarUtils::dayOfWeek(ts);
+}
+
+int FeatureCalculator::hourOfDay(const CalendarUtils::ParsedTimestamp& ts) {
+    return ts.hour;
+}
+
+int FeatureCalculator::minuteOfDay(const CalendarUtils::ParsedTimestamp& ts) {
+    return CalendarUtils::minuteOfDay(ts);
+}
+
+int FeatureCalculator::monthOfYear(const CalendarUtils::ParsedTimestamp& ts) {
+    return ts.month;
+}
+
+int FeatureCalculator::sessionBucket(const CalendarUtils::ParsedTimestamp& ts) {
+    return CalendarUtils::sessionBucket(CalendarUtils::minuteOfDay(ts));
 }
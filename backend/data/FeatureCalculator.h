@@ -3,6 +3,7 @@
 #include <string>
 #include <map>
 #include <set>
+#include "CalendarUtils.h"
 
 class FeatureCalculator {
 public:
@@ -22,7 +23,25 @@ public:
     static const std::string SLOPE_LR_10D;
     static const std::string DAY_OF_WEEK;
     static const std::string DAYS_SINCE_LAST_EVENT;
+    static const std::string HOUR_OF_DAY;
+    static const std::string MINUTE_OF_DAY;
+    static const std::string MONTH_OF_YEAR;
+    static const std::string SESSION_BUCKET;
+    static const std::string EVENTS_LAST_20_BARS;
+    static const std::string EVENTS_LAST_50_BARS;
 
+    // Features that depend on the positions of other events, aligned with eventIndices.
+    struct EventTimingFeatures {
+        std::vector<double> days_since_last_event;
+        std::vector<double> events_last_20_bars;
+        std::vector<double> events_last_50_bars;
+    };
+
+    static bool isEventTimingFeature(const std::string& feature);
+
+    // eventStarts, when given, must hold the event rows in ascending order. Without it
+    // the timing features sort eventIndices on every call, so callers looping over
+    // unsorted events should sort once and pass the result.
     static std::map<std::string, double> calculateFeatures(
         const std::vector<double>& prices,
         const std::vector<std::string>& timestamps,
@@ -44,4 +63,21 @@ public:
     static double closeOverHighND(const std::vector<double>& prices, int idx, int n);
     static double slopeLRND(const std::vector<double>& prices, int idx, int n);
     static int dayOfWeek(const std::vector<std::string>& timestamps, int idx);
+
+    // One forward pass over the events in row order: each timestamp is parsed once and
+    // the "events in the last N bars" counts come from a sliding window.
+    static EventTimingFeatures calculateEventTimingFeatures(
+        const std::vector<std::string>& timestamps,
+        const std::vector<int>& eventIndices
+    );
+    // Single-event variants; sortedEventRows must be ascending. The previous event is the
+    // latest one on an earlier row; the first event measures from the start of the series.
+    static double daysSinceLastEvent(const std::vector<std::string>& timestamps, const std::vector<int>& sortedEventRows, int idx);
+    static int eventsInLastNBars(const std::vector<int>& sortedEventRows, int idx, int n);
+
+    static int dayOfWeek(const CalendarUtils::ParsedTimestamp& ts);
+    static int hourOfDay(const CalendarUtils::ParsedTimestamp& ts);
+    static int minuteOfDay(const CalendarUtils::ParsedTimestamp& ts);
+    static int monthOfYear(const CalendarUtils::ParsedTimestamp& ts);
+    static int sessionBucket(const CalendarUtils::ParsedTimestamp& ts);
 };
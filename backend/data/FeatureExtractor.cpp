@@ -1,6 +1,8 @@
 #include "FeatureExtractor.h"
 #include "FeatureCalculator.h"
 #include "DataCleaningUtils.h"
+#include "EventIndexUtils.h"
+#include "../utils/ParallelUtils.h"
 #include <algorithm>
 #include <iostream>
 #include <numeric>
@@ -23,17 +25,17 @@ std::map<std::string, std::string> FeatureExtractor::getFeatureMapping() {
         {"Current close price relative to 5-day high", FeatureCalculator::CLOSE_OVER_HIGH_5D},
         {"Slope of linear regression of close prices over 10 days", FeatureCalculator::SLOPE_LR_10D},
         {"Day of the week", FeatureCalculator::DAY_OF_WEEK},
-        {"Days since last event", FeatureCalculator::DAYS_SINCE_LAST_EVENT}
+        {"Days since last event", FeatureCalculator::DAYS_SINCE_LAST_EVENT},
+        {"Hour of the day", FeatureCalculator::HOUR_OF_DAY},
+        {"Minute of the day", FeatureCalculator::MINUTE_OF_DAY},
+        {"Month of the year", FeatureCalculator::MONTH_OF_YEAR},
+        {"Trading session", FeatureCalculator::SESSION_BUCKET},
+        {"Events in the last 20 bars", FeatureCalculator::EVENTS_LAST_20_BARS},
+        {"Events in the last 50 bars", FeatureCalculator::EVENTS_LAST_50_BARS}
     };
 }
 
-FeatureExtractor::FeatureExtractionResult FeatureExtractor::extractFeaturesForClassification(
-    const std::set<std::string>& selectedFeatures,
-    const std::vector<PreprocessedRow>& rows,
-    const std::vector<LabeledEvent>& labeledEvents
-) {
-    FeatureExtractionResult result;
-     
+std::set<std::string> FeatureExtractor::resolveBackendFeatures(const std::set<std::string>& selectedFeatures) {
     auto featureMap = getFeatureMapping();
     std::set<std::string> backendFeatures;
     for (const std::string& feat : selectedFeatures) {
@@ -41,28 +43,52 @@ FeatureExtractor::FeatureExtractionResult FeatureExtractor::extractFeaturesForCl
             backendFeatures.insert(featureMap[feat]);
         }
     }
+    return backendFeatures;
+}
+
+FeatureExtractor::FeatureExtractionResult FeatureExtractor::extractFeaturesForClassification(
+    const std::set<std::string>& selectedFeatures,
+    const std::vector<PreprocessedRow>& rows,
+    const std::vector<LabeledEvent>& labeledEvents
+) {
+    FeatureExtractionResult result;
+     
+    std::set<std::string> backendFeatures = resolveBackendFeatures(selectedFeatures);
     
     std::vector<double> prices;
     std::vector<std::string> timestamps;
+    prices.reserve(rows.size());
+    timestamps.reserve(rows.size());
     for (const auto& row : rows) {
         prices.push_back(row.price);
         timestamps.push_back(row.timestamp);
     }
     
-    std::vector<int> eventIndices = findEventIndices(rows, labeledEvents);
+    std::vector<size_t> matchedEvents;
+    std::vector<int> eventIndices = findEventIndices(rows, labeledEvents, matchedEvents);
     
     if (eventIndices.empty()) {
         return result;
     }
     
+    std::set<std::string> timingFeatures = takeEventTimingFeatures(backendFeatures);
+    FeatureCalculator::EventTimingFeatures timing;
+    if (!timingFeatures.empty()) {
+        timing = FeatureCalculator::calculateEventTimingFeatures(timestamps, eventIndices);
+    }
+    
     for (size_t i = 0; i < eventIndices.size(); ++i) {
         auto features = FeatureCalculator::calculateFeatures(
             prices, timestamps, eventIndices, int(i), backendFeatures
         );
+        addEventTimingFeatures(features, timing, timingFeatures, i);
         
+        const auto& event = labeledEvents[matchedEvents[i]];
         result.features.push_back(features);
-        result.labels.push_back(labeledEvents[i].label);
-        result.returns.push_back((labeledEvents[i].exit_price - labeledEvents[i].entry_price) / labeledEvents[i].entry_price);
+        result.labels.push_back(event.label);
+        result.returns.push_back((event.exit_price - event.entry_price) / event.entry_price);
+        result.entry_indices.push_back(eventIndices[i]);
+        result.exit_indices.push_back(EventIndexUtils::resolveExitIndex(event, eventIndices[i], rows.size()));
     }
     
     return result;
@@ -75,37 +101,44 @@ FeatureExtractor::FeatureExtractionResult FeatureExtractor::extractFeaturesForRe
 ) {
     FeatureExtractionResult result;
     
-    auto featureMap = getFeatureMapping();
-    std::set<std::string> backendFeatures;
-    for (const std::string& feat : selectedFeatures) {
-        if (featureMap.count(feat)) {
-            backendFeatures.insert(featureMap[feat]);
-        }
-    }
+    std::set<std::string> backendFeatures = resolveBackendFeatures(selectedFeatures);
     
     std::vector<double> prices;
     std::vector<std::string> timestamps;
+    prices.reserve(rows.size());
+    timestamps.reserve(rows.size());
     for (const auto& row : rows) {
         prices.push_back(row.price);
         timestamps.push_back(row.timestamp);
     }
     
-    std::vector<int> eventIndices = findEventIndices(rows, labeledEvents);
+    std::vector<size_t> matchedEvents;
+    std::vector<int> eventIndices = findEventIndices(rows, labeledEvents, matchedEvents);
     
     if (eventIndices.empty()) {
         return result;
     }
     
+    std::set<std::string> timingFeatures = takeEventTimingFeatures(backendFeatures);
+    FeatureCalculator::EventTimingFeatures timing;
+    if (!timingFeatures.empty()) {
+        timing = FeatureCalculator::calculateEventTimingFeatures(timestamps, eventIndices);
+    }
+    
     for (size_t i = 0; i < eventIndices.size(); ++i) {        
         auto baseFeatures = FeatureCalculator::calculateFeatures(
             prices, timestamps, eventIndices, int(i), backendFeatures
         );
+        addEventTimingFeatures(baseFeatures, timing, timingFeatures, i);
         
         auto enhancedFeatures = enhanceFeatures(baseFeatures, rows[eventIndices[i]]);
         
+        const auto& event = labeledEvents[matchedEvents[i]];
         result.features.push_back(enhancedFeatures);
-        result.labels_double.push_back(labeledEvents[i].ttbm_label);
-        result.returns.push_back((labeledEvents[i].exit_price - labeledEvents[i].entry_price) / labeledEvents[i].entry_price);
+        result.labels_double.push_back(event.ttbm_label);
+        result.returns.push_back((event.exit_price - event.entry_price) / event.entry_price);
+        result.entry_indices.push_back(eventIndices[i]);
+        result.exit_indices.push_back(EventIndexUtils::resolveExitIndex(event, eventIndices[i], rows.size()));
     }
 
     for (auto& featureRow : result.features) {
@@ -116,7 +149,7 @@ FeatureExtractor::FeatureExtractionResult FeatureExtractor::extractFeaturesForRe
         }
     }
     
-    applyRobustScaling(result.features);
+    result.scaling = applyRobustScaling(result.features);
     
     if (!result.labels_double.empty()) {
         double min_label = *std::min_element(result.labels_double.begin(), result.labels_double.end());
@@ -136,28 +169,55 @@ FeatureExtractor::FeatureExtractionResult FeatureExtractor::extractFeaturesForRe
 
 std::vector<int> FeatureExtractor::findEventIndices(
     const std::vector<PreprocessedRow>& rows,
-    const std::vector<LabeledEvent>& labeledEvents
+    const std::vector<LabeledEvent>& labeledEvents,
+    std::vector<size_t>& matchedEvents
 ) {
     std::vector<int> eventIndices;
+    matchedEvents.clear();
     
     if (rows.empty() || labeledEvents.empty()) {
         return eventIndices;
     }
     
-    int found_count = 0;
-    for (size_t i = 0; i < labeledEvents.size(); ++i) {
-        const auto& event = labeledEvents[i];
-        auto it = std::find_if(rows.begin(), rows.end(), 
-            [&](const PreprocessedRow& r) { return r.timestamp == event.entry_time; });
-        if (it != rows.end()) {
-            eventIndices.push_back(int(std::distance(rows.begin(), it)));
-            found_count++;
+    std::vector<int> entryIndices = EventIndexUtils::resolveEntryIndices(rows, labeledEvents);
+    eventIndices.reserve(entryIndices.size());
+    matchedEvents.reserve(entryIndices.size());
+    for (size_t i = 0; i < entryIndices.size(); ++i) {
+        if (entryIndices[i] >= 0) {
+            eventIndices.push_back(entryIndices[i]);
+            matchedEvents.push_back(i);
         }
     }
     
     return eventIndices;
 }
 
+std::set<std::string> FeatureExtractor::takeEventTimingFeatures(std::set<std::string>& backendFeatures) {
+    std::set<std::string> timingFeatures;
+    for (auto it = backendFeatures.begin(); it != backendFeatures.end();) {
+        if (FeatureCalculator::isEventTimingFeature(*it)) {
+            timingFeatures.insert(*it);
+            it = backendFeatures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return timingFeatures;
+}
+
+void FeatureExtractor::addEventTimingFeatures(
+    std::map<std::string, double>& features,
+    const FeatureCalculator::EventTimingFeatures& timing,
+    const std::set<std::string>& timingFeatures,
+    size_t eventIdx
+) {
+    for (const auto& feat : timingFeatures) {
+        if (feat == FeatureCalculator::DAYS_SINCE_LAST_EVENT) features[feat] = timing.days_since_last_event[eventIdx];
+        else if (feat == FeatureCalculator::EVENTS_LAST_20_BARS) features[feat] = timing.events_last_20_bars[eventIdx];
+        else if (feat == FeatureCalculator::EVENTS_LAST_50_BARS) features[feat] = timing.events_last_50_bars[eventIdx];
+    }
+}
+
 std::map<std::string, double> FeatureExtractor::enhanceFeatures(
     const std::map<std::string, double>& baseFeatures,
     const PreprocessedRow& row
@@ -207,50 +267,119 @@ std::map<std::string, double> FeatureExtractor::enhanceFeatures(
     return enhanced;
 }
 
-void FeatureExtractor::applyRobustScaling(std::vector<std::map<std::string, double>>& features) {
-    if (features.empty()) return;
-    
-    std::map<std::string, double> feature_medians;
-    std::map<std::string, double> feature_iqrs;
-    
-    for (const auto& featureRow : features) {
-        for (const auto& kv : featureRow) {
-            if (feature_medians.find(kv.first) == feature_medians.end()) {
-                feature_medians[kv.first] = 0.0;
-                feature_iqrs[kv.first] = 0.0;
-            }
+namespace {
+    // Below this many values the thread start-up cost outweighs the per-feature work.
+    constexpr size_t PARALLEL_SCALING_MIN_VALUES = 1 << 16;
+
+    // Median and IQR by selection: one nth_element for the median, then the quartiles
+    // are selected inside the half that must contain them. Matches the order
+    // statistics of a full sort (q1 = v[n/4], q3 = v[3n/4]).
+    void robustStatistics(std::vector<double>& values, double& median, double& iqr) {
+        const size_t n = values.size();
+        const size_t mid = n / 2;
+        auto begin = values.begin();
+
+        std::nth_element(begin, begin + mid, values.end());
+        const double upper = values[mid];
+        median = (n % 2 == 0) ? (*std::max_element(begin, begin + mid) + upper) / 2.0 : upper;
+
+        const size_t q1_idx = n / 4;
+        const size_t q3_idx = 3 * n / 4;
+        double q1 = upper;
+        double q3 = upper;
+        if (q1_idx < mid) {
+            std::nth_element(begin, begin + q1_idx, begin + mid);
+            q1 = values[q1_idx];
         }
+        if (q3_idx > mid) {
+            std::nth_element(begin + mid + 1, begin + q3_idx, values.end());
+            q3 = values[q3_idx];
+        }
+
+        iqr = q3 - q1;
+        if (iqr < 1e-10) iqr = 1.0;
     }
-    
-    for (const auto& kv : feature_medians) {
-        std::vector<double> values;
-        for (const auto& featureRow : features) {
-            auto it = featureRow.find(kv.first);
-            if (it != featureRow.end()) {
-                values.push_back(it->second);
+
+    std::vector<std::string> collectFeatureNames(const std::vector<std::map<std::string, double>>& features) {
+        std::vector<std::string> names;
+        for (const auto& row : features) {
+            bool same = row.size() == names.size() &&
+                std::equal(row.begin(), row.end(), names.begin(),
+                           [](const auto& kv, const std::string& name) { return kv.first == name; });
+            if (same) continue;
+
+            std::vector<std::string> merged;
+            merged.reserve(names.size() + row.size());
+            auto it = names.begin();
+            for (const auto& kv : row) {
+                while (it != names.end() && *it < kv.first) merged.push_back(*it++);
+                if (it != names.end() && *it == kv.first) ++it;
+                merged.push_back(kv.first);
             }
+            merged.insert(merged.end(), it, names.end());
+            names.swap(merged);
         }
-        
-        if (!values.empty()) {
-            std::sort(values.begin(), values.end());
-            size_t n = values.size();
-            
-            if (n % 2 == 0) {
-                feature_medians[kv.first] = (values[n/2-1] + values[n/2]) / 2.0;
-            } else {
-                feature_medians[kv.first] = values[n/2];
-            }
-            
-            double q1 = values[n/4];
-            double q3 = values[3*n/4];
-            feature_iqrs[kv.first] = q3 - q1;
-            if (feature_iqrs[kv.first] < 1e-10) feature_iqrs[kv.first] = 1.0;
+        return names;
+    }
+}
+
+FeatureExtractor::RobustScalingParams FeatureExtractor::fitRobustScaling(
+    const std::vector<std::map<std::string, double>>& features
+) {
+    RobustScalingParams params;
+    if (features.empty()) return params;
+    
+    params.feature_names = collectFeatureNames(features);
+    const size_t n_features = params.feature_names.size();
+    
+    std::vector<std::vector<double>> columns(n_features);
+    for (auto& column : columns) column.reserve(features.size());
+    
+    for (const auto& row : features) {
+        size_t j = 0;
+        for (const auto& kv : row) {
+            while (params.feature_names[j] != kv.first) ++j;
+            columns[j].push_back(kv.second);
         }
     }
     
-    for (auto& featureRow : features) {
-        for (auto& kv : featureRow) {
-            kv.second = (kv.second - feature_medians[kv.first]) / feature_iqrs[kv.first];
+    params.medians.assign(n_features, 0.0);
+    params.iqrs.assign(n_features, 0.0);
+    
+    size_t total_values = features.size() * n_features;
+    unsigned max_threads = total_values >= PARALLEL_SCALING_MIN_VALUES ? 0u : 1u;
+    TripleBarrier::Parallel::parallelFor(n_features, max_threads, [&](size_t j) {
+        if (!columns[j].empty()) {
+            robustStatistics(columns[j], params.medians[j], params.iqrs[j]);
+        }
+    });
+    
+    return params;
+}
+
+void FeatureExtractor::applyRobustScaling(
+    std::vector<std::map<std::string, double>>& features,
+    const RobustScalingParams& params
+) {
+    if (features.empty() || params.empty()) return;
+    
+    const auto& names = params.feature_names;
+    for (auto& row : features) {
+        size_t j = 0;
+        for (auto& kv : row) {
+            while (j < names.size() && names[j] < kv.first) ++j;
+            if (j == names.size()) break;
+            if (names[j] == kv.first) {
+                kv.second = (kv.second - params.medians[j]) / params.iqrs[j];
+            }
         }
     }
-}
\ No newline at end of file
+}
+
+FeatureExtractor::RobustScalingParams FeatureExtractor::applyRobustScaling(
+    std::vector<std::map<std::string, double>>& features
+) {
+    RobustScalingParams params = fitRobustScaling(features);
+    applyRobustScaling(features, params);
+    return params;
+}
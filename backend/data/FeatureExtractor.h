@@ -5,17 +5,33 @@
 #include <set>
 #include "PreprocessedRow.h"
 #include "LabeledEvent.h"
+#include "FeatureCalculator.h"
 
 class FeatureExtractor {
 public:
+    // Per-feature median and IQR fitted by robust scaling, stored column-wise and
+    // sorted by feature name so the same transform can be applied to new data.
+    struct RobustScalingParams {
+        std::vector<std::string> feature_names;
+        std::vector<double> medians;
+        std::vector<double> iqrs;
+
+        bool empty() const { return feature_names.empty(); }
+    };
+
     struct FeatureExtractionResult {
         std::vector<std::map<std::string, double>> features;
         std::vector<int> labels;
         std::vector<double> labels_double;
         std::vector<double> returns;
+        RobustScalingParams scaling;
+        // Row positions of each sample's entry and exit bar, for purging overlapping labels.
+        std::vector<int> entry_indices;
+        std::vector<int> exit_indices;
     };
 
     static std::map<std::string, std::string> getFeatureMapping();
+    static std::set<std::string> resolveBackendFeatures(const std::set<std::string>& selectedFeatures);
 
     static FeatureExtractionResult extractFeaturesForClassification(
         const std::set<std::string>& selectedFeatures,
@@ -29,10 +45,26 @@ public:
         const std::vector<LabeledEvent>& labeledEvents
     );
 
+    static RobustScalingParams fitRobustScaling(const std::vector<std::map<std::string, double>>& features);
+    static void applyRobustScaling(std::vector<std::map<std::string, double>>& features, const RobustScalingParams& params);
+    static RobustScalingParams applyRobustScaling(std::vector<std::map<std::string, double>>& features);
+
 private:
     static std::vector<int> findEventIndices(
         const std::vector<PreprocessedRow>& rows,
-        const std::vector<LabeledEvent>& labeledEvents
+        const std::vector<LabeledEvent>& labeledEvents,
+        std::vector<size_t>& matchedEvents
+    );
+
+    // Removes the features that need every event's position and returns them, so they
+    // can be computed for all events in one pass instead of per event.
+    static std::set<std::string> takeEventTimingFeatures(std::set<std::string>& backendFeatures);
+
+    static void addEventTimingFeatures(
+        std::map<std::string, double>& features,
+        const FeatureCalculator::EventTimingFeatures& timing,
+        const std::set<std::string>& timingFeatures,
+        size_t eventIdx
     );
 
     static std::map<std::string, double> enhanceFeatures(
@@ -40,5 +72,4 @@ private:
         const PreprocessedRow& row
     );
 
-    static void applyRobustScaling(std::vector<std::map<std::string, double>>& features);
 };
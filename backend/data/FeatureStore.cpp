@@ -0,0 +1,452 @@
+#include "FeatureStore.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr char MAGIC[4] = {'T', 'B', 'F', 'S'};
+    constexpr uint32_t FORMAT_VERSION = 1;
+
+    constexpr uint32_t FLAG_LABELS_INT = 1u << 0;
+    constexpr uint32_t FLAG_LABELS_DOUBLE = 1u << 1;
+    constexpr uint32_t FLAG_SCALING = 1u << 2;
+    constexpr uint32_t FLAG_SPARSE = 1u << 3;
+    constexpr uint32_t FLAG_EVENT_WINDOWS = 1u << 4;
+
+    // Fixed-size file header; every section after it starts on an 8-byte boundary
+    // so the mapped arrays can be read in place.
+    struct FileHeader {
+        char magic[4];
+        uint32_t format_version;
+        uint64_t key;
+        uint32_t schema_version;
+        uint32_t mode;
+        uint64_t rows;
+        uint64_t feature_count;
+        uint32_t flags;
+        uint32_t reserved;
+        uint64_t names_bytes;
+    };
+    static_assert(sizeof(FileHeader) % 8 == 0, "FileHeader must keep sections 8-byte aligned");
+
+    size_t padTo8(size_t n) { return (n + 7) & ~size_t(7); }
+
+    // 64-bit FNV-1a, fed field by field so the key does not depend on struct layout.
+    class KeyHasher {
+    public:
+        void bytes(const void* data, size_t len) {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < len; ++i) {
+                hash_ ^= p[i];
+                hash_ *= 1099511628211ULL;
+            }
+        }
+        template<typename T>
+        void value(const T& v) { bytes(&v, sizeof(T)); }
+        void string(const std::string& s) {
+            value<uint64_t>(s.size());
+            bytes(s.data(), s.size());
+        }
+        void optional(const std::optional<double>& v) {
+            value<uint8_t>(v.has_value());
+            if (v) value(*v);
+        }
+        uint64_t digest() const { return hash_; }
+
+    private:
+        uint64_t hash_ = 14695981039346656037ULL;
+    };
+
+    std::vector<std::string> columnNames(const std::vector<std::map<std::string, double>>& features, bool& sparse) {
+        std::set<std::string> names;
+        for (const auto& row : features) {
+            for (const auto& kv : row) names.insert(kv.first);
+        }
+        sparse = false;
+        for (const auto& row : features) {
+            if (row.size() != names.size()) {
+                sparse = true;
+                break;
+            }
+        }
+        return std::vector<std::string>(names.begin(), names.end());
+    }
+
+    template<typename T>
+    void writeArray(std::ofstream& out, const T* data, size_t count) {
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+        static const char zeros[8] = {};
+        size_t bytes = count * sizeof(T);
+        out.write(zeros, static_cast<std::streamsize>(padTo8(bytes) - bytes));
+    }
+}
+
+FeatureStore::FeatureStore(std::string directory, uint64_t max_bytes)
+    : directory_(std::move(directory)), max_bytes_(max_bytes) {}
+
+uint64_t FeatureStore::computeKey(
+    Mode mode,
+    const std::set<std::string>& backendFeatures,
+    const std::vector<PreprocessedRow>& rows,
+    const std::vector<LabeledEvent>& labeledEvents
+) {
+    KeyHasher hasher;
+    hasher.value(FORMAT_VERSION);
+    hasher.value(FEATURE_SCHEMA_VERSION);
+    hasher.value(static_cast<uint32_t>(mode));
+
+    // Feature names encode their lookback window (e.g. sma_20d), so the set is the full spec.
+    hasher.value<uint64_t>(backendFeatures.size());
+    for (const auto& name : backendFeatures) hasher.string(name);
+
+    hasher.value<uint64_t>(rows.size());
+    for (const auto& row : rows) {
+        hasher.string(row.timestamp);
+        hasher.value(row.price);
+        hasher.optional(row.open);
+        hasher.optional(row.high);
+        hasher.optional(row.low);
+        hasher.optional(row.close);
+        hasher.optional(row.volume);
+        hasher.value(row.log_return);
+        hasher.value(row.volatility);
+        hasher.value<uint8_t>(row.is_event);
+    }
+
+    hasher.value<uint64_t>(labeledEvents.size());
+    for (const auto& event : labeledEvents) {
+        hasher.string(event.entry_time);
+        hasher.string(event.exit_time);
+        hasher.value(event.entry_index);
+        hasher.value(event.exit_index);
+        hasher.value(event.label);
+        hasher.value(event.ttbm_label);
+        hasher.value(event.entry_price);
+        hasher.value(event.exit_price);
+    }
+    return hasher.digest();
+}
+
+std::string FeatureStore::pathForKey(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.tbfs", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory_) / name).string();
+}
+
+bool FeatureStore::contains(uint64_t key) const {
+    std::error_code ec;
+    return std::filesystem::is_regular_file(pathForKey(key), ec);
+}
+
+std::unique_ptr<FeatureStore::MappedEntry> FeatureStore::open(uint64_t key) const {
+    const std::string path = pathForKey(key);
+    auto entry = MappedEntry::open(path, key);
+    if (entry) {
+        // Recency for eviction is the modification time.
+        std::error_code ec;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    }
+    return entry;
+}
+
+bool FeatureStore::load(uint64_t key, FeatureExtractor::FeatureExtractionResult& result) const {
+    auto entry = open(key);
+    if (!entry) return false;
+    result = entry->toResult();
+    return true;
+}
+
+bool FeatureStore::save(uint64_t key, Mode mode, const FeatureExtractor::FeatureExtractionResult& result) const {
+    const size_t rows = result.features.size();
+    if (result.returns.size() != rows) return false;
+
+    bool sparse = false;
+    std::vector<std::string> names = columnNames(result.features, sparse);
+    const size_t n_features = names.size();
+
+    uint32_t flags = 0;
+    if (!result.labels.empty()) {
+        if (result.labels.size() != rows) return false;
+        flags |= FLAG_LABELS_INT;
+    }
+    if (!result.labels_double.empty()) {
+        if (result.labels_double.size() != rows) return false;
+        flags |= FLAG_LABELS_DOUBLE;
+    }
+    if (!result.scaling.empty() && result.scaling.feature_names == names) flags |= FLAG_SCALING;
+    if (sparse) flags |= FLAG_SPARSE;
+    if (!result.entry_indices.empty()) {
+        if (result.entry_indices.size() != rows || result.exit_indices.size() != rows) return false;
+        flags |= FLAG_EVENT_WINDOWS;
+    }
+
+    std::vector<char> nameBlock;
+    for (const auto& name : names) {
+        uint32_t len = static_cast<uint32_t>(name.size());
+        const char* lenBytes = reinterpret_cast<const char*>(&len);
+        nameBlock.insert(nameBlock.end(), lenBytes, lenBytes + sizeof(len));
+        nameBlock.insert(nameBlock.end(), name.begin(), name.end());
+    }
+
+    std::vector<double> columns(n_features * rows, 0.0);
+    std::vector<uint8_t> presence(sparse ? n_features * rows : 0, 0);
+    for (size_t i = 0; i < rows; ++i) {
+        size_t j = 0;
+        for (const auto& kv : result.features[i]) {
+            while (names[j] != kv.first) ++j;
+            columns[j * rows + i] = kv.second;
+            if (sparse) presence[j * rows + i] = 1;
+        }
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.format_version = FORMAT_VERSION;
+    header.key = key;
+    header.schema_version = FEATURE_SCHEMA_VERSION;
+    header.mode = static_cast<uint32_t>(mode);
+    header.rows = rows;
+    header.feature_count = n_features;
+    header.flags = flags;
+    header.names_bytes = nameBlock.size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) return false;
+
+    const std::string finalPath = pathForKey(key);
+    const std::string tmpPath = finalPath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeArray(out, nameBlock.data(), nameBlock.size());
+        if (flags & FLAG_LABELS_INT) {
+            std::vector<int32_t> labels(result.labels.begin(), result.labels.end());
+            writeArray(out, labels.data(), rows);
+        }
+        if (flags & FLAG_LABELS_DOUBLE) writeArray(out, result.labels_double.data(), rows);
+        writeArray(out, result.returns.data(), rows);
+        if (flags & FLAG_EVENT_WINDOWS) {
+            std::vector<int32_t> entries(result.entry_indices.begin(), result.entry_indices.end());
+            std::vector<int32_t> exits(result.exit_indices.begin(), result.exit_indices.end());
+            writeArray(out, entries.data(), rows);
+            writeArray(out, exits.data(), rows);
+        }
+        writeArray(out, columns.data(), columns.size());
+        if (sparse) writeArray(out, presence.data(), presence.size());
+        if (flags & FLAG_SCALING) {
+            writeArray(out, result.scaling.medians.data(), n_features);
+            writeArray(out, result.scaling.iqrs.data(), n_features);
+        }
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tmpPath, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, finalPath, ec);
+    if (ec) {
+        std::filesystem::remove(finalPath, ec);
+        std::filesystem::rename(tmpPath, finalPath, ec);
+    }
+    if (ec) {
+        std::cerr << "[FeatureStore] Failed to write " << finalPath << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    evict(finalPath);
+    return true;
+}
+
+namespace {
+    struct CacheFile {
+        std::filesystem::path path;
+        uint64_t bytes;
+        std::filesystem::file_time_type used;
+    };
+
+    std::vector<CacheFile> listCacheFiles(const std::string& directory) {
+        std::vector<CacheFile> files;
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path().extension() != ".tbfs") continue;
+            std::error_code fileEc;
+            uint64_t bytes = it->file_size(fileEc);
+            auto used = it->last_write_time(fileEc);
+            if (!fileEc) files.push_back(CacheFile{it->path(), bytes, used});
+        }
+        return files;
+    }
+}
+
+uint64_t FeatureStore::sizeOnDisk() const {
+    uint64_t total = 0;
+    for (const auto& file : listCacheFiles(directory_)) total += file.bytes;
+    return total;
+}
+
+void FeatureStore::evict(const std::string& keepPath) const {
+    if (max_bytes_ == 0) return;
+    auto files = listCacheFiles(directory_);
+    uint64_t total = 0;
+    for (const auto& file : files) total += file.bytes;
+    if (total <= max_bytes_) return;
+
+    std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.used < b.used; });
+    const std::filesystem::path keep(keepPath);
+    for (const auto& file : files) {
+        if (total <= max_bytes_) break;
+        if (file.path == keep) continue;
+        std::error_code ec;
+        if (std::filesystem::remove(file.path, ec)) total -= file.bytes;
+    }
+}
+
+FeatureStore::MappedEntry::~MappedEntry() {
+#ifdef _WIN32
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_handle_) CloseHandle(mapping_handle_);
+    if (file_handle_) CloseHandle(file_handle_);
+#else
+    if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+    if (fd_ >= 0) close(fd_);
+#endif
+}
+
+std::unique_ptr<FeatureStore::MappedEntry> FeatureStore::MappedEntry::open(const std::string& path, uint64_t expectedKey) {
+    std::unique_ptr<MappedEntry> entry(new MappedEntry());
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    entry->file_handle_ = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) return nullptr;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) return nullptr;
+    entry->mapping_handle_ = mapping;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) return nullptr;
+    entry->data_ = static_cast<const unsigned char*>(view);
+    entry->size_ = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    entry->fd_ = fd;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) return nullptr;
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) return nullptr;
+    entry->data_ = static_cast<const unsigned char*>(view);
+    entry->size_ = static_cast<size_t>(st.st_size);
+#endif
+    if (!entry->parse(expectedKey)) return nullptr;
+    return entry;
+}
+
+bool FeatureStore::MappedEntry::parse(uint64_t expectedKey) {
+    FileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.format_version != FORMAT_VERSION ||
+        header.schema_version != FEATURE_SCHEMA_VERSION ||
+        header.key != expectedKey) {
+        return false;
+    }
+
+    const size_t rows = static_cast<size_t>(header.rows);
+    const size_t n_features = static_cast<size_t>(header.feature_count);
+    size_t offset = sizeof(FileHeader);
+    auto take = [&](size_t bytes) -> const unsigned char* {
+        if (offset > size_ || padTo8(bytes) > size_ - offset) return nullptr;
+        const unsigned char* p = data_ + offset;
+        offset += padTo8(bytes);
+        return p;
+    };
+
+    const unsigned char* nameBlock = take(static_cast<size_t>(header.names_bytes));
+    if (!nameBlock) return false;
+    size_t pos = 0;
+    names_.reserve(n_features);
+    for (size_t j = 0; j < n_features; ++j) {
+        uint32_t len;
+        if (pos + sizeof(len) > header.names_bytes) return false;
+        std::memcpy(&len, nameBlock + pos, sizeof(len));
+        pos += sizeof(len);
+        if (pos + len > header.names_bytes) return false;
+        names_.emplace_back(reinterpret_cast<const char*>(nameBlock + pos), len);
+        pos += len;
+    }
+
+    if (header.flags & FLAG_LABELS_INT) {
+        labels_ = reinterpret_cast<const int32_t*>(take(rows * sizeof(int32_t)));
+        if (!labels_) return false;
+    }
+    if (header.flags & FLAG_LABELS_DOUBLE) {
+        labels_double_ = reinterpret_cast<const double*>(take(rows * sizeof(double)));
+        if (!labels_double_) return false;
+    }
+    returns_ = reinterpret_cast<const double*>(take(rows * sizeof(double)));
+    if (header.flags & FLAG_EVENT_WINDOWS) {
+        entry_indices_ = reinterpret_cast<const int32_t*>(take(rows * sizeof(int32_t)));
+        exit_indices_ = reinterpret_cast<const int32_t*>(take(rows * sizeof(int32_t)));
+        if (!entry_indices_ || !exit_indices_) return false;
+    }
+    columns_ = reinterpret_cast<const double*>(take(n_features * rows * sizeof(double)));
+    if (!returns_ || !columns_) return false;
+    if (header.flags & FLAG_SPARSE) {
+        presence_ = take(n_features * rows);
+        if (!presence_) return false;
+    }
+    if (header.flags & FLAG_SCALING) {
+        scaling_medians_ = reinterpret_cast<const double*>(take(n_features * sizeof(double)));
+        scaling_iqrs_ = reinterpret_cast<const double*>(take(n_features * sizeof(double)));
+        if (!scaling_medians_ || !scaling_iqrs_) return false;
+    }
+
+    mode_ = static_cast<Mode>(header.mode);
+    rows_ = rows;
+    return true;
+}
+
+FeatureExtractor::FeatureExtractionResult FeatureStore::MappedEntry::toResult() const {
+    FeatureExtractor::FeatureExtractionResult result;
+    result.features.resize(rows_);
+    for (size_t i = 0; i < rows_; ++i) {
+        auto& row = result.features[i];
+        for (size_t j = 0; j < names_.size(); ++j) {
+            if (present(j, i)) row.emplace_hint(row.end(), names_[j], column(j)[i]);
+        }
+    }
+    if (labels_) result.labels.assign(labels_, labels_ + rows_);
+    if (labels_double_) result.labels_double.assign(labels_double_, labels_double_ + rows_);
+    result.returns.assign(returns_, returns_ + rows_);
+    if (entry_indices_) {
+        result.entry_indices.assign(entry_indices_, entry_indices_ + rows_);
+        result.exit_indices.assign(exit_indices_, exit_indices_ + rows_);
+    }
+    if (hasScaling()) {
+        result.scaling.feature_names = names_;
+        result.scaling.medians.assign(scaling_medians_, scaling_medians_ + names_.size());
+        result.scaling.iqrs.assign(scaling_iqrs_, scaling_iqrs_ + names_.size());
+    }
+    return result;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "FeatureExtractor.h"
+#include "PreprocessedRow.h"
+#include "LabeledEvent.h"
+
+// On-disk cache of extracted feature matrices. Entries are keyed by a content
+// hash of the preprocessed series, the labeled events and the feature spec, and
+// stored column-major in a flat binary file that is memory-mapped on load, so a
+// rerun that only changes model settings skips feature extraction entirely. The
+// directory is capped in size; saving evicts the least recently used entries.
+class FeatureStore {
+public:
+    enum class Mode : uint32_t {
+        CLASSIFICATION = 0,
+        REGRESSION = 1
+    };
+
+    // Bump whenever FeatureCalculator/FeatureExtractor change the values they produce
+    // so stale cache entries stop matching.
+    static constexpr uint32_t FEATURE_SCHEMA_VERSION = 3;
+
+    // Read-only columnar view over one mapped cache file.
+    class MappedEntry {
+    public:
+        ~MappedEntry();
+        MappedEntry(const MappedEntry&) = delete;
+        MappedEntry& operator=(const MappedEntry&) = delete;
+
+        static std::unique_ptr<MappedEntry> open(const std::string& path, uint64_t expectedKey);
+
+        size_t rows() const { return rows_; }
+        size_t featureCount() const { return names_.size(); }
+        const std::vector<std::string>& featureNames() const { return names_; }
+        Mode mode() const { return mode_; }
+
+        // Contiguous values of feature j for every row.
+        const double* column(size_t j) const { return columns_ + j * rows_; }
+        // Whether row i has feature j; regression rows may carry optional features.
+        bool present(size_t j, size_t i) const { return presence_ == nullptr || presence_[j * rows_ + i] != 0; }
+        const int32_t* labels() const { return labels_; }
+        const double* labelsDouble() const { return labels_double_; }
+        const double* returns() const { return returns_; }
+        const int32_t* entryIndices() const { return entry_indices_; }
+        const int32_t* exitIndices() const { return exit_indices_; }
+        bool hasScaling() const { return scaling_medians_ != nullptr; }
+        const double* scalingMedians() const { return scaling_medians_; }
+        const double* scalingIqrs() const { return scaling_iqrs_; }
+
+        FeatureExtractor::FeatureExtractionResult toResult() const;
+
+    private:
+        MappedEntry() = default;
+        bool parse(uint64_t expectedKey);
+
+        const unsigned char* data_ = nullptr;
+        size_t size_ = 0;
+#ifdef _WIN32
+        void* file_handle_ = nullptr;
+        void* mapping_handle_ = nullptr;
+#else
+        int fd_ = -1;
+#endif
+
+        Mode mode_ = Mode::CLASSIFICATION;
+        size_t rows_ = 0;
+        std::vector<std::string> names_;
+        const int32_t* labels_ = nullptr;
+        const double* labels_double_ = nullptr;
+        const double* returns_ = nullptr;
+        const int32_t* entry_indices_ = nullptr;
+        const int32_t* exit_indices_ = nullptr;
+        const double* columns_ = nullptr;
+        const uint8_t* presence_ = nullptr;
+        const double* scaling_medians_ = nullptr;
+        const double* scaling_iqrs_ = nullptr;
+    };
+
+    static constexpr uint64_t DEFAULT_MAX_BYTES = 2ull << 30;
+
+    // max_bytes bounds the total size of the cache files; 0 disables eviction.
+    explicit FeatureStore(std::string directory, uint64_t max_bytes = DEFAULT_MAX_BYTES);
+
+    static uint64_t computeKey(
+        Mode mode,
+        const std::set<std::string>& backendFeatures,
+        const std::vector<PreprocessedRow>& rows,
+        const std::vector<LabeledEvent>& labeledEvents
+    );
+
+    std::string pathForKey(uint64_t key) const;
+    bool contains(uint64_t key) const;
+
+    // Maps the entry for the key and marks it recently used; nullptr when there is no
+    // valid entry (missing, truncated or written by a different format version).
+    // Callers that can consume columns should use this rather than load().
+    std::unique_ptr<MappedEntry> open(uint64_t key) const;
+
+    // Like open(), then rebuilds the per-row feature maps, which costs
+    // O(rows x features) regardless of the mapping.
+    bool load(uint64_t key, FeatureExtractor::FeatureExtractionResult& result) const;
+
+    // Writes atomically via a temporary file, then evicts least recently used entries
+    // until the store fits in max_bytes (never the one just written). Returns false,
+    // leaving the store unchanged, if the file cannot be written.
+    bool save(uint64_t key, Mode mode, const FeatureExtractor::FeatureExtractionResult& result) const;
+
+    // Total size of the cache files currently in the directory.
+    uint64_t sizeOnDisk() const;
+
+    const std::string& directory() const { return directory_; }
+    uint64_t maxBytes() const { return max_bytes_; }
+
+private:
+    void evict(const std::string& keepPath) const;
+
+    std::string directory_;
+    uint64_t max_bytes_;
+};
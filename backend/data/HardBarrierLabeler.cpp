@@ -79,7 +79,9 @@ std::vector<LabeledEvent> HardBarrierLabeler::label(
             pt,
             sl,
             entry.volatility,
-            data[exit_idx].price
+            data[exit_idx].price,
+            static_cast<int>(event_idx),
+            static_cast<int>(exit_idx)
         });
     }
 
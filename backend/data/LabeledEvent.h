@@ -19,4 +19,8 @@ struct LabeledEvent {
     double stop_barrier = 0.0;   
     double entry_volatility = 0.0;
     double trigger_price = 0.0;
+
+    // Row positions of entry/exit in the series the event was labeled from; -1 when unknown.
+    int entry_index = -1;
+    int exit_index = -1;
 };
@@ -109,7 +109,9 @@ std::vector<LabeledEvent> TTBMLabeler::label(
             pt,
             sl,
             entry.volatility,
-            data[exit_idx].price
+            data[exit_idx].price,
+            static_cast<int>(event_idx),
+            static_cast<int>(exit_idx)
         });
     }
     
@@ -1,4 +1,5 @@
 #include "BarrierMLStrategy.h"
+#include "CrossValidation.h"
 #include "MLSplits.h"
 #include "ModelUtils.h"
 #include "MetricsCalculator.h"
@@ -25,6 +26,21 @@ PortfolioSimulation BarrierMLStrategy::runPortfolioSimulation(
     return simulate_portfolio(trading_signals, returns, portfolio_config);
 }
 
+XGBoostConfig BarrierMLStrategy::modelConfig(const TrainingConfig& config) const {
+    XGBoostConfig model_config;
+    model_config.n_rounds = config.n_rounds;
+    model_config.max_depth = config.max_depth;
+    model_config.nthread = config.nthread;
+    model_config.objective = getModelObjective();
+    model_config.learning_rate = config.learning_rate;
+    model_config.subsample = config.subsample;
+    model_config.colsample_bytree = config.colsample_bytree;
+    if (model_config.objective.find("multi:") == 0) {
+        model_config.num_class = 3;
+    }
+    return model_config;
+}
+
 FeatureExtractor::FeatureExtractionResult HardBarrierStrategy::extractFeatures(
     const std::set<std::string>& selectedFeatures,
     const std::vector<PreprocessedRow>& rows,
@@ -80,7 +96,7 @@ BarrierMLStrategy::PredictionResult HardBarrierStrategy::trainAndPredict(
             throw DataProcessingException("No training samples available after split");
         }
         
-        auto X_train = toFloatMatrix(select_rows(X_clean, train_idx));
+        auto X_train = toFlatFloatMatrix(X_clean, train_idx);
         auto y_train = toFloatVecInt(select_rows(y_clean, train_idx));
         
         std::vector<size_t> eval_idx = val_idx.empty() ? test_idx : val_idx;
@@ -88,18 +104,10 @@ BarrierMLStrategy::PredictionResult HardBarrierStrategy::trainAndPredict(
             throw DataProcessingException("No evaluation samples available after split");
         }
         
-        auto X_eval = toFloatMatrix(select_rows(X_clean, eval_idx));
+        auto X_eval = toFlatFloatMatrix(X_clean, eval_idx);
         auto returns_eval = select_rows(returns_clean, eval_idx);
         
-        XGBoostConfig model_config;
-        model_config.n_rounds = config.n_rounds;
-        model_config.max_depth = config.max_depth;
-        model_config.nthread = config.nthread;
-        model_config.objective = getModelObjective();
-        model_config.learning_rate = config.learning_rate;
-        model_config.subsample = config.subsample;
-        model_config.colsample_bytree = config.colsample_bytree;
-        model_config.num_class = 3;
+        XGBoostConfig model_config = modelConfig(config);
         
         if (model_config.n_rounds <= 0) {
             throw HyperparameterException("n_rounds must be positive", "n_rounds");
@@ -110,7 +118,7 @@ BarrierMLStrategy::PredictionResult HardBarrierStrategy::trainAndPredict(
         
         XGBoostModel model;
         try {
-            model.fit(X_train, y_train, model_config);
+            model.fit(X_train.view(), y_train, model_config);
         } catch (const BaseException& e) {
             throw ModelTrainingException("XGBoost training failed: " + std::string(e.what()), e.context());
         } catch (const std::exception& e) {
@@ -121,32 +129,33 @@ BarrierMLStrategy::PredictionResult HardBarrierStrategy::trainAndPredict(
             throw ModelTrainingException("Model training completed but model is not in trained state");
         }
         
-        std::vector<int> y_pred;
-        std::vector<float> y_prob;
+        ClassificationOutput prediction;
         
         try {
-            y_pred = model.predict(X_eval);
-            y_prob = model.predict_proba(X_eval);
+            prediction = model.predict_full(X_eval.view());
         } catch (const BaseException& e) {
             throw ModelPredictionException("XGBoost prediction failed: " + std::string(e.what()), e.context());
         } catch (const std::exception& e) {
             throw ModelPredictionException("XGBoost prediction failed", e.what());
         }
         
-        Validation::validateNotEmpty(y_pred, "predictions");
-        Validation::validateNotEmpty(y_prob, "probabilities");
+        Validation::validateNotEmpty(prediction.labels, "predictions");
+        Validation::validateNotEmpty(prediction.probabilities, "probabilities");
         
-        if (y_pred.size() != eval_idx.size()) {
+        if (prediction.labels.size() != eval_idx.size()) {
             throw ModelPredictionException("Prediction count mismatch", 
                                          "expected: " + std::to_string(eval_idx.size()) + 
-                                         ", got: " + std::to_string(y_pred.size()));
+                                         ", got: " + std::to_string(prediction.labels.size()));
         }
         
-        result.predictions.assign(y_pred.begin(), y_pred.end());
-        result.confidence_scores.assign(y_prob.begin(), y_prob.end());
+        result.predictions.assign(prediction.labels.begin(), prediction.labels.end());
+        result.confidence_scores.reserve(prediction.rows);
+        for (size_t i = 0; i < prediction.rows; ++i) {
+            result.confidence_scores.push_back(prediction.confidence(i));
+        }
         
         try {
-            result.trading_signals = convertClassificationToTradingSignals(y_pred, std::vector<double>(y_prob.begin(), y_prob.end()));
+            result.trading_signals = convertClassificationToTradingSignals(prediction);
             result.portfolio_result = runPortfolioSimulation(result.trading_signals, returns_eval);   
         } catch (const BaseException& e) {
             throw PortfolioException("Portfolio simulation failed: " + std::string(e.what()), e.context());
@@ -170,30 +179,41 @@ BarrierMLStrategy::PredictionResult HardBarrierStrategy::trainAndPredict(
 }
 
 std::vector<double> HardBarrierStrategy::convertClassificationToTradingSignals(
-    const std::vector<int>& predictions,
-    const std::vector<double>& probabilities) {
+    const ClassificationOutput& output) {
+    
+    std::vector<double> direction(output.num_classes, 0.0);
+    for (size_t c = 0; c < output.num_classes; ++c) {
+        float label = output.class_labels[c];
+        direction[c] = label > 0.0f ? 1.0 : (label < 0.0f ? -1.0 : 0.0);
+    }
     
     std::vector<double> signals;
-    signals.reserve(predictions.size());
+    signals.reserve(output.rows);
     
-    for (size_t i = 0; i < predictions.size(); ++i) {
+    for (size_t i = 0; i < output.rows; ++i) {
+        const float* probs = output.row(i);
         double signal = 0.0;
-        
-        int pred = predictions[i];
-        if (pred == 2) {
-            signal = 1.0;
-        } else if (pred == 0) {
-            signal = -1.0;
-        } else {
-            signal = 0.0;
+        for (size_t c = 0; c < output.num_classes; ++c) {
+            signal += direction[c] * probs[c];
         }
-        
         signals.push_back(signal);
     }
     
     return signals;
 }
 
+std::vector<float> HardBarrierStrategy::trainingTargets(
+    const FeatureExtractor::FeatureExtractionResult& features) const {
+    
+    return toFloatVecInt(features.labels);
+}
+
+std::vector<double> HardBarrierStrategy::tradingSignals(
+    const XGBoostModel& model, const DenseMatrixView& X) const {
+    
+    return convertClassificationToTradingSignals(model.predict_full(X));
+}
+
 FeatureExtractor::FeatureExtractionResult TTBMStrategy::extractFeatures(
     const std::set<std::string>& selectedFeatures,
     const std::vector<PreprocessedRow>& rows,
@@ -225,11 +245,11 @@ BarrierMLStrategy::PredictionResult TTBMStrategy::trainAndPredict(
         
         auto [train_idx, val_idx, test_idx] = createTrainValTestSplits(X_clean.size(), config);
         
-        auto X_train = toFloatMatrix(select_rows(X_clean, train_idx));
+        auto X_train = toFlatFloatMatrix(X_clean, train_idx);
         auto y_train = toFloatVecDouble(select_rows(y_clean, train_idx));
         
         std::vector<size_t> eval_idx = val_idx.empty() ? test_idx : val_idx;
-        auto X_eval = toFloatMatrix(select_rows(X_clean, eval_idx));
+        auto X_eval = toFlatFloatMatrix(X_clean, eval_idx);
         auto returns_eval = select_rows(returns_clean, eval_idx);
         
         if (!y_train.empty()) {
@@ -239,19 +259,12 @@ BarrierMLStrategy::PredictionResult TTBMStrategy::trainAndPredict(
             float mean_train = sum_train / y_train.size();
         }
         
-        XGBoostConfig model_config;
-        model_config.n_rounds = config.n_rounds;
-        model_config.max_depth = config.max_depth;
-        model_config.nthread = config.nthread;
-        model_config.objective = getModelObjective();
-        model_config.learning_rate = config.learning_rate;
-        model_config.subsample = config.subsample;
-        model_config.colsample_bytree = config.colsample_bytree;
+        XGBoostConfig model_config = modelConfig(config);
         
         XGBoostModel model;
-        model.fit(X_train, y_train, model_config);
+        model.fit(X_train.view(), y_train, model_config);
         
-       auto y_pred_raw = model.predict_raw(X_eval); 
+       auto y_pred_raw = model.predict_raw(X_eval.view()); 
         
         if (!y_pred_raw.empty()) {
             float min_pred = *std::min_element(y_pred_raw.begin(), y_pred_raw.end());
@@ -281,6 +294,19 @@ BarrierMLStrategy::PredictionResult TTBMStrategy::trainAndPredict(
     return result;
 }
 
+std::vector<float> TTBMStrategy::trainingTargets(
+    const FeatureExtractor::FeatureExtractionResult& features) const {
+    
+    return toFloatVecDouble(features.labels_double);
+}
+
+std::vector<double> TTBMStrategy::tradingSignals(
+    const XGBoostModel& model, const DenseMatrixView& X) const {
+    
+    auto raw = model.predict_raw(X);
+    return convertRegressionToTradingSignals(std::vector<double>(raw.begin(), raw.end()));
+}
+
 std::vector<double> TTBMStrategy::convertRegressionToTradingSignals(
     const std::vector<double>& predictions) {
     
@@ -366,6 +392,83 @@ UnifiedMLPipeline::PipelineResult UnifiedMLPipeline::runPipeline(
     return pipeline_result;
 }
 
+UnifiedMLPipeline::PipelineResult UnifiedMLPipeline::runWalkForward(
+    const std::vector<PreprocessedRow>& rows,
+    const std::vector<LabeledEvent>& labeledEvents,
+    const PipelineConfig& config,
+    const WalkForwardConfig& walk_forward) {
+    
+    PipelineResult pipeline_result;
+    
+    try {
+        auto strategy = BarrierMLStrategyFactory::createStrategy(config.strategy_type);
+        pipeline_result.strategy_name = strategy->getStrategyName();
+        
+        auto features = strategy->extractFeatures(config.selected_features, rows, labeledEvents);
+        std::vector<float> targets = strategy->trainingTargets(features);
+        if (features.features.size() != targets.size() || features.returns.size() != targets.size()) {
+            throw TripleBarrier::DataValidationException("Size mismatch between features, labels and event returns");
+        }
+        
+        if (features.entry_indices.size() != targets.size() || features.exit_indices.size() != targets.size()) {
+            throw TripleBarrier::DataValidationException("Size mismatch between features and event windows");
+        }
+        
+        // Samples stay in event order; dropping non-finite ones keeps every step's
+        // training window strictly before its test block. Each kept sample keeps its
+        // event window so training labels that overlap a test block can be purged.
+        FlatFloatMatrix X = toFlatFloatMatrix(features.features);
+        std::vector<float> y;
+        std::vector<double> returns;
+        std::vector<int> entry_indices, exit_indices;
+        size_t kept = 0;
+        for (size_t i = 0; i < X.rows; ++i) {
+            const float* row = X.values.data() + i * X.cols;
+            bool finite = std::isfinite(targets[i]) && std::isfinite(features.returns[i]);
+            for (size_t j = 0; finite && j < X.cols; ++j) {
+                finite = std::isfinite(row[j]);
+            }
+            if (!finite) continue;
+            std::copy(row, row + X.cols, X.values.begin() + kept * X.cols);
+            y.push_back(targets[i]);
+            returns.push_back(features.returns[i]);
+            entry_indices.push_back(features.entry_indices[i]);
+            exit_indices.push_back(features.exit_indices[i]);
+            ++kept;
+        }
+        X.rows = kept;
+        X.values.resize(kept * X.cols);
+        
+        auto result = runModelWalkForward(
+            X.view(), y, eventWindows(entry_indices, exit_indices), returns,
+            strategy->modelConfig(config.training_config), walk_forward,
+            [&](const XGBoostModel& model, const DenseMatrixView& X_test) {
+                return strategy->tradingSignals(model, X_test);
+            },
+            config.portfolio_config);
+        
+        auto& prediction = pipeline_result.prediction_result;
+        prediction.trading_signals = std::move(result.signals);
+        prediction.portfolio_result = std::move(result.portfolio);
+        prediction.success = true;
+        
+        const auto& portfolio = prediction.portfolio_result;
+        pipeline_result.performance_metrics["total_return"] = portfolio.total_return;
+        pipeline_result.performance_metrics["max_drawdown"] = portfolio.max_drawdown;
+        pipeline_result.performance_metrics["total_trades"] = static_cast<double>(portfolio.total_trades);
+        pipeline_result.performance_metrics["win_rate"] = portfolio.win_rate;
+        pipeline_result.performance_metrics["sharpe"] = result.sharpe;
+        pipeline_result.performance_metrics["walk_forward_steps"] = static_cast<double>(result.steps.size());
+        pipeline_result.success = true;
+        
+    } catch (const std::exception& e) {
+        pipeline_result.error_message = std::string("Walk-forward failed: ") + e.what();
+        pipeline_result.success = false;
+    }
+    
+    return pipeline_result;
+}
+
 std::map<std::string, double> UnifiedMLPipeline::calculatePerformanceMetrics(
     const BarrierMLStrategy::PredictionResult& result,
     const FeatureExtractor::FeatureExtractionResult& features) {
@@ -8,6 +8,7 @@
 #include "../data/PreprocessedRow.h"
 #include "XGBoostModel.h"
 #include "PortfolioSimulator.h"
+#include "WalkForward.h"
 
 namespace MLPipeline {
 
@@ -49,6 +50,16 @@ public:
     virtual std::string getStrategyName() const = 0;
     virtual std::string getModelObjective() const = 0;
     
+    // Per-sample target the strategy's model is fit to.
+    virtual std::vector<float> trainingTargets(
+        const FeatureExtractor::FeatureExtractionResult& features) const = 0;
+    
+    // Trading signals in [-1, 1] for X from a model fit to trainingTargets.
+    virtual std::vector<double> tradingSignals(
+        const XGBoostModel& model, const DenseMatrixView& X) const = 0;
+    
+    XGBoostConfig modelConfig(const TrainingConfig& config) const;
+    
 protected:
     std::tuple<std::vector<size_t>, std::vector<size_t>, std::vector<size_t>> 
     createTrainValTestSplits(size_t data_size, const TrainingConfig& config);
@@ -73,11 +84,15 @@ public:
     
     std::string getStrategyName() const override { return "Hard Barrier"; }
     std::string getModelObjective() const override { return "multi:softprob"; }
-
-private:
-    std::vector<double> convertClassificationToTradingSignals(
-        const std::vector<int>& predictions,
-        const std::vector<double>& probabilities);
+    
+    std::vector<float> trainingTargets(
+        const FeatureExtractor::FeatureExtractionResult& features) const override;
+    std::vector<double> tradingSignals(
+        const XGBoostModel& model, const DenseMatrixView& X) const override;
+    
+    // Expected direction under the predicted distribution, P(label > 0) - P(label < 0):
+    // +-1 for a certain call, near 0 when the classes are balanced.
+    static std::vector<double> convertClassificationToTradingSignals(const ClassificationOutput& output);
 };
 
 class TTBMStrategy : public BarrierMLStrategy {
@@ -94,12 +109,17 @@ public:
     
     std::string getStrategyName() const override { return "TTBM (Time-To-Barrier Meta-Labeling)"; }
     std::string getModelObjective() const override { return "reg:squarederror"; }
+    
+    std::vector<float> trainingTargets(
+        const FeatureExtractor::FeatureExtractionResult& features) const override;
+    std::vector<double> tradingSignals(
+        const XGBoostModel& model, const DenseMatrixView& X) const override;
 
 private:
-    std::vector<double> convertRegressionToTradingSignals(
+    static std::vector<double> convertRegressionToTradingSignals(
         const std::vector<double>& predictions);
     
-    std::vector<double> normalizeToTradingRange(
+    static std::vector<double> normalizeToTradingRange(
         const std::vector<double>& raw_predictions);
 };
 
@@ -137,6 +157,15 @@ public:
         const std::vector<PreprocessedRow>& rows,
         const std::vector<LabeledEvent>& labeledEvents,
         const PipelineConfig& config);
+    
+    // Walk-forward backtest of the configured strategy over the labeled events: each
+    // step's model trades only the events after its training window, and the stitched
+    // out-of-sample signals are simulated as one portfolio on the event returns.
+    static PipelineResult runWalkForward(
+        const std::vector<PreprocessedRow>& rows,
+        const std::vector<LabeledEvent>& labeledEvents,
+        const PipelineConfig& config,
+        const WalkForwardConfig& walk_forward);
 
 private:
     static std::map<std::string, double> calculatePerformanceMetrics(
@@ -0,0 +1,124 @@
+#include "CombinatorialPurgedCV.h"
+#include "BarrierMLStrategy.h"
+#include "TrainingDataset.h"
+#include "../utils/ParallelUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace MLPipeline {
+
+CombinatorialBacktestResult runCombinatorialBacktest(
+    const std::vector<MLSplitUtils::CombinatorialSplit>& splits,
+    int n_groups,
+    const std::vector<double>& returns,
+    const CoreBudget& budget,
+    const SignalPredictor& predict,
+    const PortfolioConfig& portfolio
+) {
+    CombinatorialBacktestResult result;
+    result.splits = splits;
+    auto groups = MLSplitUtils::contiguousGroups(returns.size(), n_groups);
+    auto paths = MLSplitUtils::combinatorialPaths(splits, n_groups);
+
+    std::vector<std::vector<double>> split_signals(splits.size());
+    TripleBarrier::Parallel::parallelFor(splits.size(), static_cast<unsigned>(budget.jobs), [&](size_t s) {
+        const auto& fold = splits[s].fold;
+        if (fold.train.empty()) {
+            throw std::runtime_error("Purging left no training samples");
+        }
+        split_signals[s] = predict(fold.train, fold.val, budget.threads_per_job);
+        const size_t expected = MLSplitUtils::rangeCount(fold.val);
+        if (split_signals[s].size() != expected) {
+            throw std::runtime_error("Predictor returned " + std::to_string(split_signals[s].size()) +
+                                     " signals for " + std::to_string(expected) + " rows");
+        }
+    });
+
+    result.paths.reserve(paths.size());
+    for (const auto& path_splits : paths) {
+        BacktestPath path;
+        path.splits = path_splits;
+        path.signals.resize(returns.size(), 0.0);
+        for (size_t g = 0; g < groups.size(); ++g) {
+            const size_t s = path_splits[g];
+            const std::vector<double>& signals = split_signals[s];
+            size_t offset = MLSplitUtils::rankInRanges(splits[s].fold.val, groups[g].begin);
+            std::copy(signals.begin() + offset, signals.begin() + offset + groups[g].size(),
+                      path.signals.begin() + groups[g].begin);
+        }
+        path.portfolio = simulate_portfolio(path.signals, returns, portfolio);
+        path.sharpe = path.portfolio.sharpe;
+        result.path_sharpes.push_back(path.sharpe);
+        result.paths.push_back(std::move(path));
+    }
+
+    if (!result.path_sharpes.empty()) {
+        double sum = 0.0;
+        for (double s : result.path_sharpes) sum += s;
+        result.mean_sharpe = sum / result.path_sharpes.size();
+        if (result.path_sharpes.size() > 1) {
+            double sq = 0.0;
+            for (double s : result.path_sharpes) sq += (s - result.mean_sharpe) * (s - result.mean_sharpe);
+            result.std_sharpe = std::sqrt(sq / (result.path_sharpes.size() - 1));
+        }
+    }
+    return result;
+}
+
+CombinatorialBacktestResult runCombinatorialPurgedCV(
+    const DenseMatrixView& X,
+    const std::vector<float>& y,
+    const std::vector<double>& returns,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const CombinatorialCVConfig& config
+) {
+    if (X.empty()) {
+        throw std::invalid_argument("Input feature matrix cannot be empty");
+    }
+    if (X.rows != y.size() || X.rows != returns.size() || X.rows != windows.size()) {
+        throw std::invalid_argument("Features, labels, returns and event windows must have the same number of rows");
+    }
+
+    auto splits = MLSplitUtils::combinatorialPurgedSplit(windows, config.n_groups, config.n_test_groups,
+                                                         config.embargo_bars);
+    CoreBudget budget = planCoreBudget(splits.size(), config.jobs, config.model.nthread,
+                                       TripleBarrier::Parallel::hardwareThreads());
+    const bool classification = isClassificationObjective(config.model.objective);
+
+    auto predict = [&](const MLSplitUtils::RangeList& train_rows, const MLSplitUtils::RangeList& predict_rows,
+                       int nthread) {
+        std::vector<float> y_train = MLSplitUtils::selectRanges(y, train_rows);
+
+        XGBoostConfig model_config = config.model;
+        model_config.nthread = nthread;
+        model_config.early_stopping_rounds = 0;
+
+        TrainingDataset::Options options;
+        options.use_quantile = config.use_quantile_dmatrix;
+        options.max_bin = config.max_bin;
+        options.nthread = nthread;
+        TrainingDataset train_data(MLSplitUtils::RowRangeView(X, train_rows), y_train,
+                                   model_config.objective, options);
+        XGBoostModel model;
+        model.fit(train_data, model_config);
+
+        // Each test group is predicted as a view into X.
+        MLSplitUtils::RowRangeView test(X, predict_rows);
+        std::vector<double> signals;
+        for (size_t k = 0; k < test.blocks(); ++k) {
+            if (classification) {
+                auto block = HardBarrierStrategy::convertClassificationToTradingSignals(model.predict_full(test.block(k)));
+                signals.insert(signals.end(), block.begin(), block.end());
+            } else {
+                auto raw = model.predict_raw(test.block(k));
+                signals.insert(signals.end(), raw.begin(), raw.end());
+            }
+        }
+        return signals;
+    };
+
+    return runCombinatorialBacktest(splits, config.n_groups, returns, budget, predict, config.portfolio);
+}
+
+}
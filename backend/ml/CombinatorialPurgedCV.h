@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "DenseMatrix.h"
+#include "HyperparameterSearch.h"
+#include "MLSplits.h"
+#include "PortfolioSimulator.h"
+#include "XGBoostModel.h"
+
+namespace MLPipeline {
+
+struct CombinatorialCVConfig {
+    int n_groups = 6;
+    int n_test_groups = 2;
+    size_t embargo_bars = 0;
+    int jobs = 0;  // concurrent fits; 0 splits the cores into jobs of model.nthread each
+    bool use_quantile_dmatrix = true;  // fits sketch the training blocks in place instead of copying them
+    int max_bin = 256;
+    XGBoostConfig model;
+    PortfolioConfig portfolio;
+};
+
+// One complete out-of-sample history: every group predicted by a model that never saw it.
+struct BacktestPath {
+    std::vector<size_t> splits;   // split whose predictions cover each group
+    std::vector<double> signals;  // one per sample
+    PortfolioSimulation portfolio;
+    double sharpe = 0.0;          // per-event Sharpe ratio of the path's returns
+};
+
+struct CombinatorialBacktestResult {
+    std::vector<MLSplitUtils::CombinatorialSplit> splits;
+    std::vector<BacktestPath> paths;
+    std::vector<double> path_sharpes;
+    double mean_sharpe = 0.0;
+    double std_sharpe = 0.0;
+};
+
+// Trains on train_rows and returns one trading signal per row of predict_rows, in order.
+using SignalPredictor = std::function<std::vector<double>(const MLSplitUtils::RangeList& train_rows,
+                                                          const MLSplitUtils::RangeList& predict_rows,
+                                                          int nthread)>;
+
+// Fits one model per split concurrently under the core budget, each predicting the
+// samples its split tests, then reassembles the predictions into backtest paths and
+// simulates each path on returns. A failed fit is rethrown.
+CombinatorialBacktestResult runCombinatorialBacktest(
+    const std::vector<MLSplitUtils::CombinatorialSplit>& splits,
+    int n_groups,
+    const std::vector<double>& returns,
+    const CoreBudget& budget,
+    const SignalPredictor& predict,
+    const PortfolioConfig& portfolio = PortfolioConfig{}
+);
+
+// Combinatorial purged CV of config.model on event-ordered samples. Classifiers trade
+// P(up) - P(down), regressors their prediction, as the barrier strategies do.
+CombinatorialBacktestResult runCombinatorialPurgedCV(
+    const DenseMatrixView& X,
+    const std::vector<float>& y,
+    const std::vector<double>& returns,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const CombinatorialCVConfig& config
+);
+
+}
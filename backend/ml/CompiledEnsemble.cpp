@@ -0,0 +1,388 @@
+#include "CompiledEnsemble.h"
+#include "XGBoostModel.h"
+#include "../utils/Exceptions.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace MLPipeline {
+
+namespace {
+    using TripleBarrier::ModelPredictionException;
+
+    // Just enough JSON for XGBoost tree dumps: objects, arrays, numbers and strings.
+    struct JsonValue {
+        enum class Type { NUL, NUMBER, STRING, BOOL, ARRAY, OBJECT };
+        Type type = Type::NUL;
+        double number = 0.0;
+        std::string text;
+        std::vector<JsonValue> items;
+        std::vector<std::pair<std::string, JsonValue>> members;
+
+        const JsonValue* find(const char* key) const {
+            for (const auto& member : members) {
+                if (member.first == key) return &member.second;
+            }
+            return nullptr;
+        }
+    };
+
+    class JsonParser {
+    public:
+        explicit JsonParser(const std::string& text) : text_(text) {}
+
+        JsonValue parse() {
+            JsonValue value = parseValue();
+            skipSpace();
+            if (pos_ != text_.size()) fail("trailing characters");
+            return value;
+        }
+
+    private:
+        const std::string& text_;
+        size_t pos_ = 0;
+
+        [[noreturn]] void fail(const std::string& what) const {
+            throw ModelPredictionException("invalid tree dump (" + what + " at offset " +
+                                           std::to_string(pos_) + ")", "CompiledEnsemble");
+        }
+
+        void skipSpace() {
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        }
+
+        bool consume(char c) {
+            skipSpace();
+            if (pos_ < text_.size() && text_[pos_] == c) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c) {
+            if (!consume(c)) fail(std::string("expected '") + c + "'");
+        }
+
+        std::string parseString() {
+            expect('"');
+            std::string out;
+            while (pos_ < text_.size() && text_[pos_] != '"') {
+                if (text_[pos_] == '\\' && pos_ + 1 < text_.size()) ++pos_;
+                out += text_[pos_++];
+            }
+            if (pos_ >= text_.size()) fail("unterminated string");
+            ++pos_;
+            return out;
+        }
+
+        JsonValue parseValue() {
+            skipSpace();
+            if (pos_ >= text_.size()) fail("unexpected end");
+
+            JsonValue value;
+            char c = text_[pos_];
+            if (c == '{') {
+                ++pos_;
+                value.type = JsonValue::Type::OBJECT;
+                if (consume('}')) return value;
+                do {
+                    std::string key = parseString();
+                    expect(':');
+                    value.members.emplace_back(std::move(key), parseValue());
+                } while (consume(','));
+                expect('}');
+            } else if (c == '[') {
+                ++pos_;
+                value.type = JsonValue::Type::ARRAY;
+                if (consume(']')) return value;
+                do {
+                    value.items.push_back(parseValue());
+                } while (consume(','));
+                expect(']');
+            } else if (c == '"') {
+                value.type = JsonValue::Type::STRING;
+                value.text = parseString();
+            } else if (text_.compare(pos_, 4, "true") == 0 || text_.compare(pos_, 5, "false") == 0) {
+                value.type = JsonValue::Type::BOOL;
+                value.number = text_[pos_] == 't' ? 1.0 : 0.0;
+                pos_ += text_[pos_] == 't' ? 4 : 5;
+            } else if (text_.compare(pos_, 4, "null") == 0) {
+                pos_ += 4;
+            } else {
+                const char* begin = text_.c_str() + pos_;
+                char* end = nullptr;
+                value.type = JsonValue::Type::NUMBER;
+                value.number = std::strtod(begin, &end);
+                if (end == begin) fail("unexpected character");
+                pos_ += static_cast<size_t>(end - begin);
+            }
+            return value;
+        }
+    };
+
+    const JsonValue& requireField(const JsonValue& node, const char* key) {
+        const JsonValue* value = node.find(key);
+        if (!value) {
+            throw ModelPredictionException(std::string("tree node without \"") + key + "\"", "CompiledEnsemble");
+        }
+        return *value;
+    }
+
+    int32_t requireInt(const JsonValue& node, const char* key) {
+        const JsonValue& value = requireField(node, key);
+        if (value.type != JsonValue::Type::NUMBER) {
+            throw ModelPredictionException(std::string("\"") + key + "\" is not a number", "CompiledEnsemble");
+        }
+        return static_cast<int32_t>(value.number);
+    }
+
+    // "f12" when the booster has no feature names, a bare index otherwise.
+    int32_t parseFeatureIndex(const JsonValue& split) {
+        std::string name = split.type == JsonValue::Type::NUMBER
+            ? std::to_string(static_cast<long long>(split.number)) : split.text;
+        size_t start = (!name.empty() && name[0] == 'f') ? 1 : 0;
+        char* end = nullptr;
+        long index = std::strtol(name.c_str() + start, &end, 10);
+        if (name.size() <= start || end == name.c_str() + start || *end != '\0' || index < 0) {
+            throw ModelPredictionException("unsupported split feature \"" + name +
+                                           "\" (compile before setting booster feature names)", "CompiledEnsemble");
+        }
+        return static_cast<int32_t>(index);
+    }
+
+    void collectNodes(const JsonValue& node, int depth, std::vector<std::pair<const JsonValue*, int>>& nodes) {
+        nodes.emplace_back(&node, depth);
+        if (const JsonValue* children = node.find("children")) {
+            for (const auto& child : children->items) collectNodes(child, depth + 1, nodes);
+        }
+    }
+}
+
+CompiledEnsemble::Link CompiledEnsemble::linkForObjective(const std::string& objective) {
+    if (objective == "binary:logistic" || objective == "reg:logistic") return Link::LOGISTIC;
+    if (objective == "multi:softprob") return Link::SOFTMAX_PROB;
+    if (objective == "multi:softmax") return Link::SOFTMAX_CLASS;
+    if (objective == "count:poisson" || objective == "reg:gamma" || objective == "reg:tweedie") return Link::EXP;
+    if (objective == "reg:squarederror" || objective == "reg:linear" || objective == "reg:squaredlogerror" ||
+        objective == "reg:pseudohubererror" || objective == "reg:absoluteerror" ||
+        objective == "reg:quantileerror" || objective == "binary:logitraw") {
+        return Link::IDENTITY;
+    }
+    throw ModelPredictionException("objective " + objective + " cannot be compiled", "CompiledEnsemble");
+}
+
+CompiledEnsemble CompiledEnsemble::fromJsonDump(const std::vector<std::string>& trees, size_t num_features,
+                                                const std::string& objective, const std::vector<float>& base_margins,
+                                                float missing) {
+    if (base_margins.empty()) {
+        throw ModelPredictionException("at least one output group is required", "CompiledEnsemble");
+    }
+    if (num_features == 0) {
+        throw ModelPredictionException("compiled ensemble needs at least one feature", "CompiledEnsemble");
+    }
+
+    CompiledEnsemble ensemble;
+    ensemble.link_ = linkForObjective(objective);
+    ensemble.base_margin_ = base_margins;
+    ensemble.num_features_ = num_features;
+    ensemble.missing_value_ = missing;
+
+    const int groups = static_cast<int>(base_margins.size());
+    for (size_t t = 0; t < trees.size(); ++t) {
+        ensemble.appendTree(trees[t], static_cast<int>(t % groups));
+    }
+    return ensemble;
+}
+
+void CompiledEnsemble::appendTree(const std::string& dump, int group) {
+    JsonValue root = JsonParser(dump).parse();
+    if (root.type != JsonValue::Type::OBJECT) {
+        throw ModelPredictionException("tree dump is not a JSON object", "CompiledEnsemble");
+    }
+
+    std::vector<std::pair<const JsonValue*, int>> nodes;
+    collectNodes(root, 0, nodes);
+
+    // Dumps list children nested; node ids index the flat table relative to the root.
+    const int32_t offset = static_cast<int32_t>(feature_.size());
+    std::unordered_map<int32_t, int32_t> slot;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        int32_t id = requireInt(*nodes[i].first, "nodeid");
+        if (!slot.emplace(id, offset + static_cast<int32_t>(i)).second) {
+            throw ModelPredictionException("duplicate node id " + std::to_string(id), "CompiledEnsemble");
+        }
+    }
+    auto resolve = [&](int32_t id) {
+        auto it = slot.find(id);
+        if (it == slot.end()) {
+            throw ModelPredictionException("child node " + std::to_string(id) + " is missing", "CompiledEnsemble");
+        }
+        return it->second;
+    };
+
+    int depth = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const JsonValue& node = *nodes[i].first;
+        const int32_t self = offset + static_cast<int32_t>(i);
+
+        if (const JsonValue* leaf = node.find("leaf")) {
+            feature_.push_back(0);
+            threshold_.push_back(0.0f);
+            yes_.push_back(self);
+            no_.push_back(self);
+            missing_.push_back(self);
+            leaf_value_.push_back(static_cast<float>(leaf->number));
+            continue;
+        }
+
+        if (node.find("categories")) {
+            throw ModelPredictionException("categorical splits are not supported", "CompiledEnsemble");
+        }
+        int32_t feature = parseFeatureIndex(requireField(node, "split"));
+        if (static_cast<size_t>(feature) >= num_features_) {
+            throw ModelPredictionException("split on feature " + std::to_string(feature) + " but the model has " +
+                                           std::to_string(num_features_) + " features", "CompiledEnsemble");
+        }
+        feature_.push_back(feature);
+        threshold_.push_back(static_cast<float>(requireField(node, "split_condition").number));
+        yes_.push_back(resolve(requireInt(node, "yes")));
+        no_.push_back(resolve(requireInt(node, "no")));
+        missing_.push_back(resolve(requireInt(node, "missing")));
+        leaf_value_.push_back(0.0f);
+        depth = std::max(depth, nodes[i].second + 1);
+    }
+
+    tree_root_.push_back(resolve(requireInt(root, "nodeid")));
+    tree_depth_.push_back(depth);
+    tree_group_.push_back(group);
+}
+
+CompiledEnsemble CompiledEnsemble::compile(const XGBoostModel& model) {
+    if (!model.is_trained()) {
+        throw ModelPredictionException("model must be trained before it can be compiled", "CompiledEnsemble");
+    }
+
+    const int groups = model.num_output_groups();
+    const size_t used_trees = static_cast<size_t>(model.prediction_rounds()) * static_cast<size_t>(groups);
+    std::vector<std::string> dumps = model.dump_trees_json();
+    if (dumps.size() < used_trees) {
+        throw ModelPredictionException("model dump has " + std::to_string(dumps.size()) + " trees, expected " +
+                                       std::to_string(used_trees), "CompiledEnsemble");
+    }
+    dumps.resize(used_trees);
+
+    const size_t n_features = static_cast<size_t>(model.get_num_features());
+    CompiledEnsemble ensemble = fromJsonDump(dumps, n_features, model.get_config().objective,
+                                             std::vector<float>(groups, 0.0f));
+
+    // The dump carries no base score; recover it per group from one margin prediction.
+    std::vector<float> probe(n_features, 0.0f);
+    DenseMatrixView probe_view(probe.data(), 1, n_features);
+    std::vector<float> reference = model.predict_margin(probe_view);
+    std::vector<float> compiled = ensemble.predict_margin(probe_view);
+    if (reference.size() != compiled.size()) {
+        throw ModelPredictionException("margin output shape does not match the compiled ensemble", "CompiledEnsemble");
+    }
+    for (int g = 0; g < groups; ++g) {
+        ensemble.base_margin_[g] = reference[g] - compiled[g];
+    }
+    return ensemble;
+}
+
+void CompiledEnsemble::predict_margin(const DenseMatrixView& X, float* out) const {
+    if (X.rows > 0 && X.cols != num_features_) {
+        throw std::invalid_argument("Input feature dimensions do not match compiled dimensions. Expected: " +
+                                    std::to_string(num_features_) + ", got: " + std::to_string(X.cols));
+    }
+
+    constexpr size_t BLOCK = 16;
+    const size_t groups = base_margin_.size();
+    const int32_t* feature = feature_.data();
+    const float* threshold = threshold_.data();
+    const int32_t* yes = yes_.data();
+    const int32_t* no = no_.data();
+    const int32_t* missing = missing_.data();
+    const float* leaf_value = leaf_value_.data();
+    const float missing_value = missing_value_;
+
+    for (size_t begin = 0; begin < X.rows; begin += BLOCK) {
+        const size_t n = std::min(BLOCK, X.rows - begin);
+        const float* rows[BLOCK];
+        for (size_t r = 0; r < n; ++r) {
+            rows[r] = X.row(begin + r);
+            float* row_out = out + (begin + r) * groups;
+            for (size_t g = 0; g < groups; ++g) row_out[g] = base_margin_[g];
+        }
+
+        int32_t node[BLOCK];
+        for (size_t t = 0; t < tree_root_.size(); ++t) {
+            const int32_t root = tree_root_[t];
+            for (size_t r = 0; r < n; ++r) node[r] = root;
+
+            for (int32_t d = 0; d < tree_depth_[t]; ++d) {
+                for (size_t r = 0; r < n; ++r) {
+                    const int32_t k = node[r];
+                    const float x = rows[r][feature[k]];
+                    const bool is_missing = std::isnan(x) || x == missing_value;
+                    const int32_t next = x < threshold[k] ? yes[k] : no[k];
+                    node[r] = is_missing ? missing[k] : next;
+                }
+            }
+
+            const size_t group = static_cast<size_t>(tree_group_[t]);
+            for (size_t r = 0; r < n; ++r) {
+                out[(begin + r) * groups + group] += leaf_value[node[r]];
+            }
+        }
+    }
+}
+
+std::vector<float> CompiledEnsemble::predict_margin(const DenseMatrixView& X) const {
+    std::vector<float> margins(X.rows * base_margin_.size());
+    predict_margin(X, margins.data());
+    return margins;
+}
+
+std::vector<float> CompiledEnsemble::predict_raw(const DenseMatrixView& X) const {
+    std::vector<float> margins = predict_margin(X);
+    const size_t groups = base_margin_.size();
+
+    switch (link_) {
+        case Link::IDENTITY:
+            return margins;
+        case Link::LOGISTIC:
+            for (float& m : margins) m = 1.0f / (1.0f + std::exp(-m));
+            return margins;
+        case Link::EXP:
+            for (float& m : margins) m = std::exp(m);
+            return margins;
+        case Link::SOFTMAX_PROB:
+            for (size_t i = 0; i < X.rows; ++i) {
+                float* row = margins.data() + i * groups;
+                float max_margin = *std::max_element(row, row + groups);
+                float total = 0.0f;
+                for (size_t g = 0; g < groups; ++g) {
+                    row[g] = std::exp(row[g] - max_margin);
+                    total += row[g];
+                }
+                for (size_t g = 0; g < groups; ++g) row[g] /= total;
+            }
+            return margins;
+        case Link::SOFTMAX_CLASS: {
+            std::vector<float> classes(X.rows);
+            for (size_t i = 0; i < X.rows; ++i) {
+                const float* row = margins.data() + i * groups;
+                classes[i] = static_cast<float>(std::max_element(row, row + groups) - row);
+            }
+            return classes;
+        }
+    }
+    return margins;
+}
+
+}
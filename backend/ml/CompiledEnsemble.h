@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DenseMatrix.h"
+
+namespace MLPipeline {
+
+class XGBoostModel;
+
+// A trained ensemble flattened into structure-of-arrays node tables and evaluated
+// without the XGBoost runtime. Leaves point back at themselves, so every row walks a
+// tree for exactly the tree's depth and a block of rows advances in lockstep without
+// data-dependent branches.
+class CompiledEnsemble {
+public:
+    enum class Link {
+        IDENTITY,       // regression, binary:logitraw
+        LOGISTIC,       // binary:logistic, reg:logistic
+        SOFTMAX_PROB,   // multi:softprob
+        SOFTMAX_CLASS,  // multi:softmax (index of the largest margin)
+        EXP             // count:poisson, reg:gamma, reg:tweedie
+    };
+
+    // Compiles the trees the model predicts with. Base margins are calibrated against
+    // the model's own margin output, so predict_raw matches XGBoostModel::predict_raw.
+    static CompiledEnsemble compile(const XGBoostModel& model);
+
+    // Trees are XGBoosterDumpModelEx JSON dumps in boosting order; tree i adds to output
+    // group i % base_margins.size(). Values equal to `missing` (or NaN) take the
+    // missing branch, as they do in a DMatrix built with that missing value.
+    static CompiledEnsemble fromJsonDump(const std::vector<std::string>& trees, size_t num_features,
+                                         const std::string& objective, const std::vector<float>& base_margins,
+                                         float missing = -1.0f);
+
+    static Link linkForObjective(const std::string& objective);
+
+    // Same layout as XGBoostModel::predict_raw: num_groups() values per row for
+    // multi:softprob, one otherwise.
+    std::vector<float> predict_raw(const DenseMatrixView& X) const;
+
+    // Row-major margins, num_groups() per row; out must hold X.rows * num_groups() floats.
+    void predict_margin(const DenseMatrixView& X, float* out) const;
+    std::vector<float> predict_margin(const DenseMatrixView& X) const;
+
+    size_t num_trees() const { return tree_root_.size(); }
+    size_t num_nodes() const { return feature_.size(); }
+    size_t num_features() const { return num_features_; }
+    int num_groups() const { return static_cast<int>(base_margin_.size()); }
+    Link link() const { return link_; }
+
+private:
+    void appendTree(const std::string& dump, int group);
+
+    std::vector<int32_t> feature_;     // split feature, 0 for leaves
+    std::vector<float> threshold_;     // values below the threshold go to yes_
+    std::vector<int32_t> yes_;
+    std::vector<int32_t> no_;
+    std::vector<int32_t> missing_;
+    std::vector<float> leaf_value_;    // 0 for internal nodes
+
+    std::vector<int32_t> tree_root_;
+    std::vector<int32_t> tree_depth_;
+    std::vector<int32_t> tree_group_;
+
+    std::vector<float> base_margin_;
+    size_t num_features_ = 0;
+    float missing_value_ = -1.0f;
+    Link link_ = Link::IDENTITY;
+};
+
+}
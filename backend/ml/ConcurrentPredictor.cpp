@@ -0,0 +1,67 @@
+#include "ConcurrentPredictor.h"
+#include "../utils/Exceptions.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace MLPipeline {
+
+ConcurrentPredictor::ConcurrentPredictor(std::shared_ptr<const XGBoostModel> model)
+    : model_(std::move(model)) {
+    if (!model_ || !model_->is_trained()) {
+        throw TripleBarrier::ModelPredictionException("concurrent predictor needs a trained model",
+                                                      "ConcurrentPredictor");
+    }
+    num_features_ = static_cast<size_t>(model_->get_num_features());
+
+    std::vector<float> probe(num_features_, 0.0f);
+    model_->predict_batch_inplace(DenseMatrixView(probe.data(), 1, num_features_));
+}
+
+void ConcurrentPredictor::validate(const DenseMatrixView& X) const {
+    if (X.empty()) {
+        throw std::invalid_argument("Input feature matrix cannot be empty");
+    }
+    if (X.cols != num_features_) {
+        throw std::invalid_argument("Input feature dimensions do not match training dimensions. Expected: " +
+                                    std::to_string(num_features_) + ", got: " + std::to_string(X.cols));
+    }
+}
+
+const std::vector<float>& ConcurrentPredictor::predict_raw(const DenseMatrixView& X, Context& context) const {
+    validate(X);
+    const std::vector<float>& raw = model_->predict_batch_inplace(X);
+    context.raw.assign(raw.begin(), raw.end());
+    return context.raw;
+}
+
+const std::vector<int>& ConcurrentPredictor::predict(const DenseMatrixView& X, Context& context) const {
+    validate(X);
+    const std::vector<float>& raw = model_->predict_batch_inplace(X);
+    const size_t stride = static_cast<size_t>(model_->raw_outputs_per_row());
+
+    context.labels.resize(X.rows);
+    for (size_t i = 0; i < X.rows; ++i) {
+        context.labels[i] = model_->prediction_from_raw_row(raw.data() + i * stride);
+    }
+    return context.labels;
+}
+
+int ConcurrentPredictor::predict_one(const float* features) const {
+    return model_->predict_one(features);
+}
+
+ConcurrentPredictor::Context& ConcurrentPredictor::threadContext() {
+    thread_local Context context;
+    return context;
+}
+
+const std::vector<float>& ConcurrentPredictor::predict_raw(const DenseMatrixView& X) const {
+    return predict_raw(X, threadContext());
+}
+
+const std::vector<int>& ConcurrentPredictor::predict(const DenseMatrixView& X) const {
+    return predict(X, threadContext());
+}
+
+}
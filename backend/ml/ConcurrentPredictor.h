@@ -0,0 +1,48 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "DenseMatrix.h"
+#include "XGBoostModel.h"
+
+namespace MLPipeline {
+
+// Scores against one trained model from many threads at once (e.g. one per symbol)
+// without a global lock. Every call goes through XGBoost's in-place prediction, which
+// is safe to run concurrently on a single booster, and results land in a per-thread
+// Context instead of shared state. The model must not be retrained, loaded into or
+// destroyed while a predictor holds it; sharing it as const makes that explicit.
+class ConcurrentPredictor {
+public:
+    // Output buffers reused across calls by one thread. Not shared between threads.
+    struct Context {
+        std::vector<float> raw;
+        std::vector<int> labels;
+    };
+
+    // Runs one warm-up prediction so XGBoost finishes configuring the booster before
+    // any concurrent call can race on it.
+    explicit ConcurrentPredictor(std::shared_ptr<const XGBoostModel> model);
+
+    // Raw output for X (raw_outputs_per_row() values per row), written to context.raw.
+    const std::vector<float>& predict_raw(const DenseMatrixView& X, Context& context) const;
+    // Decoded labels for X, written to context.labels.
+    const std::vector<int>& predict(const DenseMatrixView& X, Context& context) const;
+    int predict_one(const float* features) const;
+
+    // Same as above with a context owned by the calling thread.
+    const std::vector<float>& predict_raw(const DenseMatrixView& X) const;
+    const std::vector<int>& predict(const DenseMatrixView& X) const;
+
+    size_t num_features() const { return num_features_; }
+    int raw_outputs_per_row() const { return model_->raw_outputs_per_row(); }
+    const XGBoostModel& model() const { return *model_; }
+
+private:
+    void validate(const DenseMatrixView& X) const;
+    static Context& threadContext();
+
+    std::shared_ptr<const XGBoostModel> model_;
+    size_t num_features_ = 0;
+};
+
+}
@@ -0,0 +1,185 @@
+#include "CrossValidation.h"
+#include "MetricsCalculator.h"
+#include "TrainingDataset.h"
+#include "../utils/ParallelUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace MLPipeline {
+
+namespace {
+    FoldScore scoreClassification(const std::vector<float>& y_true_f, const std::vector<int>& y_pred) {
+        std::vector<int> y_true(y_true_f.size());
+        bool binary = true;
+        for (size_t i = 0; i < y_true_f.size(); ++i) {
+            y_true[i] = static_cast<int>(std::lround(y_true_f[i]));
+            binary = binary && (y_true[i] == 0 || y_true[i] == 1) && (y_pred[i] == 0 || y_pred[i] == 1);
+        }
+        FoldScore result;
+        result.metrics["accuracy"] = MetricsCalculator::calculateAccuracy(y_true, y_pred);
+        if (binary) {
+            result.metrics["f1"] = MetricsCalculator::calculateF1Score(y_true, y_pred);
+        }
+        result.score = binary ? result.metrics["f1"] : result.metrics["accuracy"];
+        return result;
+    }
+
+    FoldScore scoreRegression(const std::vector<float>& y_true_f, const std::vector<float>& y_pred_f) {
+        std::vector<double> y_true(y_true_f.begin(), y_true_f.end());
+        std::vector<double> y_pred(y_pred_f.begin(), y_pred_f.end());
+        FoldScore result;
+        result.score = MetricsCalculator::calculateR2Score(y_true, y_pred);
+        result.metrics["r2"] = result.score;
+        result.metrics["mae"] = MetricsCalculator::calculateMAE(y_true, y_pred);
+        result.metrics["rmse"] = MetricsCalculator::calculateRMSE(y_true, y_pred);
+        return result;
+    }
+}
+
+CrossValidationResult runCrossValidation(
+    const std::vector<MLSplitUtils::RangeFold>& folds,
+    const CoreBudget& budget,
+    const FoldEvaluator& evaluate
+) {
+    CrossValidationResult result;
+    result.folds.resize(folds.size());
+    if (folds.empty()) return result;
+
+    // Validation blocks partition the samples, so their sizes add up to the sample count.
+    size_t total = 0;
+    for (const auto& fold : folds) total += MLSplitUtils::rangeCount(fold.val);
+
+    TripleBarrier::Parallel::parallelFor(folds.size(), static_cast<unsigned>(budget.jobs), [&](size_t k) {
+        FoldResult& out = result.folds[k];
+        out.fold = static_cast<int>(k);
+        out.train_size = MLSplitUtils::rangeCount(folds[k].train);
+        out.val_size = MLSplitUtils::rangeCount(folds[k].val);
+        try {
+            out.score = evaluate(folds[k], budget.threads_per_job);
+            out.success = true;
+        } catch (const std::exception& e) {
+            out.error = e.what();
+        }
+    });
+
+    for (auto& fold : result.folds) {
+        fold.purged = total - fold.train_size - fold.val_size;
+    }
+
+    std::map<std::string, size_t> metric_counts;
+    double sum = 0.0;
+    for (const auto& fold : result.folds) {
+        if (!fold.success) continue;
+        result.successful_folds++;
+        sum += fold.score.score;
+        for (const auto& kv : fold.score.metrics) {
+            result.mean_metrics[kv.first] += kv.second;
+            metric_counts[kv.first]++;
+        }
+    }
+    if (result.successful_folds == 0) {
+        result.mean_score = std::numeric_limits<double>::quiet_NaN();
+        result.std_score = std::numeric_limits<double>::quiet_NaN();
+        return result;
+    }
+
+    result.mean_score = sum / result.successful_folds;
+    for (auto& kv : result.mean_metrics) {
+        kv.second /= metric_counts[kv.first];
+    }
+    if (result.successful_folds > 1) {
+        double sq = 0.0;
+        for (const auto& fold : result.folds) {
+            if (!fold.success) continue;
+            double d = fold.score.score - result.mean_score;
+            sq += d * d;
+        }
+        result.std_score = std::sqrt(sq / (result.successful_folds - 1));
+    }
+    return result;
+}
+
+std::vector<MLSplitUtils::EventWindow> eventWindows(const std::vector<int>& entry_indices,
+                                                    const std::vector<int>& exit_indices) {
+    if (entry_indices.size() != exit_indices.size()) {
+        throw std::invalid_argument("Entry and exit indices must have the same size");
+    }
+    std::vector<MLSplitUtils::EventWindow> windows(entry_indices.size());
+    for (size_t i = 0; i < entry_indices.size(); ++i) {
+        if (entry_indices[i] < 0) {
+            throw std::invalid_argument("Event " + std::to_string(i) + " has no entry index");
+        }
+        windows[i].start = static_cast<size_t>(entry_indices[i]);
+        windows[i].end = static_cast<size_t>(std::max(entry_indices[i], exit_indices[i]));
+    }
+    return windows;
+}
+
+FoldScore scoreFold(const XGBoostModel& model, const DenseMatrixView& X, const std::vector<float>& y,
+                    const MLSplitUtils::RangeFold& fold) {
+    std::vector<float> y_val = MLSplitUtils::selectRanges(y, fold.val);
+    MLSplitUtils::RowRangeView val(X, fold.val);
+    if (isClassificationObjective(model.get_config().objective)) {
+        std::vector<int> predicted;
+        for (size_t k = 0; k < val.blocks(); ++k) {
+            auto block = model.predict(val.block(k));
+            predicted.insert(predicted.end(), block.begin(), block.end());
+        }
+        return scoreClassification(y_val, predicted);
+    }
+    std::vector<float> predicted;
+    for (size_t k = 0; k < val.blocks(); ++k) {
+        auto block = model.predict_raw(val.block(k));
+        predicted.insert(predicted.end(), block.begin(), block.end());
+    }
+    return scoreRegression(y_val, predicted);
+}
+
+CrossValidationResult runPurgedCrossValidation(
+    const DenseMatrixView& X,
+    const std::vector<float>& y,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const CrossValidationConfig& config
+) {
+    if (X.empty()) {
+        throw std::invalid_argument("Input feature matrix cannot be empty");
+    }
+    if (X.rows != y.size() || X.rows != windows.size()) {
+        throw std::invalid_argument("Features, labels and event windows must have the same number of rows");
+    }
+
+    auto folds = MLSplitUtils::purgedKFoldRanges(windows, config.n_splits, config.embargo_bars);
+    CoreBudget budget = planCoreBudget(folds.size(), config.jobs, config.model.nthread,
+                                       TripleBarrier::Parallel::hardwareThreads());
+
+    // Each fold builds its own DMatrix, so concurrent boosters share nothing but X. The
+    // training blocks go to the QuantileDMatrix as separate batches and each validation
+    // block is scored as a view into X; no rows are copied.
+    auto evaluate = [&](const MLSplitUtils::RangeFold& fold, int nthread) {
+        if (fold.train.empty()) {
+            throw std::runtime_error("Purging left no training samples");
+        }
+        std::vector<float> y_train = MLSplitUtils::selectRanges(y, fold.train);
+
+        XGBoostConfig model_config = config.model;
+        model_config.nthread = nthread;
+        model_config.early_stopping_rounds = 0;
+
+        TrainingDataset::Options options;
+        options.use_quantile = config.use_quantile_dmatrix;
+        options.max_bin = config.max_bin;
+        options.nthread = nthread;
+        TrainingDataset train_data(MLSplitUtils::RowRangeView(X, fold.train), y_train,
+                                   model_config.objective, options);
+        XGBoostModel model;
+        model.fit(train_data, model_config);
+
+        return scoreFold(model, X, y, fold);
+    };
+
+    return runCrossValidation(folds, budget, evaluate);
+}
+
+}
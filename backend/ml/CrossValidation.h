@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "DenseMatrix.h"
+#include "HyperparameterSearch.h"
+#include "MLSplits.h"
+#include "XGBoostModel.h"
+
+namespace MLPipeline {
+
+struct CrossValidationConfig {
+    int n_splits = 5;
+    size_t embargo_bars = 0;  // bars after each validation block that training may not start in
+    int jobs = 0;             // concurrent folds; 0 splits the cores into jobs of model.nthread each
+    bool use_quantile_dmatrix = true;  // fits sketch the training blocks in place instead of copying them
+    int max_bin = 256;
+    XGBoostConfig model;
+};
+
+// Validation score of one fold plus any secondary metrics, keyed by name.
+struct FoldScore {
+    double score = 0.0;
+    std::map<std::string, double> metrics;
+};
+
+struct FoldResult {
+    int fold = 0;
+    size_t train_size = 0;
+    size_t val_size = 0;
+    size_t purged = 0;  // samples dropped from training by purging and embargo
+    bool success = false;
+    std::string error;
+    FoldScore score;
+};
+
+struct CrossValidationResult {
+    std::vector<FoldResult> folds;
+    size_t successful_folds = 0;
+    // Mean and sample standard deviation over the successful folds; NaN if none succeeded.
+    double mean_score = 0.0;
+    double std_score = 0.0;
+    std::map<std::string, double> mean_metrics;
+};
+
+// Trains on fold.train and scores fold.val with nthread threads.
+using FoldEvaluator = std::function<FoldScore(const MLSplitUtils::RangeFold& fold, int nthread)>;
+
+// Evaluates every fold concurrently under the core budget. A fold that throws is
+// recorded as failed and left out of the aggregates instead of aborting the run.
+CrossValidationResult runCrossValidation(
+    const std::vector<MLSplitUtils::RangeFold>& folds,
+    const CoreBudget& budget,
+    const FoldEvaluator& evaluate
+);
+
+// Windows from the entry/exit bar positions carried on a FeatureExtractionResult; a
+// missing exit (-1) falls back to the entry bar.
+std::vector<MLSplitUtils::EventWindow> eventWindows(const std::vector<int>& entry_indices,
+                                                    const std::vector<int>& exit_indices);
+
+// Scores a trained model on fold.val of X/y, block by block, the way
+// runPurgedCrossValidation scores each fold.
+FoldScore scoreFold(const XGBoostModel& model, const DenseMatrixView& X, const std::vector<float>& y,
+                    const MLSplitUtils::RangeFold& fold);
+
+// Purged K-fold estimate for config.model on X/y, whose rows are events in entry order
+// with the given label windows. Classification folds are scored by F1 for 0/1 labels and
+// accuracy otherwise (both reported); regression folds by R2, with MAE and RMSE reported.
+CrossValidationResult runPurgedCrossValidation(
+    const DenseMatrixView& X,
+    const std::vector<float>& y,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const CrossValidationConfig& config
+);
+
+}
@@ -329,11 +329,11 @@ createSplits(size_t data_size, const SplitConfig& config) {
         }
         
         case SplitStrategy::PURGED_KFOLD: {
-            auto folds = MLSplitUtils::purgedKFoldSplit(data_size, config.n_splits, config.embargo);
+            auto folds = MLSplitUtils::purgedKFoldRanges(data_size, config.n_splits, config.embargo);
             if (!folds.empty()) {
-                train_idx = std::move(folds[0].train_indices);
-                val_idx = std::move(folds[0].val_indices);
-                test_idx = std::move(folds.back().val_indices);
+                train_idx = MLSplitUtils::expandRanges(folds[0].train);
+                val_idx = MLSplitUtils::expandRanges(folds[0].val);
+                test_idx = MLSplitUtils::expandRanges(folds.back().val);
             }
             break;
         }
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace MLPipeline {
+
+// Non-owning view of a row-major float matrix. Row i starts at data + i * stride, so a
+// view can address a block of a larger buffer without copying it.
+struct DenseMatrixView {
+    const float* data = nullptr;
+    size_t rows = 0;
+    size_t cols = 0;
+    size_t stride = 0;
+
+    DenseMatrixView() = default;
+    DenseMatrixView(const float* data_, size_t rows_, size_t cols_, size_t stride_ = 0)
+        : data(data_), rows(rows_), cols(cols_), stride(stride_ == 0 ? cols_ : stride_) {}
+
+    size_t size() const { return rows; }
+    bool empty() const { return rows == 0; }
+    bool contiguous() const { return stride == cols; }
+    const float* row(size_t i) const { return data + i * stride; }
+    float at(size_t i, size_t j) const { return data[i * stride + j]; }
+
+    DenseMatrixView rowRange(size_t begin, size_t end) const {
+        return DenseMatrixView(data + begin * stride, end - begin, cols, stride);
+    }
+};
+
+// Owning contiguous row-major matrix; columns follow feature_names.
+struct FlatFloatMatrix {
+    std::vector<float> values;
+    size_t rows = 0;
+    size_t cols = 0;
+    std::vector<std::string> feature_names;
+
+    DenseMatrixView view() const { return DenseMatrixView(values.data(), rows, cols); }
+};
+
+}
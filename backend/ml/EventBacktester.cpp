@@ -0,0 +1,149 @@
+#include "EventBacktester.h"
+#include "../data/EventIndexUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace MLPipeline {
+
+namespace {
+    struct OpenPosition {
+        size_t event;
+        double units;           // signed; negative for shorts
+        double entry_price;
+        double equity_before;   // equity when the position was opened
+        double position_pct;
+    };
+}
+
+EventBacktestResult runEventBacktest(
+    const std::vector<PreprocessedRow>& rows,
+    const std::vector<LabeledEvent>& labeledEvents,
+    const std::vector<double>& trading_signals,
+    const EventBacktestConfig& config
+) {
+    if (rows.empty()) {
+        throw std::invalid_argument("Price series cannot be empty");
+    }
+    if (trading_signals.size() != labeledEvents.size()) {
+        throw std::invalid_argument("Signals and labeled events must have the same size");
+    }
+    if (config.max_gross_exposure <= 0.0) {
+        throw std::invalid_argument("max_gross_exposure must be positive");
+    }
+
+    const PortfolioConfig& portfolio = config.portfolio;
+    EventBacktestResult result;
+    result.starting_capital = portfolio.starting_capital;
+
+    // Entries in bar order; ties keep event order.
+    std::vector<int> entry_bars = EventIndexUtils::resolveEntryIndices(rows, labeledEvents);
+    std::vector<std::pair<int, size_t>> entries;
+    entries.reserve(labeledEvents.size());
+    for (size_t e = 0; e < labeledEvents.size(); ++e) {
+        const double signal = trading_signals[e];
+        if (!(std::abs(signal) > portfolio.position_threshold)) continue;
+        if (entry_bars[e] < 0 || !(rows[entry_bars[e]].price > 0.0)) {
+            ++result.skipped_events;
+            continue;
+        }
+        entries.emplace_back(entry_bars[e], e);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    std::vector<OpenPosition> positions;
+    positions.reserve(entries.size());
+    using PendingExit = std::pair<int, size_t>;  // exit bar, slot in positions
+    std::priority_queue<PendingExit, std::vector<PendingExit>, std::greater<PendingExit>> exits;
+
+    double cash = portfolio.starting_capital;
+    double net_units = 0.0;
+    double gross_units = 0.0;
+    RiskMetricsAccumulator risk(cash);
+    int winning_trades = 0;
+    result.equity.resize(rows.size());
+    result.trade_log.reserve(entries.size());
+
+    auto close_due = [&](int bar) {
+        const double price = rows[bar].price;
+        while (!exits.empty() && exits.top().first <= bar) {
+            const OpenPosition& position = positions[exits.top().second];
+            exits.pop();
+            cash += position.units * price;
+            net_units -= position.units;
+            gross_units -= std::abs(position.units);
+            const double pnl = position.units * (price - position.entry_price);
+            if (pnl > 0) ++winning_trades;
+            result.trade_log.push_back(TradeLogEntry{
+                position.event,
+                trading_signals[position.event],
+                pnl,
+                position.equity_before,
+                cash + net_units * price,
+                position.units > 0 ? TradeDecision::BUY : TradeDecision::SELL,
+                position.position_pct
+            });
+        }
+    };
+
+    size_t next_entry = 0;
+    for (size_t t = 0; t < rows.size(); ++t) {
+        const int bar = static_cast<int>(t);
+        const double price = rows[t].price;
+        close_due(bar);
+        double traded = 0.0;
+
+        for (; next_entry < entries.size() && entries[next_entry].first == bar; ++next_entry) {
+            const size_t e = entries[next_entry].second;
+            const double signal = trading_signals[e];
+            double position_pct = std::min(std::abs(signal) * portfolio.hard_barrier_position_pct,
+                                           portfolio.hard_barrier_position_pct);
+
+            const double equity = cash + net_units * price;
+            const double room = config.max_gross_exposure * equity - gross_units * price;
+            double notional = std::min(position_pct * equity, room);
+            if (!(notional > 0.0)) {
+                ++result.skipped_events;
+                continue;
+            }
+            position_pct = notional / equity;
+            const double units = (signal < 0 ? -notional : notional) / price;
+
+            cash -= units * price;
+            net_units += units;
+            gross_units += std::abs(units);
+            positions.push_back(OpenPosition{e, units, price, equity, signal < 0 ? -position_pct : position_pct});
+            int exit_bar = EventIndexUtils::resolveExitIndex(labeledEvents[e], bar, rows.size());
+            exits.emplace(exit_bar, positions.size() - 1);
+            traded += position_pct;
+            ++result.total_trades;
+        }
+        result.max_concurrent_positions = std::max(result.max_concurrent_positions, exits.size());
+
+        // Positions that resolve on their entry bar.
+        close_due(bar);
+
+        const double equity = cash + net_units * price;
+        result.equity[t] = equity;
+        if (equity > 0.0) {
+            result.peak_gross_exposure = std::max(result.peak_gross_exposure, gross_units * price / equity);
+        }
+        risk.add(equity, traded);
+    }
+
+    RiskMetrics metrics = risk.metrics();
+    result.max_drawdown = metrics.max_drawdown;
+    result.max_drawdown_duration = metrics.max_drawdown_duration;
+    result.sharpe = metrics.sharpe;
+    result.sortino = metrics.sortino;
+
+    result.final_equity = result.equity.back();
+    result.total_return = (result.final_equity - portfolio.starting_capital) / portfolio.starting_capital;
+    result.win_rate = result.total_trades > 0 ? winning_trades / static_cast<double>(result.total_trades) : 0.0;
+    return result;
+}
+
+}
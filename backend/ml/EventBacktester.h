@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "PortfolioSimulator.h"
+
+struct LabeledEvent;
+struct PreprocessedRow;
+
+namespace MLPipeline {
+
+struct EventBacktestConfig {
+    PortfolioConfig portfolio;         // capital, entry threshold and position size as in simulate_portfolio
+    double max_gross_exposure = 1.0;   // open notional over equity; entries beyond it are scaled down
+};
+
+struct EventBacktestResult {
+    double starting_capital = 0.0;
+    double final_equity = 0.0;
+    double total_return = 0.0;
+    double max_drawdown = 0.0;          // largest peak-to-trough fall of the marked equity
+    size_t max_drawdown_duration = 0;   // in bars
+    double sharpe = 0.0;                // per-bar returns of the marked equity
+    double sortino = 0.0;
+    int total_trades = 0;
+    double win_rate = 0.0;
+    size_t skipped_events = 0;          // no resolvable entry bar, or no exposure left
+    size_t max_concurrent_positions = 0;
+    double peak_gross_exposure = 0.0;   // largest open notional over equity at a bar close
+    std::vector<double> equity;         // cash plus open positions at every bar's price
+    std::vector<TradeLogEntry> trade_log;  // one per closed position; index is the event's
+};
+
+// Opens a position for every event whose signal clears the threshold at its entry bar
+// and closes it at its barrier exit bar, both at the bar's price. Positions overlap
+// freely up to max_gross_exposure. Equity is marked at every bar in constant time from
+// the net units held, and pending exits sit in a min-heap keyed by exit bar, so a run
+// costs O(rows + events log events).
+EventBacktestResult runEventBacktest(
+    const std::vector<PreprocessedRow>& rows,
+    const std::vector<LabeledEvent>& labeledEvents,
+    const std::vector<double>& trading_signals,
+    const EventBacktestConfig& config = EventBacktestConfig{}
+);
+
+}
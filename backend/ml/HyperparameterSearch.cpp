@@ -0,0 +1,222 @@
+#include "HyperparameterSearch.h"
+#include "../utils/ParallelUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+namespace MLPipeline {
+
+std::vector<HyperparameterCombination> expandGrid(const HyperparameterGrid& grid) {
+    std::vector<HyperparameterCombination> combinations;
+    combinations.reserve(grid.n_rounds.size() * grid.max_depth.size() * grid.learning_rate.size() *
+                         grid.subsample.size() * grid.colsample_bytree.size());
+    for (int n_rounds : grid.n_rounds) {
+        for (int max_depth : grid.max_depth) {
+            for (double lr : grid.learning_rate) {
+                for (double subsample : grid.subsample) {
+                    for (double colsample : grid.colsample_bytree) {
+                        combinations.push_back({n_rounds, max_depth, lr, subsample, colsample});
+                    }
+                }
+            }
+        }
+    }
+    return combinations;
+}
+
+CoreBudget planCoreBudget(size_t combinations, int requested_jobs, int threads_hint, unsigned available_cores) {
+    CoreBudget budget;
+    int cores = std::max(1, static_cast<int>(available_cores));
+    int jobs = requested_jobs > 0 ? std::min(requested_jobs, cores) : std::max(1, cores / std::max(1, threads_hint));
+    budget.jobs = static_cast<int>(std::min<size_t>(static_cast<size_t>(jobs), std::max<size_t>(combinations, 1)));
+    budget.threads_per_job = std::max(1, cores / budget.jobs);
+    return budget;
+}
+
+GridSearchResult runGridSearch(
+    const std::vector<HyperparameterCombination>& combinations,
+    const CoreBudget& budget,
+    const GridEvaluator& evaluate,
+    const std::function<bool(double)>& should_stop,
+    const TuningProgressCallback& progress
+) {
+    GridSearchResult result;
+    const size_t total = combinations.size();
+    result.scores.assign(total, std::numeric_limits<double>::quiet_NaN());
+    if (total == 0) return result;
+
+    std::vector<char> evaluated(total, 0);
+    EarlyStopIndex stop(total);
+    std::mutex progressMutex;
+    TuningProgress state;
+    state.total = total;
+
+    TripleBarrier::Parallel::parallelFor(total, static_cast<unsigned>(budget.jobs), [&](size_t i) {
+        if (stop.skips(i)) return;
+
+        double score = std::numeric_limits<double>::quiet_NaN();
+        try {
+            score = evaluate(i, combinations[i], budget.threads_per_job);
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            std::cerr << "Error in hyperparameter combination " << (i + 1)
+                      << ": " << e.what() << std::endl;
+        }
+        result.scores[i] = score;
+        evaluated[i] = 1;
+        if (!std::isnan(score) && should_stop && should_stop(score)) {
+            stop.record(i);
+        }
+
+        std::lock_guard<std::mutex> lock(progressMutex);
+        state.completed++;
+        if (!std::isnan(score) && (!state.has_best || score > state.best_score)) {
+            state.best_score = score;
+            state.has_best = true;
+        }
+        if (progress) progress(state);
+    });
+
+    size_t end = total;
+    for (size_t i = 0; i < total; ++i) {
+        if (!evaluated[i]) continue;
+        result.evaluated++;
+        double score = result.scores[i];
+        if (i < end && !std::isnan(score) && should_stop && should_stop(score)) {
+            end = i + 1;
+            result.early_stopped = true;
+        }
+    }
+    for (size_t i = 0; i < end; ++i) {
+        double score = result.scores[i];
+        if (!std::isnan(score) && (!result.has_best || score > result.best_score)) {
+            result.best_score = score;
+            result.best_index = i;
+            result.has_best = true;
+        }
+    }
+    return result;
+}
+
+std::vector<HyperparameterCombination> expandGridWithoutRounds(const HyperparameterGrid& grid) {
+    if (grid.n_rounds.empty() || *std::max_element(grid.n_rounds.begin(), grid.n_rounds.end()) <= 0) {
+        throw std::invalid_argument("Successive halving needs a positive n_rounds value in the grid");
+    }
+    HyperparameterGrid single = grid;
+    single.n_rounds = {*std::max_element(grid.n_rounds.begin(), grid.n_rounds.end())};
+    return expandGrid(single);
+}
+
+std::vector<int> successiveHalvingRungs(const SuccessiveHalvingConfig& config, int max_rounds) {
+    if (config.min_rounds <= 0 || config.eta < 2 || max_rounds <= 0) {
+        throw std::invalid_argument("Successive halving needs min_rounds > 0, eta >= 2 and max_rounds > 0");
+    }
+    std::vector<int> rungs;
+    long long rounds = std::min(config.min_rounds, max_rounds);
+    while (true) {
+        rungs.push_back(static_cast<int>(rounds));
+        if (rounds >= max_rounds) break;
+        rounds = std::min<long long>(rounds * config.eta, max_rounds);
+    }
+    return rungs;
+}
+
+SuccessiveHalvingResult runSuccessiveHalving(
+    const std::vector<HyperparameterCombination>& combinations,
+    const CoreBudget& budget,
+    const SuccessiveHalvingConfig& config,
+    int max_rounds,
+    const TrialFactory& make_trial,
+    const std::function<bool(double)>& should_stop,
+    const TuningProgressCallback& progress
+) {
+    SuccessiveHalvingResult result;
+    result.rungs = successiveHalvingRungs(config, max_rounds);
+    if (combinations.empty()) return result;
+
+    std::vector<IncrementalTrial> trials(combinations.size());
+    std::vector<int> trained_rounds(combinations.size(), 0);
+    std::vector<size_t> survivors(combinations.size());
+    std::iota(survivors.begin(), survivors.end(), 0);
+
+    std::mutex progressMutex;
+    TuningProgress state;
+    for (size_t n = combinations.size(), r = 0; r < result.rungs.size(); ++r) {
+        state.total += n;
+        n = std::max<size_t>(1, (n + config.eta - 1) / config.eta);
+    }
+
+    for (size_t r = 0; r < result.rungs.size() && !survivors.empty(); ++r) {
+        const int rung_rounds = result.rungs[r];
+        std::vector<double> scores(survivors.size(), std::numeric_limits<double>::quiet_NaN());
+
+        TripleBarrier::Parallel::parallelFor(survivors.size(), static_cast<unsigned>(budget.jobs), [&](size_t k) {
+            size_t i = survivors[k];
+            double score = std::numeric_limits<double>::quiet_NaN();
+            bool failed = false;
+            try {
+                if (!trials[i]) trials[i] = make_trial(combinations[i], budget.threads_per_job);
+                score = trials[i](rung_rounds);
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                std::cerr << "Error in hyperparameter combination " << (i + 1)
+                          << " at " << rung_rounds << " rounds: " << e.what() << std::endl;
+                trials[i] = nullptr;
+                failed = true;
+            }
+            scores[k] = score;
+
+            std::lock_guard<std::mutex> lock(progressMutex);
+            // A failed trial never reached its rung, so it is not charged for it.
+            if (!failed) {
+                result.total_rounds += rung_rounds - trained_rounds[i];
+                trained_rounds[i] = rung_rounds;
+            }
+            state.completed++;
+            if (!std::isnan(score) && (!state.has_best || score > state.best_score)) {
+                state.best_score = score;
+                state.has_best = true;
+            }
+            if (progress) progress(state);
+        });
+
+        std::vector<size_t> order;
+        for (size_t k = 0; k < survivors.size(); ++k) {
+            if (!std::isnan(scores[k])) order.push_back(k);
+        }
+        if (order.empty()) {
+            survivors.clear();
+            break;
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return scores[a] > scores[b]; });
+
+        result.has_best = true;
+        result.best_index = survivors[order.front()];
+        result.best_score = scores[order.front()];
+        result.best_rounds = rung_rounds;
+
+        if (should_stop && should_stop(result.best_score)) {
+            result.early_stopped = true;
+            break;
+        }
+
+        size_t keep = std::max<size_t>(1, (survivors.size() + config.eta - 1) / config.eta);
+        keep = std::min(keep, order.size());
+        std::vector<size_t> promoted;
+        promoted.reserve(keep);
+        for (size_t k = 0; k < keep; ++k) promoted.push_back(survivors[order[k]]);
+        for (size_t i : survivors) {
+            if (std::find(promoted.begin(), promoted.end(), i) == promoted.end()) trials[i] = nullptr;
+        }
+        survivors.swap(promoted);
+    }
+    return result;
+}
+
+}
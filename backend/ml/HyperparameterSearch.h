@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace MLPipeline {
+
+struct HyperparameterGrid {
+    std::vector<int> n_rounds = {50, 100, 200};
+    std::vector<int> max_depth = {3, 5, 7};
+    std::vector<double> learning_rate = {0.01, 0.1, 0.3};
+    std::vector<double> subsample = {0.8, 1.0};
+    std::vector<double> colsample_bytree = {0.8, 1.0};
+};
+
+enum class TuningStrategy {
+    GRID,                // train every combination to its full n_rounds
+    SUCCESSIVE_HALVING   // race all combinations on growing round budgets, keep the best 1/eta
+};
+
+struct SuccessiveHalvingConfig {
+    int min_rounds = 10;  // rounds in the first rung
+    int eta = 3;          // budget growth and reduction factor between rungs
+};
+
+struct HyperparameterCombination {
+    int n_rounds = 0;
+    int max_depth = 0;
+    double learning_rate = 0.0;
+    double subsample = 0.0;
+    double colsample_bytree = 0.0;
+};
+
+// Every combination of the grid, in the order of the nested loops it replaces
+// (n_rounds outermost, colsample_bytree innermost).
+std::vector<HyperparameterCombination> expandGrid(const HyperparameterGrid& grid);
+
+// How many combinations run at once and how many XGBoost threads each one gets.
+struct CoreBudget {
+    int jobs = 1;
+    int threads_per_job = 1;
+};
+
+// requested_jobs <= 0 derives the job count from threads_hint (the per-booster nthread
+// from config), e.g. 32 cores with nthread 8 gives 4 jobs x 8 threads. Jobs never
+// exceed the cores, so every job gets at least one core of its own.
+CoreBudget planCoreBudget(size_t combinations, int requested_jobs, int threads_hint, unsigned available_cores);
+
+struct TuningProgress {
+    size_t completed = 0;
+    size_t total = 0;
+    double best_score = 0.0;
+    bool has_best = false;
+};
+
+using TuningProgressCallback = std::function<void(const TuningProgress&)>;
+
+struct GridSearchResult {
+    std::vector<double> scores;  // NaN for combinations that failed or were skipped
+    bool has_best = false;
+    size_t best_index = 0;
+    double best_score = 0.0;
+    bool early_stopped = false;
+    size_t evaluated = 0;
+};
+
+// Smallest index whose score satisfied the stopping rule, shared by concurrent workers.
+// An index is skipped only when it comes after that one, so a worker that claimed an
+// earlier index still evaluates it however late it gets there, as a serial scan would.
+class EarlyStopIndex {
+public:
+    explicit EarlyStopIndex(size_t none) : index_(none) {}
+
+    void record(size_t i) {
+        size_t current = index_.load(std::memory_order_relaxed);
+        while (i < current && !index_.compare_exchange_weak(current, i, std::memory_order_relaxed)) {}
+    }
+    bool skips(size_t i) const { return i > index_.load(std::memory_order_relaxed); }
+    size_t index() const { return index_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<size_t> index_;
+};
+
+// Evaluates combinations concurrently under the given budget. Combinations are started
+// in grid order; once one satisfies should_stop no later ones are started. The winner is
+// chosen as a serial scan would: the first best score up to the first stopping
+// combination, so results do not depend on thread timing. The evaluator gets each
+// combination's index in `combinations`, for callers that keep per-combination results.
+using GridEvaluator = std::function<double(size_t index, const HyperparameterCombination&, int nthread)>;
+
+GridSearchResult runGridSearch(
+    const std::vector<HyperparameterCombination>& combinations,
+    const CoreBudget& budget,
+    const GridEvaluator& evaluate,
+    const std::function<bool(double)>& should_stop,
+    const TuningProgressCallback& progress = nullptr
+);
+
+// Distinct combinations of everything except n_rounds, which successive halving
+// treats as the budget (capped at the largest value in the grid). Throws
+// std::invalid_argument when the grid has no positive n_rounds value.
+std::vector<HyperparameterCombination> expandGridWithoutRounds(const HyperparameterGrid& grid);
+
+// Round budget of each rung: min_rounds * eta^k, capped at max_rounds.
+std::vector<int> successiveHalvingRungs(const SuccessiveHalvingConfig& config, int max_rounds);
+
+// A configuration trained incrementally: calling it with r continues boosting until the
+// model has r rounds in total and returns its validation score.
+using IncrementalTrial = std::function<double(int total_rounds)>;
+using TrialFactory = std::function<IncrementalTrial(const HyperparameterCombination&, int nthread)>;
+
+struct SuccessiveHalvingResult {
+    bool has_best = false;
+    size_t best_index = 0;
+    double best_score = 0.0;
+    int best_rounds = 0;
+    bool early_stopped = false;
+    long long total_rounds = 0;  // boosting rounds spent across all trials that did not fail
+    std::vector<int> rungs;
+};
+
+// Every combination starts on the first rung; after each rung the top ceil(n/eta) are
+// promoted and continue boosting from where they stopped. Trials within a rung run
+// concurrently under the core budget. A score satisfying should_stop ends the search
+// after its rung.
+SuccessiveHalvingResult runSuccessiveHalving(
+    const std::vector<HyperparameterCombination>& combinations,
+    const CoreBudget& budget,
+    const SuccessiveHalvingConfig& config,
+    int max_rounds,
+    const TrialFactory& make_trial,
+    const std::function<bool(double)>& should_stop,
+    const TuningProgressCallback& progress = nullptr
+);
+
+}
@@ -4,12 +4,14 @@
 #include "ModelUtils.h"
 #include "MetricsCalculator.h"
 #include "PortfolioSimulator.h"
+#include "../utils/ParallelUtils.h"
 #include <numeric>
 #include <algorithm>
 #include <cmath>
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
+#include <memory>
 
 namespace MLPipeline {
 
@@ -46,7 +48,7 @@ ResultType runPipelineTemplate(
     
     auto [train_idx, val_idx, test_idx] = createSplits(X_clean.size(), config);
 
-    auto X_train_f = toFloatMatrix(select_rows(X_clean, train_idx));
+    auto X_train_f = toFlatFloatMatrix(X_clean, train_idx);
     
     std::vector<size_t> eval_idx;
     if (val_idx.empty()) {
@@ -56,7 +58,7 @@ ResultType runPipelineTemplate(
         eval_idx = val_idx;
     }
     
-    auto X_eval_f = toFloatMatrix(select_rows(X_clean, eval_idx));
+    auto X_eval_f = toFlatFloatMatrix(X_clean, eval_idx);
     auto returns_eval = select_rows(returns_clean, eval_idx);
 
     XGBoostConfig model_config;
@@ -72,21 +74,38 @@ ResultType runPipelineTemplate(
     
     if constexpr (std::is_same_v<T, int>) {
         auto y_train_f = toFloatVecInt(select_rows(y_clean, train_idx));
-        model.fit(X_train_f, y_train_f, model_config);
+        model.fit(X_train_f.view(), y_train_f, model_config);
         
-        auto y_pred = model.predict(X_eval_f);
-        auto y_prob = model.predict_proba(X_eval_f);
+        // One booster call yields both the labels and the probabilities.
+        ClassificationOutput full = model.predict_full(X_eval_f.view());
+        const std::vector<int>& y_pred = full.labels;
+        
+        // Binary models report P(label 1) per row, multiclass ones the probability matrix.
+        std::vector<double> y_prob_d;
+        if (full.num_classes == 2) {
+            y_prob_d.reserve(full.rows);
+            for (size_t i = 0; i < full.rows; ++i) y_prob_d.push_back(full.row(i)[1]);
+        } else {
+            y_prob_d.assign(full.probabilities.begin(), full.probabilities.end());
+        }
         
         std::vector<double> signals;
         if (config.barrier_type == BarrierType::HARD) {
             signals.assign(y_pred.begin(), y_pred.end());
+        } else if (full.num_classes == 2) {
+            signals = y_prob_d;
         } else {
-            signals.assign(y_prob.begin(), y_prob.end());
+            // Expected label under the predicted distribution, e.g. in [-1, 1] for barriers.
+            signals.assign(full.rows, 0.0);
+            for (size_t i = 0; i < full.rows; ++i) {
+                for (size_t c = 0; c < full.num_classes; ++c) {
+                    signals[i] += full.row(i)[c] * full.class_labels[c];
+                }
+            }
         }
         
         PortfolioSimulation portfolio = simulate_portfolio(signals, returns_eval);
         
-        std::vector<double> y_prob_d(y_prob.begin(), y_prob.end());
         std::vector<TradeLogEntry> trade_log = portfolio.trade_log;
         return ResultType{y_pred, y_prob_d, portfolio, trade_log};
     } else {
@@ -99,9 +118,9 @@ ResultType runPipelineTemplate(
             float mean_train = sum_train / y_train_f.size();
         }
         
-        model.fit(X_train_f, y_train_f, model_config);
+        model.fit(X_train_f.view(), y_train_f, model_config);
         
-        auto y_pred_f = model.predict_raw(X_eval_f); 
+        auto y_pred_f = model.predict_raw(X_eval_f.view()); 
         
         if (!y_pred_f.empty()) {
             float min_raw = *std::min_element(y_pred_f.begin(), y_pred_f.end());
@@ -126,103 +145,245 @@ ResultType runPipelineTemplate(
     }
 }
 
+namespace {
+    CrossValidationConfig crossValidationConfig(const UnifiedPipelineConfig& config) {
+        CrossValidationConfig cv;
+        cv.n_splits = config.cv_folds;
+        cv.embargo_bars = static_cast<size_t>(std::max(0, config.embargo));
+        cv.jobs = config.tuning_jobs;
+        cv.use_quantile_dmatrix = config.use_quantile_dmatrix;
+        cv.max_bin = config.max_bin;
+        cv.model.n_rounds = config.n_rounds;
+        cv.model.max_depth = config.max_depth;
+        cv.model.nthread = config.nthread;
+        cv.model.objective = config.objective;
+        cv.model.learning_rate = config.learning_rate;
+        cv.model.subsample = config.subsample;
+        cv.model.colsample_bytree = config.colsample_bytree;
+        return cv;
+    }
+}
+
+template<typename T>
+std::vector<float> toFloatLabels(const std::vector<T>& y) {
+    if constexpr (std::is_same_v<T, int>) {
+        return toFloatVecInt(y);
+    } else {
+        return toFloatVecDouble(y);
+    }
+}
+
+// windows is null when the caller has no event windows; tuning then needs the
+// chronological split.
 template<typename T, typename ResultType>
 ResultType runPipelineWithTuningTemplate(
     const std::vector<std::map<std::string, double>>& X,
     const std::vector<T>& y,
     const std::vector<double>& returns,
+    const std::vector<MLSplitUtils::EventWindow>* windows,
     UnifiedPipelineConfig config,
     bool is_classification
 ) {
     validatePipelineInputs(X, y, returns);
     
+    const bool cross_validate = config.tuning_validation == TuningValidation::PURGED_CV;
+    if (cross_validate && !windows) {
+        throw std::invalid_argument("Tuning by purged cross-validation needs the samples' event windows; "
+                                    "pass them or set tuning_validation to CHRONOLOGICAL_SPLIT");
+    }
+    if (windows && windows->size() != X.size()) {
+        throw std::invalid_argument("Event windows must have one entry per sample");
+    }
+    
     auto [X_clean, y_clean, returns_clean] = DataProcessor::cleanData(X, y, returns);
-    auto [train_idx, val_idx, test_idx] = createSplits(X_clean.size(), config);
-
-    if (val_idx.empty()) {
-        throw std::invalid_argument("Hyperparameter tuning requires a validation set");
+    
+    TrainingDataset::Options dataset_options;
+    dataset_options.use_quantile = config.use_quantile_dmatrix;
+    dataset_options.max_bin = config.max_bin;
+    dataset_options.nthread = config.nthread;
+    
+    const bool halving = config.tuning_strategy == TuningStrategy::SUCCESSIVE_HALVING;
+    const bool early_stopping = !halving && !cross_validate && config.early_stopping_rounds > 0;
+    
+    // Every combination is fit on each training set and scored by the mean over them:
+    // the purged folds' training rows, or the single chronological training split. The
+    // training sets are built once and shared by all combinations.
+    std::vector<TrainingDataset> train_sets;
+    
+    // Purged cross-validation: event-ordered samples with their windows. Rows with a
+    // non-finite feature or label cannot be trained on and are left out with their window.
+    FlatFloatMatrix X_cv;
+    std::vector<float> y_cv;
+    std::vector<MLSplitUtils::RangeFold> folds;
+    if (cross_validate) {
+        std::vector<size_t> rows;
+        std::vector<MLSplitUtils::EventWindow> windows_cv;
+        for (size_t i = 0; i < X.size(); ++i) {
+            bool finite = std::isfinite(static_cast<double>(y[i]));
+            for (const auto& kv : X[i]) {
+                finite = finite && std::isfinite(kv.second);
+            }
+            if (!finite) continue;
+            rows.push_back(i);
+            windows_cv.push_back((*windows)[i]);
+        }
+        if (rows.empty()) {
+            throw std::invalid_argument("No finite samples left for cross-validation");
+        }
+        X_cv = toFlatFloatMatrix(X, rows);
+        y_cv = toFloatLabels(select_rows(y, rows));
+        
+        CrossValidationConfig cv = crossValidationConfig(config);
+        folds = MLSplitUtils::purgedKFoldRanges(windows_cv, cv.n_splits, cv.embargo_bars);
+        for (const auto& fold : folds) {
+            if (fold.train.empty()) {
+                throw std::runtime_error("Purging left a fold without training samples");
+            }
+            train_sets.emplace_back(MLSplitUtils::RowRangeView(X_cv.view(), fold.train),
+                                    MLSplitUtils::selectRanges(y_cv, fold.train), config.objective,
+                                    dataset_options);
+        }
+    }
+    
+    // Chronological split: one training set, scored on the validation rows after it.
+    std::vector<T> y_val;
+    FlatFloatMatrix X_val_f;
+    std::unique_ptr<TrainingDataset> val_data;
+    if (!cross_validate) {
+        auto [train_idx, val_idx, test_idx] = createSplits(X_clean.size(), config);
+        if (val_idx.empty()) {
+            throw std::invalid_argument("Hyperparameter tuning requires a validation set");
+        }
+        
+        auto X_train_f = toFlatFloatMatrix(X_clean, train_idx);
+        X_val_f = toFlatFloatMatrix(X_clean, val_idx);
+        y_val = select_rows(y_clean, val_idx);
+        train_sets.emplace_back(X_train_f.view(), toFloatLabels(select_rows(y_clean, train_idx)),
+                                config.objective, dataset_options);
+        
+        // Early stopping scores the validation set inside XGBoost, so it needs labels
+        // encoded the way the training set's are.
+        if (early_stopping) {
+            val_data = std::make_unique<TrainingDataset>(X_val_f.view(), toFloatLabels(y_val), train_sets.front());
+        } else {
+            TrainingDataset::Options val_options;
+            val_options.nthread = config.nthread;
+            val_data = std::make_unique<TrainingDataset>(X_val_f.view(), std::vector<float>{}, config.objective,
+                                                         val_options);
+        }
     }
 
-    auto X_train_f = toFloatMatrix(select_rows(X_clean, train_idx));
-    auto X_val_f = toFloatMatrix(select_rows(X_clean, val_idx));
-    auto y_val = select_rows(y_clean, val_idx);
-
-    double best_score = is_classification ? -1.0 : -std::numeric_limits<double>::infinity();
-    UnifiedPipelineConfig best_config = config;
+    auto combinations = halving ? expandGridWithoutRounds(config.hyperparameter_grid)
+                                : expandGrid(config.hyperparameter_grid);
     
-    const auto& grid = config.hyperparameter_grid;
-    size_t total_combinations = grid.n_rounds.size() * grid.max_depth.size() * 
-                               grid.learning_rate.size() * grid.subsample.size() * 
-                               grid.colsample_bytree.size();
+    // Concurrent boosters only read the shared matrices; a plain DMatrix builds its
+    // histogram index lazily on first use, so only the pre-quantized ones are shared.
+    CoreBudget budget = planCoreBudget(combinations.size(), config.tuning_jobs, config.nthread,
+                                       TripleBarrier::Parallel::hardwareThreads());
+    if (!config.use_quantile_dmatrix) {
+        budget.jobs = 1;
+        budget.threads_per_job = config.nthread;
+    }
     
-    size_t combination_count = 0;
-    bool early_stop = false;
+    auto make_config = [&](const HyperparameterCombination& combo, int nthread) {
+        XGBoostConfig model_config;
+        model_config.n_rounds = combo.n_rounds;
+        model_config.max_depth = combo.max_depth;
+        model_config.nthread = nthread;
+        model_config.objective = config.objective;
+        model_config.learning_rate = combo.learning_rate;
+        model_config.subsample = combo.subsample;
+        model_config.colsample_bytree = combo.colsample_bytree;
+        if (early_stopping) {
+            model_config.early_stopping_rounds = config.early_stopping_rounds;
+        }
+        return model_config;
+    };
+    // Score of a model fit on train_sets[k]: its purged fold's score as
+    // runPurgedCrossValidation computes it, or the split's validation F1 / R2.
+    auto score_model = [&](const XGBoostModel& model, size_t k) -> double {
+        if (cross_validate) {
+            return scoreFold(model, X_cv.view(), y_cv, folds[k]).score;
+        }
+        if constexpr (std::is_same_v<T, int>) {
+            auto y_pred_val = model.predict(*val_data);
+            return MetricsCalculator::calculateF1Score(y_val, y_pred_val);
+        } else {
+            auto y_pred_val_f = model.predict_raw(*val_data);
+            std::vector<double> y_pred_val(y_pred_val_f.begin(), y_pred_val_f.end());
+            return MetricsCalculator::calculateR2Score(y_val, y_pred_val);
+        }
+    };
+    auto should_stop = [is_classification](double score) {
+        return (is_classification && score > 0.95) || (!is_classification && score > 0.99);
+    };
     
-    for (int n_rounds : grid.n_rounds) {
-        if (early_stop) break;
-        for (int max_depth : grid.max_depth) {
-            if (early_stop) break;
-            for (double lr : grid.learning_rate) {
-                if (early_stop) break;
-                for (double subsample : grid.subsample) {
-                    if (early_stop) break;
-                    for (double colsample : grid.colsample_bytree) {
-                        combination_count++;
-                        
-                        XGBoostConfig model_config;
-                        model_config.n_rounds = n_rounds;
-                        model_config.max_depth = max_depth;
-                        model_config.nthread = config.nthread;
-                        model_config.objective = config.objective;
-                        model_config.learning_rate = lr;
-                        model_config.subsample = subsample;
-                        model_config.colsample_bytree = colsample;
-
-                        try {
-                            XGBoostModel model;
-                            
-                            double score;
-                            MetricsCalculator metricsCalc;
-                            if constexpr (std::is_same_v<T, int>) {
-                                auto y_train_f = toFloatVecInt(select_rows(y_clean, train_idx));
-                                model.fit(X_train_f, y_train_f, model_config);
-                                auto y_pred_val = model.predict(X_val_f);
-                                score = metricsCalc.calculateF1Score(y_val, y_pred_val);
-                            } else {
-                                auto y_train_f = toFloatVecDouble(select_rows(y_clean, train_idx));
-                                model.fit(X_train_f, y_train_f, model_config);
-                                auto y_pred_val_f = model.predict(X_val_f);
-                                std::vector<double> y_pred_val(y_pred_val_f.begin(), y_pred_val_f.end());
-                                score = metricsCalc.calculateR2Score(y_val, y_pred_val);
-                            }
-                            
-                            if (score > best_score) {
-                                best_score = score;
-                                best_config.n_rounds = n_rounds;
-                                best_config.max_depth = max_depth;
-                                best_config.learning_rate = lr;
-                                best_config.subsample = subsample;
-                                best_config.colsample_bytree = colsample;
-                            }
-                            
-                            if ((is_classification && score > 0.95) || (!is_classification && score > 0.99)) {
-                                early_stop = true;
-                                break;
-                            }
-                            
-                        } catch (const std::exception& e) {
-                            std::cerr << "Error in hyperparameter combination " << combination_count 
-                                     << ": " << e.what() << std::endl;
-                            continue;
-                        }
-                        
-                        if (early_stop) break;
+    bool has_best = false;
+    HyperparameterCombination best;
+    if (halving) {
+        int max_rounds = combinations.empty() ? config.n_rounds : combinations.front().n_rounds;
+        auto make_trial = [&](const HyperparameterCombination& combo, int nthread) -> IncrementalTrial {
+            auto models = std::make_shared<std::vector<XGBoostModel>>(train_sets.size());
+            XGBoostConfig model_config = make_config(combo, nthread);
+            return [&, models, model_config](int total_rounds) mutable {
+                double sum = 0.0;
+                for (size_t k = 0; k < train_sets.size(); ++k) {
+                    XGBoostModel& model = (*models)[k];
+                    if (!model.is_trained()) {
+                        model_config.n_rounds = total_rounds;
+                        model.fit(train_sets[k], model_config);
+                    } else if (total_rounds > model.boosted_rounds()) {
+                        model.continue_training(train_sets[k], total_rounds - model.boosted_rounds());
                     }
+                    sum += score_model(model, k);
+                }
+                return sum / train_sets.size();
+            };
+        };
+        SuccessiveHalvingResult search = runSuccessiveHalving(
+            combinations, budget, config.successive_halving, max_rounds, make_trial, should_stop, config.tuning_progress);
+        if (search.has_best) {
+            has_best = true;
+            best = combinations[search.best_index];
+            best.n_rounds = search.best_rounds;
+        }
+    } else {
+        // Rounds each combination actually needed, by combination index.
+        std::vector<int> used_rounds(combinations.size(), 0);
+        auto evaluate = [&](size_t index, const HyperparameterCombination& combo, int nthread) {
+            double sum = 0.0;
+            for (size_t k = 0; k < train_sets.size(); ++k) {
+                XGBoostModel model;
+                if (early_stopping) {
+                    model.fit(train_sets[k], *val_data, make_config(combo, nthread));
+                    used_rounds[index] = model.best_iteration() >= 0 ? model.best_iteration() + 1
+                                                                      : model.boosted_rounds();
+                } else {
+                    model.fit(train_sets[k], make_config(combo, nthread));
                 }
+                sum += score_model(model, k);
+            }
+            return sum / train_sets.size();
+        };
+        GridSearchResult search = runGridSearch(combinations, budget, evaluate, should_stop, config.tuning_progress);
+        if (search.has_best) {
+            has_best = true;
+            best = combinations[search.best_index];
+            if (early_stopping && used_rounds[search.best_index] > 0) {
+                best.n_rounds = used_rounds[search.best_index];
             }
         }
     }
     
+    UnifiedPipelineConfig best_config = config;
+    if (has_best) {
+        best_config.n_rounds = best.n_rounds;
+        best_config.max_depth = best.max_depth;
+        best_config.learning_rate = best.learning_rate;
+        best_config.subsample = best.subsample;
+        best_config.colsample_bytree = best.colsample_bytree;
+    }
+    
     return runPipelineTemplate<T, ResultType>(X_clean, y_clean, returns_clean, best_config, is_classification);
 }
 
@@ -241,7 +402,17 @@ PipelineResult runPipelineWithTuning(
     const std::vector<double>& returns,
     UnifiedPipelineConfig config
 ) {
-    return runPipelineWithTuningTemplate<int, PipelineResult>(X, y, returns, config, true);
+    return runPipelineWithTuningTemplate<int, PipelineResult>(X, y, returns, nullptr, config, true);
+}
+
+PipelineResult runPipelineWithTuning(
+    const std::vector<std::map<std::string, double>>& X,
+    const std::vector<int>& y,
+    const std::vector<double>& returns,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    UnifiedPipelineConfig config
+) {
+    return runPipelineWithTuningTemplate<int, PipelineResult>(X, y, returns, &windows, config, true);
 }
 
 RegressionPipelineResult runPipelineRegression(
@@ -259,7 +430,17 @@ RegressionPipelineResult runPipelineRegressionWithTuning(
     const std::vector<double>& returns,
     UnifiedPipelineConfig config
 ) {
-    return runPipelineWithTuningTemplate<double, RegressionPipelineResult>(X, y, returns, config, false);
+    return runPipelineWithTuningTemplate<double, RegressionPipelineResult>(X, y, returns, nullptr, config, false);
+}
+
+RegressionPipelineResult runPipelineRegressionWithTuning(
+    const std::vector<std::map<std::string, double>>& X,
+    const std::vector<double>& y,
+    const std::vector<double>& returns,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    UnifiedPipelineConfig config
+) {
+    return runPipelineWithTuningTemplate<double, RegressionPipelineResult>(X, y, returns, &windows, config, false);
 }
 
 PipelineResult runPipeline(
@@ -293,6 +474,7 @@ PipelineResult runPipelineWithTuning(
     unified_config.max_depth = config.max_depth;
     unified_config.nthread = config.nthread;
     unified_config.objective = config.objective;
+    unified_config.tuning_validation = TuningValidation::CHRONOLOGICAL_SPLIT;
     unified_config.barrier_type = (config.objective == "binary:logistic") ? BarrierType::HARD : BarrierType::SOFT;
     
     return runPipelineWithTuning(X, y, returns, unified_config);
@@ -329,9 +511,31 @@ RegressionPipelineResult runPipelineRegressionWithTuning(
     unified_config.max_depth = config.max_depth;
     unified_config.nthread = config.nthread;
     unified_config.objective = config.objective;
+    unified_config.tuning_validation = TuningValidation::CHRONOLOGICAL_SPLIT;
     unified_config.barrier_type = BarrierType::SOFT;
     
     return runPipelineRegressionWithTuning(X, y, returns, unified_config);
 }
 
+
+CrossValidationResult runCrossValidation(
+    const std::vector<std::map<std::string, double>>& X,
+    const std::vector<int>& y,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const UnifiedPipelineConfig& config
+) {
+    auto X_f = toFlatFloatMatrix(X);
+    return runPurgedCrossValidation(X_f.view(), toFloatVecInt(y), windows, crossValidationConfig(config));
+}
+
+CrossValidationResult runCrossValidation(
+    const std::vector<std::map<std::string, double>>& X,
+    const std::vector<double>& y,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const UnifiedPipelineConfig& config
+) {
+    auto X_f = toFlatFloatMatrix(X);
+    return runPurgedCrossValidation(X_f.view(), toFloatVecDouble(y), windows, crossValidationConfig(config));
+}
+
 }
@@ -4,6 +4,8 @@
 #include <string>
 #include "XGBoostModel.h"
 #include "PortfolioSimulator.h"
+#include "HyperparameterSearch.h"
+#include "CrossValidation.h"
 
 namespace MLPipeline {  
     struct PipelineResult {
@@ -29,6 +31,12 @@ namespace MLPipeline {
         SOFT
     };
 
+    // How tuning scores a hyperparameter combination.
+    enum class TuningValidation {
+        PURGED_CV,            // mean score over purged K-fold folds; needs the event windows
+        CHRONOLOGICAL_SPLIT   // score on the validation split after the training split
+    };
+
     struct PipelineConfig {
         double test_size = 0.2;
         double val_size = 0.2;
@@ -53,14 +61,6 @@ namespace MLPipeline {
         }
     };
 
-    struct HyperparameterGrid {
-        std::vector<int> n_rounds = {50, 100, 200};
-        std::vector<int> max_depth = {3, 5, 7};
-        std::vector<double> learning_rate = {0.01, 0.1, 0.3};
-        std::vector<double> subsample = {0.8, 1.0};
-        std::vector<double> colsample_bytree = {0.8, 1.0};
-    };
-
     struct UnifiedPipelineConfig {
         double test_size = 0.2;
         double val_size = 0.2;
@@ -74,6 +74,28 @@ namespace MLPipeline {
         BarrierType barrier_type = BarrierType::HARD;
         HyperparameterGrid hyperparameter_grid;
         int embargo = 5;
+        
+        // Grid search trains every combination on one shared, pre-quantized training matrix.
+        bool use_quantile_dmatrix = true;
+        int max_bin = 256;
+        
+        // Concurrent grid-search jobs; 0 splits the machine's cores into jobs of nthread each.
+        int tuning_jobs = 0;
+        TuningProgressCallback tuning_progress;
+        
+        TuningStrategy tuning_strategy = TuningStrategy::GRID;
+        SuccessiveHalvingConfig successive_halving;
+        
+        // Grid search on the chronological split: stop each combination after this many
+        // rounds without validation improvement (0 = off) and refit the winner with the
+        // rounds it actually needed. Purged CV always trains the full n_rounds.
+        int early_stopping_rounds = 0;
+        
+        // Purged K-fold cross-validation: folds, with embargo (in bars) as the embargo and
+        // tuning_jobs as the number of folds trained at once. Tuning scores each
+        // combination by its mean over the same folds unless tuning_validation opts out.
+        int cv_folds = 5;
+        TuningValidation tuning_validation = TuningValidation::PURGED_CV;
     };
 
     template<typename LabelType>
@@ -128,6 +150,9 @@ namespace MLPipeline {
         const UnifiedPipelineConfig& config
     );
 
+    // Tunes on the chronological split only: throws std::invalid_argument unless
+    // config.tuning_validation is CHRONOLOGICAL_SPLIT. The PipelineConfig overloads
+    // above always tune that way.
     PipelineResult runPipelineWithTuning(
         const std::vector<std::map<std::string, double>>& X,
         const std::vector<int>& y,
@@ -135,6 +160,16 @@ namespace MLPipeline {
         UnifiedPipelineConfig config
     );
 
+    // windows holds each sample's label window (see eventWindows), one per row of X.
+    // Under PURGED_CV, rows with non-finite features or labels are left out of the folds.
+    PipelineResult runPipelineWithTuning(
+        const std::vector<std::map<std::string, double>>& X,
+        const std::vector<int>& y,
+        const std::vector<double>& returns,
+        const std::vector<MLSplitUtils::EventWindow>& windows,
+        UnifiedPipelineConfig config
+    );
+
     RegressionPipelineResult runPipelineRegression(
         const std::vector<std::map<std::string, double>>& X,
         const std::vector<double>& y,
@@ -148,4 +183,30 @@ namespace MLPipeline {
         const std::vector<double>& returns,
         UnifiedPipelineConfig config
     );
+
+    RegressionPipelineResult runPipelineRegressionWithTuning(
+        const std::vector<std::map<std::string, double>>& X,
+        const std::vector<double>& y,
+        const std::vector<double>& returns,
+        const std::vector<MLSplitUtils::EventWindow>& windows,
+        UnifiedPipelineConfig config
+    );
+
+    // Purged K-fold estimate of the configured model. Rows must be events in entry order
+    // with their label windows (see eventWindows); they are used as given, so X must
+    // already be free of NaN and inf values. Tuning under PURGED_CV scores each
+    // combination with the same folds.
+    CrossValidationResult runCrossValidation(
+        const std::vector<std::map<std::string, double>>& X,
+        const std::vector<int>& y,
+        const std::vector<MLSplitUtils::EventWindow>& windows,
+        const UnifiedPipelineConfig& config
+    );
+
+    CrossValidationResult runCrossValidation(
+        const std::vector<std::map<std::string, double>>& X,
+        const std::vector<double>& y,
+        const std::vector<MLSplitUtils::EventWindow>& windows,
+        const UnifiedPipelineConfig& config
+    );
 }
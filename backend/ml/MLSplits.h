@@ -4,7 +4,10 @@
 #include <string>
 #include <tuple>
 #include <algorithm>
+#include <cstring>
 #include <stdexcept>
+#include <utility>
+#include "DenseMatrix.h"
 
 namespace MLSplitUtils {
     struct SplitResult {
@@ -17,6 +20,138 @@ namespace MLSplitUtils {
         std::vector<size_t> val_indices;
     };
 
+    // Half-open run [begin, end) of consecutive sample indices.
+    struct IndexRange {
+        size_t begin = 0;
+        size_t end = 0;
+
+        size_t size() const { return end - begin; }
+        bool operator==(const IndexRange& other) const { return begin == other.begin && end == other.end; }
+        bool operator<(const IndexRange& other) const {
+            return begin != other.begin ? begin < other.begin : end < other.end;
+        }
+    };
+
+    // Sorted, disjoint, non-adjacent ranges.
+    using RangeList = std::vector<IndexRange>;
+
+    // A fold as index ranges: a split of N samples takes a handful of ranges per fold
+    // instead of N indices.
+    struct RangeFold {
+        RangeList train;
+        RangeList val;
+    };
+
+    // One train/test split of combinatorial purged CV: the test set is the union of
+    // test_groups (ascending), fold.val covers their samples.
+    struct CombinatorialSplit {
+        std::vector<size_t> test_groups;
+        RangeFold fold;
+    };
+
+    // Bars a sample's label depends on: from its entry to the bar its barrier was hit
+    // (inclusive), in positions of the underlying price series.
+    struct EventWindow {
+        size_t start = 0;
+        size_t end = 0;
+    };
+
+    inline size_t rangeCount(const RangeList& ranges) {
+        size_t n = 0;
+        for (const auto& r : ranges) n += r.size();
+        return n;
+    }
+
+    // Appends [begin, end), merging it into the last range when they touch.
+    inline void appendRange(RangeList& ranges, size_t begin, size_t end) {
+        if (begin >= end) return;
+        if (!ranges.empty() && ranges.back().end >= begin) {
+            ranges.back().end = std::max(ranges.back().end, end);
+        } else {
+            ranges.push_back({begin, end});
+        }
+    }
+
+    // Number of selected indices below i, i.e. the position of i in the expanded list.
+    inline size_t rankInRanges(const RangeList& ranges, size_t i) {
+        size_t rank = 0;
+        for (const auto& r : ranges) {
+            if (i <= r.begin) break;
+            rank += std::min(i, r.end) - r.begin;
+        }
+        return rank;
+    }
+
+    inline std::vector<size_t> expandRanges(const RangeList& ranges) {
+        std::vector<size_t> indices;
+        indices.reserve(rangeCount(ranges));
+        for (const auto& r : ranges) {
+            for (size_t i = r.begin; i < r.end; ++i) indices.push_back(i);
+        }
+        return indices;
+    }
+
+    inline PurgedFold expandFold(const RangeFold& fold) {
+        return {expandRanges(fold.train), expandRanges(fold.val)};
+    }
+
+    // Elements of data at the selected indices, copied range by range.
+    template<typename T>
+    std::vector<T> selectRanges(const std::vector<T>& data, const RangeList& ranges) {
+        std::vector<T> out;
+        out.reserve(rangeCount(ranges));
+        for (const auto& r : ranges) {
+            if (r.end > data.size()) {
+                throw std::out_of_range("Range end " + std::to_string(r.end) + " out of range for data size " +
+                                        std::to_string(data.size()));
+            }
+            out.insert(out.end(), data.begin() + r.begin, data.begin() + r.end);
+        }
+        return out;
+    }
+
+    // The rows of a matrix selected by a range list, without copying them. Each range is
+    // a block that can be handed out as a strided view of the original buffer.
+    struct RowRangeView {
+        MLPipeline::DenseMatrixView matrix;
+        RangeList ranges;
+
+        RowRangeView() = default;
+        RowRangeView(const MLPipeline::DenseMatrixView& matrix_, RangeList ranges_)
+            : matrix(matrix_), ranges(std::move(ranges_)) {
+            if (!ranges.empty() && ranges.back().end > matrix.rows) {
+                throw std::out_of_range("Row range exceeds the matrix");
+            }
+        }
+
+        size_t rows() const { return rangeCount(ranges); }
+        size_t cols() const { return matrix.cols; }
+        size_t blocks() const { return ranges.size(); }
+        MLPipeline::DenseMatrixView block(size_t k) const { return matrix.rowRange(ranges[k].begin, ranges[k].end); }
+        bool isSingleBlock() const { return ranges.size() == 1; }
+
+        // Contiguous copy of the selected rows, one block copy per range.
+        MLPipeline::FlatFloatMatrix gather() const {
+            MLPipeline::FlatFloatMatrix out;
+            out.rows = rows();
+            out.cols = matrix.cols;
+            out.values.resize(out.rows * out.cols);
+            float* dst = out.values.data();
+            for (size_t k = 0; k < ranges.size(); ++k) {
+                MLPipeline::DenseMatrixView b = block(k);
+                if (b.contiguous()) {
+                    std::memcpy(dst, b.data, b.rows * b.cols * sizeof(float));
+                    dst += b.rows * b.cols;
+                } else {
+                    for (size_t i = 0; i < b.rows; ++i, dst += b.cols) {
+                        std::memcpy(dst, b.row(i), b.cols * sizeof(float));
+                    }
+                }
+            }
+            return out;
+        }
+    };
+
     inline SplitResult chronologicalSplit(
         const std::vector<std::map<std::string, double>>& X,
         const std::vector<int>& y,
@@ -38,7 +173,25 @@ namespace MLSplitUtils {
         return result;
     }
 
-    inline std::vector<PurgedFold> purgedKFoldSplit(
+    // [begin, end) sample range of each of n_groups contiguous groups; the last group
+    // takes the remainder.
+    inline std::vector<IndexRange> contiguousGroups(size_t N, int n_groups) {
+        if (N == 0 || n_groups <= 0 || static_cast<size_t>(n_groups) > N) {
+            throw std::invalid_argument("Invalid number of groups");
+        }
+        std::vector<IndexRange> groups;
+        groups.reserve(n_groups);
+        size_t group_size = N / n_groups;
+        for (int g = 0; g < n_groups; ++g) {
+            size_t begin = g * group_size;
+            size_t end = (g == n_groups - 1) ? N : begin + group_size;
+            groups.push_back({begin, end});
+        }
+        return groups;
+    }
+
+    // K contiguous validation blocks; training drops `embargo` samples on either side.
+    inline std::vector<RangeFold> purgedKFoldRanges(
         size_t N,
         int n_splits = 5,
         int embargo = 0
@@ -46,44 +199,194 @@ namespace MLSplitUtils {
         if (N == 0 || n_splits <= 0) {
             throw std::invalid_argument("Invalid parameters for purged K-fold split");
         }
-        
-        std::vector<PurgedFold> folds;
+        const size_t gap = static_cast<size_t>(std::max(0, embargo));
+        std::vector<RangeFold> folds;
+        folds.reserve(n_splits);
         size_t fold_size = N / n_splits;
-        
+
         for (int k = 0; k < n_splits; ++k) {
             size_t val_start = k * fold_size;
             size_t val_end = (k == n_splits - 1) ? N : (val_start + fold_size);
-            
-            std::vector<size_t> val_indices, train_indices;
-            
-            for (size_t i = val_start; i < val_end; ++i) {
-                val_indices.push_back(i);
+
+            RangeFold fold;
+            appendRange(fold.val, val_start, val_end);
+            appendRange(fold.train, 0, val_start > gap ? val_start - gap : 0);
+            appendRange(fold.train, std::min(N, val_end + gap), N);
+            folds.push_back(std::move(fold));
+        }
+        return folds;
+    }
+
+    inline std::vector<PurgedFold> purgedKFoldSplit(
+        size_t N,
+        int n_splits = 5,
+        int embargo = 0
+    ) {
+        std::vector<PurgedFold> folds;
+        for (const auto& fold : purgedKFoldRanges(N, n_splits, embargo)) {
+            folds.push_back(expandFold(fold));
+        }
+        return folds;
+    }
+
+    namespace detail {
+        inline void validateWindows(const std::vector<EventWindow>& windows) {
+            for (const auto& w : windows) {
+                if (w.end < w.start) {
+                    throw std::invalid_argument("Event window ends before it starts");
+                }
+            }
+        }
+
+        // Bars covered by the windows of the samples in [r.begin, r.end).
+        inline EventWindow span(const std::vector<EventWindow>& windows, const IndexRange& r) {
+            EventWindow s = windows[r.begin];
+            for (size_t i = r.begin; i < r.end; ++i) {
+                s.start = std::min(s.start, windows[i].start);
+                s.end = std::max(s.end, windows[i].end);
             }
-            
-            for (size_t i = 0; i < N; ++i) {
-                if (i >= val_start && i < val_end) {
+            return s;
+        }
+
+        // Every sample outside the test groups whose window neither overlaps a test group's
+        // span nor starts within embargo_bars bars after one.
+        inline RangeList purgedTrainRanges(
+            const std::vector<EventWindow>& windows,
+            const std::vector<IndexRange>& test_groups,
+            size_t embargo_bars
+        ) {
+            std::vector<EventWindow> spans;
+            spans.reserve(test_groups.size());
+            for (const auto& g : test_groups) spans.push_back(span(windows, g));
+
+            RangeList train;
+            size_t next_test = 0;
+            for (size_t i = 0; i < windows.size(); ++i) {
+                while (next_test < test_groups.size() && test_groups[next_test].end <= i) ++next_test;
+                if (next_test < test_groups.size() && test_groups[next_test].begin <= i) {
+                    i = test_groups[next_test].end - 1;
                     continue;
                 }
-                
-                bool in_embargo = false;
-                if (embargo > 0) {
-                    if (i >= val_start - embargo && i < val_start) {
-                        in_embargo = true;
-                    }
-                    
-                    if (i >= val_end && i < val_end + embargo) {
-                        in_embargo = true;
+                const auto& w = windows[i];
+                bool excluded = false;
+                for (const auto& s : spans) {
+                    bool overlaps = w.start <= s.end && w.end >= s.start;
+                    bool embargoed = w.start > s.end && w.start <= s.end + embargo_bars;
+                    if (overlaps || embargoed) {
+                        excluded = true;
+                        break;
                     }
                 }
-                
-                if (!in_embargo) {
-                    train_indices.push_back(i);
-                }
+                if (!excluded) appendRange(train, i, i + 1);
             }
-            
-            folds.push_back({train_indices, val_indices});
+            return train;
+        }
+    }
+
+    // K contiguous validation blocks in sample order (samples sorted by entry). A training
+    // sample is purged when its window overlaps the span covered by the block's windows,
+    // and embargoed when it starts within embargo_bars bars after that span ends, so no
+    // training label is resolved with information from the validation period.
+    inline std::vector<RangeFold> purgedKFoldRanges(
+        const std::vector<EventWindow>& windows,
+        int n_splits,
+        size_t embargo_bars = 0
+    ) {
+        if (windows.empty() || n_splits <= 0 || static_cast<size_t>(n_splits) > windows.size()) {
+            throw std::invalid_argument("Invalid parameters for purged K-fold split");
+        }
+        detail::validateWindows(windows);
+
+        std::vector<RangeFold> folds;
+        folds.reserve(n_splits);
+        for (const auto& block : contiguousGroups(windows.size(), n_splits)) {
+            RangeFold fold;
+            fold.val.push_back(block);
+            fold.train = detail::purgedTrainRanges(windows, {block}, embargo_bars);
+            folds.push_back(std::move(fold));
         }
-        
         return folds;
     }
+
+    inline std::vector<PurgedFold> purgedKFoldSplit(
+        const std::vector<EventWindow>& windows,
+        int n_splits,
+        size_t embargo_bars = 0
+    ) {
+        std::vector<PurgedFold> folds;
+        for (const auto& fold : purgedKFoldRanges(windows, n_splits, embargo_bars)) {
+            folds.push_back(expandFold(fold));
+        }
+        return folds;
+    }
+
+    // Every choice of n_test_groups of the n_groups contiguous groups as the test set, in
+    // lexicographic order of the chosen groups. Each test group purges and embargoes the
+    // training set on its own span, exactly as a validation block of purgedKFoldRanges.
+    inline std::vector<CombinatorialSplit> combinatorialPurgedSplit(
+        const std::vector<EventWindow>& windows,
+        int n_groups,
+        int n_test_groups,
+        size_t embargo_bars = 0
+    ) {
+        if (n_test_groups <= 0 || n_test_groups >= n_groups) {
+            throw std::invalid_argument("Combinatorial purged CV needs 0 < test groups < groups");
+        }
+        auto groups = contiguousGroups(windows.size(), n_groups);
+        detail::validateWindows(windows);
+
+        std::vector<CombinatorialSplit> splits;
+        std::vector<size_t> chosen(n_test_groups);
+        for (int j = 0; j < n_test_groups; ++j) chosen[j] = j;
+
+        while (true) {
+            CombinatorialSplit split;
+            split.test_groups = chosen;
+            std::vector<IndexRange> test;
+            for (size_t g : chosen) {
+                test.push_back(groups[g]);
+                appendRange(split.fold.val, groups[g].begin, groups[g].end);
+            }
+            split.fold.train = detail::purgedTrainRanges(windows, test, embargo_bars);
+            splits.push_back(std::move(split));
+
+            int j = n_test_groups - 1;
+            while (j >= 0 && chosen[j] == static_cast<size_t>(n_groups - n_test_groups + j)) --j;
+            if (j < 0) break;
+            ++chosen[j];
+            for (int m = j + 1; m < n_test_groups; ++m) chosen[m] = chosen[m - 1] + 1;
+        }
+        return splits;
+    }
+
+    // Backtest paths through combinatorial splits: path p takes group g's out-of-sample
+    // predictions from the p-th split (in split order) that tests g. Every group is tested
+    // by C(n_groups - 1, n_test_groups - 1) splits, which is the number of paths.
+    inline std::vector<std::vector<size_t>> combinatorialPaths(
+        const std::vector<CombinatorialSplit>& splits,
+        int n_groups
+    ) {
+        std::vector<std::vector<size_t>> testing(n_groups);
+        for (size_t s = 0; s < splits.size(); ++s) {
+            for (size_t g : splits[s].test_groups) {
+                if (g >= static_cast<size_t>(n_groups)) {
+                    throw std::invalid_argument("Split tests a group out of range");
+                }
+                testing[g].push_back(s);
+            }
+        }
+        size_t n_paths = testing.empty() ? 0 : testing.front().size();
+        for (const auto& t : testing) {
+            if (t.size() != n_paths) {
+                throw std::invalid_argument("Splits do not test every group equally often");
+            }
+        }
+        std::vector<std::vector<size_t>> paths(n_paths, std::vector<size_t>(n_groups));
+        for (size_t p = 0; p < n_paths; ++p) {
+            for (int g = 0; g < n_groups; ++g) {
+                paths[p][g] = testing[g][p];
+            }
+        }
+        return paths;
+    }
 }
@@ -49,6 +49,46 @@ ModelUtils::toFloatMatrix(const std::vector<std::map<std::string, double>>& X, b
     return result;
 }
 
+FlatFloatMatrix
+ModelUtils::toFlatFloatMatrix(const std::vector<std::map<std::string, double>>& X,
+                              const std::vector<size_t>* row_indices,
+                              bool validate_input) {
+    if (validate_input && X.empty()) {
+        throw std::invalid_argument("Input matrix cannot be empty");
+    }
+    
+    FlatFloatMatrix result;
+    if (X.empty()) {
+        return result;
+    }
+    
+    std::set<std::string> feature_names_set;
+    for (const auto& row : X) {
+        for (const auto& [key, value] : row) {
+            feature_names_set.insert(key);
+        }
+    }
+    result.feature_names.assign(feature_names_set.begin(), feature_names_set.end());
+    result.cols = result.feature_names.size();
+    result.rows = row_indices ? row_indices->size() : X.size();
+    result.values.assign(result.rows * result.cols, 0.0f);
+    
+    for (size_t i = 0; i < result.rows; ++i) {
+        const auto& row = X[row_indices ? (*row_indices)[i] : i];
+        float* out = result.values.data() + i * result.cols;
+        size_t j = 0;
+        for (const auto& [key, value] : row) {
+            while (result.feature_names[j] != key) ++j;
+            if (validate_input && (std::isnan(value) || std::isinf(value))) {
+                throw std::invalid_argument("Input contains NaN or Inf values in feature: " + key);
+            }
+            out[j] = static_cast<float>(value);
+        }
+    }
+    
+    return result;
+}
+
 std::vector<float> 
 ModelUtils::toFloatVecInt(const std::vector<int>& y, bool validate_input) {
     if (validate_input && y.empty()) {
@@ -609,6 +649,16 @@ toFloatMatrix(const std::vector<std::map<std::string, double>>& X) {
     return ModelUtils::toFloatMatrix(X, false);
 }
 
+FlatFloatMatrix
+toFlatFloatMatrix(const std::vector<std::map<std::string, double>>& X) {
+    return ModelUtils::toFlatFloatMatrix(X, nullptr, false);
+}
+
+FlatFloatMatrix
+toFlatFloatMatrix(const std::vector<std::map<std::string, double>>& X, const std::vector<size_t>& row_indices) {
+    return ModelUtils::toFlatFloatMatrix(X, &row_indices, false);
+}
+
 std::vector<float> 
 toFloatVecInt(const std::vector<int>& y) {
     return ModelUtils::toFloatVecInt(y, false); 
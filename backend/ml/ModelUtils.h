@@ -3,6 +3,7 @@
 #include <map>
 #include <string>
 #include <memory>
+#include "DenseMatrix.h"
 
 namespace MLPipeline {
 
@@ -12,6 +13,14 @@ public:
     toFloatMatrix(const std::vector<std::map<std::string, double>>& X, 
                   bool validate_input = true);
     
+    // Converts straight into one contiguous row-major buffer (columns sorted by name,
+    // missing entries 0), optionally gathering only the given rows. Feature names are
+    // taken from all of X so subsets of the same data share a column layout.
+    static FlatFloatMatrix
+    toFlatFloatMatrix(const std::vector<std::map<std::string, double>>& X,
+                      const std::vector<size_t>* row_indices = nullptr,
+                      bool validate_input = true);
+    
     static std::vector<float> 
     toFloatVecInt(const std::vector<int>& y, bool validate_input = true);
     
@@ -103,6 +112,12 @@ private:
 std::vector<std::vector<float>> 
 toFloatMatrix(const std::vector<std::map<std::string, double>>& X);
 
+FlatFloatMatrix
+toFlatFloatMatrix(const std::vector<std::map<std::string, double>>& X);
+
+FlatFloatMatrix
+toFlatFloatMatrix(const std::vector<std::map<std::string, double>>& X, const std::vector<size_t>& row_indices);
+
 std::vector<float> 
 toFloatVecInt(const std::vector<int>& y);
 
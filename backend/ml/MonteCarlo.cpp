@@ -0,0 +1,147 @@
+#include "MonteCarlo.h"
+#include "../utils/ParallelUtils.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace MLPipeline {
+
+namespace {
+    struct Outcome {
+        double total_return = 0.0;
+        double max_drawdown = 0.0;
+        double win_rate = 0.0;
+    };
+
+    // Simulations are drawn in fixed chunks, each with its own generator seeded from
+    // (seed, chunk), so results do not depend on how chunks land on threads.
+    constexpr size_t kChunk = 64;
+
+    template<typename Simulate>
+    std::vector<Outcome> runSimulations(const MonteCarloConfig& config, Simulate&& simulate) {
+        if (config.simulations == 0) {
+            throw std::invalid_argument("Monte Carlo needs at least one simulation");
+        }
+        if (!(config.confidence > 0.0 && config.confidence < 1.0)) {
+            throw std::invalid_argument("Confidence must be in (0, 1)");
+        }
+        std::vector<Outcome> outcomes(config.simulations);
+        const size_t chunks = (config.simulations + kChunk - 1) / kChunk;
+        TripleBarrier::Parallel::parallelFor(chunks, config.max_threads, [&](size_t c) {
+            std::seed_seq seq{static_cast<uint32_t>(config.seed), static_cast<uint32_t>(config.seed >> 32),
+                              static_cast<uint32_t>(c)};
+            std::mt19937_64 rng(seq);
+            const size_t end = std::min(config.simulations, (c + 1) * kChunk);
+            for (size_t s = c * kChunk; s < end; ++s) {
+                outcomes[s] = simulate(rng);
+            }
+        });
+        return outcomes;
+    }
+
+    double quantile(const std::vector<double>& sorted, double q) {
+        double pos = q * (sorted.size() - 1);
+        size_t lo = static_cast<size_t>(pos);
+        size_t hi = std::min(lo + 1, sorted.size() - 1);
+        return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+    }
+
+    MetricDistribution distribution(std::vector<double> samples, double observed, double confidence) {
+        MetricDistribution d;
+        std::sort(samples.begin(), samples.end());
+        d.observed = observed;
+        double sum = 0.0;
+        for (double v : samples) sum += v;
+        d.mean = sum / samples.size();
+        d.lower = quantile(samples, (1.0 - confidence) / 2.0);
+        d.median = quantile(samples, 0.5);
+        d.upper = quantile(samples, (1.0 + confidence) / 2.0);
+        auto first_at_least = std::lower_bound(samples.begin(), samples.end(), observed);
+        d.p_value = static_cast<double>(samples.end() - first_at_least) / samples.size();
+        d.samples = std::move(samples);
+        return d;
+    }
+
+    MonteCarloResult summarize(const std::vector<Outcome>& outcomes, const Outcome& observed, double confidence) {
+        std::vector<double> total_return, max_drawdown, win_rate;
+        total_return.reserve(outcomes.size());
+        max_drawdown.reserve(outcomes.size());
+        win_rate.reserve(outcomes.size());
+        for (const auto& o : outcomes) {
+            total_return.push_back(o.total_return);
+            max_drawdown.push_back(o.max_drawdown);
+            win_rate.push_back(o.win_rate);
+        }
+        MonteCarloResult result;
+        result.simulations = outcomes.size();
+        result.total_return = distribution(std::move(total_return), observed.total_return, confidence);
+        result.max_drawdown = distribution(std::move(max_drawdown), observed.max_drawdown, confidence);
+        result.win_rate = distribution(std::move(win_rate), observed.win_rate, confidence);
+        return result;
+    }
+}
+
+MonteCarloResult bootstrapTrades(const PortfolioSimulation& portfolio, const MonteCarloConfig& config) {
+    if (portfolio.trade_log.empty()) {
+        throw std::invalid_argument("Bootstrap needs at least one trade");
+    }
+    if (!(config.mean_block_length >= 1.0)) {
+        throw std::invalid_argument("Mean block length must be at least 1");
+    }
+
+    // Returns relative to the capital at risk, so resampled sequences compound correctly.
+    std::vector<double> trade_returns;
+    trade_returns.reserve(portfolio.trade_log.size());
+    for (const auto& trade : portfolio.trade_log) {
+        trade_returns.push_back(trade.capital_before != 0.0 ? trade.trade_return / trade.capital_before : 0.0);
+    }
+    const size_t n = trade_returns.size();
+    const double start = portfolio.starting_capital;
+
+    auto outcomes = runSimulations(config, [&](std::mt19937_64& rng) {
+        std::uniform_int_distribution<size_t> pick(0, n - 1);
+        std::bernoulli_distribution new_block(1.0 / config.mean_block_length);
+        RiskMetricsAccumulator risk(start);
+        double capital = start;
+        size_t wins = 0;
+        size_t t = pick(rng);
+        for (size_t k = 0; k < n; ++k) {
+            if (k > 0) t = new_block(rng) ? pick(rng) : (t + 1) % n;
+            double pnl = capital * trade_returns[t];
+            capital += pnl;
+            if (pnl > 0) ++wins;
+            risk.add(capital);
+        }
+        RiskMetrics metrics = risk.metrics();
+        Outcome o;
+        o.total_return = metrics.total_return;
+        o.max_drawdown = metrics.max_drawdown;
+        o.win_rate = static_cast<double>(wins) / n;
+        return o;
+    });
+
+    Outcome observed{portfolio.total_return, portfolio.max_drawdown, portfolio.win_rate};
+    return summarize(outcomes, observed, config.confidence);
+}
+
+MonteCarloResult permuteSignals(
+    const std::vector<double>& trading_signals,
+    const std::vector<double>& returns,
+    const PortfolioConfig& portfolio_config,
+    const MonteCarloConfig& config
+) {
+    auto baseline = simulate_portfolio_sweep(trading_signals, returns, {portfolio_config}, 1);
+
+    auto outcomes = runSimulations(config, [&](std::mt19937_64& rng) {
+        std::vector<double> shuffled(trading_signals);
+        std::shuffle(shuffled.begin(), shuffled.end(), rng);
+        auto run = simulate_portfolio_sweep(shuffled, returns, {portfolio_config}, 1);
+        return Outcome{run.total_return[0], run.max_drawdown[0], run.win_rate[0]};
+    });
+
+    Outcome observed{baseline.total_return[0], baseline.max_drawdown[0], baseline.win_rate[0]};
+    return summarize(outcomes, observed, config.confidence);
+}
+
+}
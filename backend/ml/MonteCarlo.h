@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "PortfolioSimulator.h"
+
+namespace MLPipeline {
+
+struct MonteCarloConfig {
+    size_t simulations = 1000;
+    double mean_block_length = 5.0;  // expected length of a stationary-bootstrap block, in trades
+    double confidence = 0.95;        // central mass of the reported interval
+    uint64_t seed = 42;
+    unsigned max_threads = 0;        // 0 = all cores
+};
+
+// Distribution of one metric over the resampled backtests.
+struct MetricDistribution {
+    std::vector<double> samples;  // one per simulation, sorted ascending
+    double observed = 0.0;        // value on the original backtest
+    double mean = 0.0;
+    double lower = 0.0;           // (1 - confidence) / 2 quantile
+    double median = 0.0;
+    double upper = 0.0;           // (1 + confidence) / 2 quantile
+    double p_value = 0.0;         // share of samples at least as large as observed
+};
+
+struct MonteCarloResult {
+    size_t simulations = 0;
+    MetricDistribution total_return;
+    MetricDistribution max_drawdown;
+    MetricDistribution win_rate;
+};
+
+// Stationary block bootstrap of the trades of `portfolio`: each simulation redraws as
+// many trades as were booked, in blocks of geometric length, and compounds their
+// returns on the starting capital. Drawdown and win rate follow simulate_portfolio.
+MonteCarloResult bootstrapTrades(const PortfolioSimulation& portfolio, const MonteCarloConfig& config = {});
+
+// Permutation test of the signals: each simulation shuffles the signals against the
+// returns and reruns the portfolio simulation, so p_value estimates how often timing
+// that carries no information does at least as well.
+MonteCarloResult permuteSignals(
+    const std::vector<double>& trading_signals,
+    const std::vector<double>& returns,
+    const PortfolioConfig& portfolio_config = PortfolioConfig{},
+    const MonteCarloConfig& config = {}
+);
+
+}
@@ -1,15 +1,45 @@
 #include "PortfolioSimulator.h"
 #include "../data/LabeledEvent.h"
 #include "../data/PreprocessedRow.h"
+#include "../data/EventIndexUtils.h"
+#include "../utils/ParallelUtils.h"
 #include <algorithm>
 #include <cmath>
 #include <stdexcept>
-#include <iostream>
-#include <numeric>
+#include <ostream>
 #include <iomanip>
 
 namespace MLPipeline {
 
+const char* toString(TradeDecision decision) {
+    switch (decision) {
+        case TradeDecision::BUY: return "BUY";
+        case TradeDecision::SELL: return "SELL";
+        default: return "HOLD";
+    }
+}
+
+void formatTrade(std::ostream& out, const TradeLogEntry& entry, int trade_number) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2)
+        << "Index " << entry.index << ": "
+        << "Trade " << trade_number << ": " << toString(entry.decision);
+    if (entry.decision != TradeDecision::HOLD) {
+        out << " " << std::abs(entry.position_pct) * 100 << "%";
+    }
+    out << ", PnL: " << entry.trade_return << ", Capital: " << entry.capital_after;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+TradeSink streamTradeSink(std::ostream& out) {
+    return [&out](const TradeLogEntry& entry, int trade_number) {
+        formatTrade(out, entry, trade_number);
+        out << '\n';
+    };
+}
+
 PortfolioSimulation simulate_portfolio(
     const std::vector<double>& trading_signals,
     const std::vector<double>& returns,
@@ -22,163 +52,253 @@ PortfolioSimulation simulate_portfolio(
         throw std::invalid_argument("Signals and returns must have the same size");
     }
     
+    const double threshold = portfolio_config.position_threshold;
+    const double max_position = portfolio_config.hard_barrier_position_pct;
+    
+    // Size the logs up front so the loop below only does arithmetic.
+    size_t expected_trades = 0;
+    for (double signal : trading_signals) {
+        if (signal > threshold || signal < -threshold) ++expected_trades;
+    }
+    
     double capital = portfolio_config.starting_capital;
-    double max_capital = capital;
-    double min_capital = capital;
-    std::vector<double> capital_history;
-    capital_history.push_back(capital);
+    RiskMetricsAccumulator risk(capital, portfolio_config.equity_curve_points);
     
     int total_trades = 0;
     int winning_trades = 0;
-    std::vector<std::string> trade_decisions;
+    std::vector<TradeDecision> trade_decisions(
+        std::min(trading_signals.size(),
+                 static_cast<size_t>(std::max(portfolio_config.max_trade_decisions_logged, 0))));
     std::vector<double> trade_returns;
     std::vector<TradeLogEntry> trade_log;
+    trade_returns.reserve(expected_trades);
+    trade_log.reserve(expected_trades);
 
     for (size_t i = 0; i < trading_signals.size(); ++i) {
-        double position_pct = 0;
-        std::string decision;
-        double trade_capital = capital;
-        position_pct = std::min(std::abs(trading_signals[i]) * portfolio_config.hard_barrier_position_pct, portfolio_config.hard_barrier_position_pct);
-        if (trading_signals[i] < 0) position_pct = -position_pct;
+        const double signal = trading_signals[i];
+        TradeDecision decision = signal > threshold ? TradeDecision::BUY
+                               : signal < -threshold ? TradeDecision::SELL
+                               : TradeDecision::HOLD;
+        double position_pct = 0.0;
         
-        if (trading_signals[i] > portfolio_config.position_threshold) {
-            decision = "BUY " + std::to_string(position_pct * 100) + "%";
-        } else if (trading_signals[i] < -portfolio_config.position_threshold) {
-            decision = "SELL " + std::to_string(std::abs(position_pct) * 100) + "%";
-        } else {
-            decision = "HOLD";
-        }
-        
-        if (decision != "HOLD") {
+        if (decision != TradeDecision::HOLD) {
+            position_pct = std::min(std::abs(signal) * max_position, max_position);
+            if (signal < 0) position_pct = -position_pct;
+            
             total_trades++;
+            double trade_capital = capital;
             double pnl = position_pct * trade_capital * returns[i];
             capital += pnl;
 
             trade_returns.push_back(pnl); 
             if (pnl > 0) winning_trades++;
 
-            std::cout << std::fixed << std::setprecision(2)
-                        << "Index " << i << ": "
-                      << "Trade " << total_trades << ": " << decision
-                      << ", PnL: " << pnl << ", Capital: " << capital << std::endl;
-
             trade_log.push_back(TradeLogEntry{
                 i,
-                trading_signals[i],
+                signal,
                 pnl,
                 trade_capital,
-                capital
+                capital,
+                decision,
+                position_pct
             });
+            if (portfolio_config.trade_sink) {
+                portfolio_config.trade_sink(trade_log.back(), total_trades);
+            }
         }
+        risk.add(capital, position_pct);
         
-        max_capital = std::max(max_capital, capital);
-        min_capital = std::min(min_capital, capital);
-        capital_history.push_back(capital);
-        
-        if (trade_decisions.size() < static_cast<size_t>(portfolio_config.max_trade_decisions_logged)) {
-            trade_decisions.push_back(decision);
+        if (i < trade_decisions.size()) {
+            trade_decisions[i] = decision;
         }
     }
     
-    double total_return = (capital - portfolio_config.starting_capital) / portfolio_config.starting_capital;
-    double max_drawdown = (max_capital - min_capital) / max_capital;
-    double avg_daily_return = total_return / trading_signals.size();
-    double daily_variance = 0;
+    RiskMetrics metrics = risk.metrics();
+    
+    PortfolioSimulation simulation;
+    simulation.starting_capital = portfolio_config.starting_capital;
+    simulation.final_capital = capital;
+    simulation.total_return = metrics.total_return;
+    simulation.max_drawdown = metrics.max_drawdown;
+    simulation.total_trades = total_trades;
+    simulation.win_rate = total_trades > 0 ? winning_trades / static_cast<double>(total_trades) : 0;
+    simulation.trade_decisions = std::move(trade_decisions);
+    simulation.trade_returns = std::move(trade_returns);
+    simulation.trade_log = std::move(trade_log);
+    simulation.max_drawdown_duration = metrics.max_drawdown_duration;
+    simulation.sharpe = metrics.sharpe;
+    simulation.sortino = metrics.sortino;
+    simulation.turnover = metrics.turnover;
+    simulation.equity_curve = risk.curve();
+    return simulation;
+}
 
-    if (capital_history.size() > 1) {
-        for (size_t i = 1; i < capital_history.size(); ++i) {
-            double daily_ret = (capital_history[i] - capital_history[i-1]) / capital_history[i-1];
-            daily_variance += (daily_ret - avg_daily_return) * (daily_ret - avg_daily_return);
-        }
-        daily_variance /= (capital_history.size() - 1);
+PortfolioSweep simulate_portfolio_sweep(
+    const std::vector<double>& trading_signals,
+    const std::vector<double>& returns,
+    const std::vector<PortfolioConfig>& configs,
+    unsigned max_threads
+) {
+    if (trading_signals.empty() || returns.empty()) {
+        throw std::invalid_argument("Signals and returns cannot be empty");
     }
-
-    double daily_std = std::sqrt(daily_variance);
-    double win_rate = total_trades > 0 ? winning_trades / static_cast<double>(total_trades) : 0;
-    
-    return PortfolioSimulation{
-        portfolio_config.starting_capital,
-        capital,
-        total_return,
-        max_drawdown,
-        total_trades,
-        win_rate,
-        trade_decisions,
-        trade_returns,
-        trade_log
-    };
+    if (trading_signals.size() != returns.size()) {
+        throw std::invalid_argument("Signals and returns must have the same size");
+    }
+    
+    const size_t M = configs.size();
+    const size_t N = trading_signals.size();
+    PortfolioSweep sweep;
+    sweep.final_capital.resize(M);
+    sweep.total_return.resize(M);
+    sweep.max_drawdown.resize(M);
+    sweep.total_trades.resize(M);
+    sweep.win_rate.resize(M);
+    sweep.sharpe.resize(M);
+    sweep.sortino.resize(M);
+    
+    // Each block keeps its running capital, thresholds and risk statistics in parallel
+    // arrays and walks the events once, updating every configuration per event with
+    // selects instead of branches. The statistics are the ones RiskMetricsAccumulator
+    // keeps (Welford mean and variance of the period returns, downside squares, running
+    // peak), laid out per field so the whole block updates in one vector pass.
+    constexpr size_t kBlock = 64;
+    const size_t blocks = (M + kBlock - 1) / kBlock;
+    
+    TripleBarrier::Parallel::parallelFor(blocks, max_threads, [&](size_t b) {
+        const size_t begin = b * kBlock;
+        const size_t count = std::min(kBlock, M - begin);
+        
+        double threshold[kBlock], max_position[kBlock], capital[kBlock], trades[kBlock], wins[kBlock];
+        double mean[kBlock], m2[kBlock], downside_sq[kBlock], peak[kBlock], max_drawdown[kBlock];
+        for (size_t m = 0; m < count; ++m) {
+            const auto& config = configs[begin + m];
+            threshold[m] = config.position_threshold;
+            max_position[m] = config.hard_barrier_position_pct;
+            capital[m] = peak[m] = config.starting_capital;
+            trades[m] = wins[m] = 0.0;
+            mean[m] = m2[m] = downside_sq[m] = max_drawdown[m] = 0.0;
+        }
+        
+        for (size_t i = 0; i < N; ++i) {
+            const double signal = trading_signals[i];
+            const double strength = std::abs(signal);
+            const double direction = signal < 0 ? -1.0 : 1.0;
+            const double r = returns[i];
+            const double periods = static_cast<double>(i + 1);
+            
+            for (size_t m = 0; m < count; ++m) {
+                // |signal| > threshold is exactly the BUY/SELL test of simulate_portfolio. The
+                // position is selected rather than scaled by `traded`, so a NaN signal holds
+                // (0 * NaN would poison the capital).
+                const double traded = strength > threshold[m] ? 1.0 : 0.0;
+                const double position = traded > 0.0 ? direction * std::min(strength * max_position[m], max_position[m]) : 0.0;
+                const double before = capital[m];
+                const double pnl = position * before * r;
+                capital[m] = before + pnl;
+                trades[m] += traded;
+                wins[m] += pnl > 0 ? 1.0 : 0.0;
+                
+                const double period_return = before != 0.0 ? capital[m] / before - 1.0 : 0.0;
+                const double delta = period_return - mean[m];
+                mean[m] += delta / periods;
+                m2[m] += delta * (period_return - mean[m]);
+                downside_sq[m] += period_return < 0.0 ? period_return * period_return : 0.0;
+                peak[m] = std::max(peak[m], capital[m]);
+                const double drawdown = peak[m] > 0.0 ? (peak[m] - capital[m]) / peak[m] : 0.0;
+                max_drawdown[m] = std::max(max_drawdown[m], drawdown);
+            }
+        }
+        
+        for (size_t m = 0; m < count; ++m) {
+            const size_t k = begin + m;
+            const double start = configs[k].starting_capital;
+            const double stddev = N > 1 ? std::sqrt(m2[m] / (N - 1)) : 0.0;
+            const double downside = std::sqrt(downside_sq[m] / N);
+            sweep.final_capital[k] = capital[m];
+            sweep.total_return[k] = start != 0.0 ? (capital[m] - start) / start : 0.0;
+            sweep.max_drawdown[k] = max_drawdown[m];
+            sweep.total_trades[k] = static_cast<int>(trades[m]);
+            sweep.win_rate[k] = trades[m] > 0 ? wins[m] / trades[m] : 0;
+            sweep.sharpe[k] = stddev > 0.0 ? mean[m] / stddev : 0.0;
+            sweep.sortino[k] = downside > 0.0 ? mean[m] / downside : 0.0;
+        }
+    });
+    
+    return sweep;
 }
 
 BarrierDiagnostics analyzeBarriers(
     const std::vector<LabeledEvent>& labeledEvents,
-    const std::vector<PreprocessedRow>& rows
+    const std::vector<PreprocessedRow>& rows,
+    const BarrierHistogramConfig& histograms
 ) {
     BarrierDiagnostics diagnostics;
+    diagnostics.periods_to_exit.counts.assign(histograms.time_bins, 0);
+    diagnostics.barrier_distance_pct.bin_width = histograms.distance_bin_pct;
+    diagnostics.barrier_distance_pct.counts.assign(histograms.distance_bins, 0);
     
     if (labeledEvents.empty()) return diagnostics;
     
-    std::vector<double> entry_prices, profit_barriers, stop_barriers;
-    std::vector<int> profit_times, stop_times, time_times;
+    std::vector<int> entryIndices = EventIndexUtils::resolveEntryIndices(rows, labeledEvents);
     
-    for (const auto& event : labeledEvents) {
+    double profit_time_sum = 0.0, stop_time_sum = 0.0, time_time_sum = 0.0;
+    double entry_price_sum = 0.0, profit_barrier_sum = 0.0, stop_barrier_sum = 0.0;
+    size_t matched = 0;
+    
+    for (size_t i = 0; i < labeledEvents.size(); ++i) {
+        const auto& event = labeledEvents[i];
         if (event.label == 1) {
             diagnostics.profit_hits++;
-            profit_times.push_back(event.periods_to_exit);
+            profit_time_sum += event.periods_to_exit;
         } else if (event.label == -1) {
             diagnostics.stop_hits++;
-            stop_times.push_back(event.periods_to_exit);
+            stop_time_sum += event.periods_to_exit;
         } else {
             diagnostics.time_hits++;
-            time_times.push_back(event.periods_to_exit);
+            time_time_sum += event.periods_to_exit;
         }
+        diagnostics.periods_to_exit.add(event.periods_to_exit);
         
-        for (const auto& row : rows) {
-            if (row.timestamp == event.entry_time) {
-                diagnostics.avg_volatility += row.volatility;
-                diagnostics.max_volatility = std::max(diagnostics.max_volatility, row.volatility);
-                
-                if (diagnostics.min_volatility == 0.0) {
-                    diagnostics.min_volatility = row.volatility;
-                } else {
-                    diagnostics.min_volatility = std::min(diagnostics.min_volatility, row.volatility);
-                }
-                
-                double entry_price = row.price;
-                double exit_price = event.exit_price;
-                double price_move = std::abs(exit_price - entry_price);
-                double volatility = row.volatility;
-                
-                double estimated_multiple = volatility > 0 ? price_move / volatility : 0.0;
-                double profit_barrier = entry_price + estimated_multiple * volatility;
-                double stop_barrier = entry_price - estimated_multiple * volatility;
-                
-                entry_prices.push_back(entry_price);
-                profit_barriers.push_back(profit_barrier);
-                stop_barriers.push_back(stop_barrier);
-                break;
-            }
+        if (entryIndices[i] < 0) continue;
+        const auto& row = rows[entryIndices[i]];
+        
+        const double volatility = row.volatility;
+        diagnostics.avg_volatility += volatility;
+        diagnostics.max_volatility = std::max(diagnostics.max_volatility, volatility);
+        diagnostics.min_volatility = matched == 0 ? volatility : std::min(diagnostics.min_volatility, volatility);
+        
+        const double entry_price = row.price;
+        const double price_move = std::abs(event.exit_price - entry_price);
+        // The barriers are not stored on the event; assume they sat symmetrically at the
+        // distance the exit reached.
+        const double barrier_offset = volatility > 0 ? price_move : 0.0;
+        
+        entry_price_sum += entry_price;
+        profit_barrier_sum += entry_price + barrier_offset;
+        stop_barrier_sum += entry_price - barrier_offset;
+        if (entry_price != 0.0) {
+            diagnostics.barrier_distance_pct.add(price_move / entry_price * 100.0);
         }
+        ++matched;
     }
     
     diagnostics.avg_volatility /= labeledEvents.size();
     
-    if (!entry_prices.empty()) {
-        diagnostics.avg_entry_price = std::accumulate(entry_prices.begin(), entry_prices.end(), 0.0) / entry_prices.size();
-        diagnostics.avg_profit_barrier = std::accumulate(profit_barriers.begin(), profit_barriers.end(), 0.0) / profit_barriers.size();
-        diagnostics.avg_stop_barrier = std::accumulate(stop_barriers.begin(), stop_barriers.end(), 0.0) / stop_barriers.size();
+    if (matched > 0) {
+        diagnostics.avg_entry_price = entry_price_sum / matched;
+        diagnostics.avg_profit_barrier = profit_barrier_sum / matched;
+        diagnostics.avg_stop_barrier = stop_barrier_sum / matched;
         
         diagnostics.barrier_width_pct = ((diagnostics.avg_profit_barrier - diagnostics.avg_stop_barrier) / diagnostics.avg_entry_price) * 100.0;
         diagnostics.profit_distance_pct = ((diagnostics.avg_profit_barrier - diagnostics.avg_entry_price) / diagnostics.avg_entry_price) * 100.0;
         diagnostics.stop_distance_pct = ((diagnostics.avg_entry_price - diagnostics.avg_stop_barrier) / diagnostics.avg_entry_price) * 100.0;
     }
     
-    auto calc_avg = [](const std::vector<int>& vec) -> double {
-        return vec.empty() ? 0.0 : std::accumulate(vec.begin(), vec.end(), 0.0) / vec.size();
-    };
-    
-    diagnostics.avg_profit_time = calc_avg(profit_times);
-    diagnostics.avg_stop_time = calc_avg(stop_times);
-    diagnostics.avg_time_time = calc_avg(time_times);
+    auto average = [](double sum, int count) { return count > 0 ? sum / count : 0.0; };
+    diagnostics.avg_profit_time = average(profit_time_sum, diagnostics.profit_hits);
+    diagnostics.avg_stop_time = average(stop_time_sum, diagnostics.stop_hits);
+    diagnostics.avg_time_time = average(time_time_sum, diagnostics.time_hits);
     
     return diagnostics;
 }
@@ -1,30 +1,52 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
 #include <vector>
 #include <string>
+#include "RiskMetrics.h"
 
 struct LabeledEvent;
 struct PreprocessedRow;
 
 namespace MLPipeline {
 
+enum class TradeDecision : std::uint8_t {
+    HOLD,
+    BUY,
+    SELL
+};
+
+const char* toString(TradeDecision decision);
+
 struct TradeLogEntry {
     size_t index;
     double signal;
     double trade_return;
     double capital_before;
     double capital_after;
+    TradeDecision decision = TradeDecision::HOLD;
+    double position_pct = 0.0;  // signed fraction of capital put on the trade
 };
 
+// "Index 12: Trade 3: BUY 25.00%, PnL: 1.20, Capital: 1001.20"
+void formatTrade(std::ostream& out, const TradeLogEntry& entry, int trade_number);
+
 struct PortfolioSimulation {
     double starting_capital;
     double final_capital;
     double total_return;
-    double max_drawdown;
+    double max_drawdown;  // largest fall from a running peak of capital
     int total_trades;
     double win_rate;
-    std::vector<std::string> trade_decisions;
+    std::vector<TradeDecision> trade_decisions;  // first max_trade_decisions_logged signals
     std::vector<double> trade_returns; 
     std::vector<TradeLogEntry> trade_log; 
+    size_t max_drawdown_duration = 0;  // in signals
+    double sharpe = 0.0;               // per-signal returns; signals not traded count as 0
+    double sortino = 0.0;
+    double turnover = 0.0;             // mean fraction of capital traded per signal
+    EquityCurve equity_curve;
 };
 
 struct PortfolioResults {
@@ -43,6 +65,28 @@ struct PortfolioResults {
     std::vector<double> trade_returns;
 };
 
+// Fixed-width bins starting at `lower`; values past either end land in the edge bins.
+struct Histogram {
+    double lower = 0.0;
+    double bin_width = 1.0;
+    std::vector<int> counts;
+
+    void add(double value) {
+        if (counts.empty()) return;
+        const double pos = (value - lower) / bin_width;
+        const size_t last = counts.size() - 1;
+        if (!(pos > 0.0)) ++counts[0];
+        else if (pos >= static_cast<double>(last)) ++counts[last];
+        else ++counts[static_cast<size_t>(pos)];
+    }
+};
+
+struct BarrierHistogramConfig {
+    size_t time_bins = 50;             // one period each
+    size_t distance_bins = 40;
+    double distance_bin_pct = 0.25;    // width of a barrier-distance bin, in percent of entry price
+};
+
 struct BarrierDiagnostics {
     int profit_hits = 0;
     int stop_hits = 0;
@@ -59,13 +103,23 @@ struct BarrierDiagnostics {
     double barrier_width_pct = 0.0;
     double profit_distance_pct = 0.0;
     double stop_distance_pct = 0.0;
+    Histogram periods_to_exit;        // every event
+    Histogram barrier_distance_pct;   // |exit - entry| / entry of events matched to a row, in percent
 };
 
+// Called with each trade as it is booked, in signal order, and its 1-based trade number.
+using TradeSink = std::function<void(const TradeLogEntry& entry, int trade_number)>;
+
+// Sink writing each trade to `out` with formatTrade, one per line.
+TradeSink streamTradeSink(std::ostream& out);
+
 struct PortfolioConfig {
     double starting_capital = 1000.0;
     double position_threshold = 0.25;
     double hard_barrier_position_pct = 0.25;
     int max_trade_decisions_logged = 100;
+    size_t equity_curve_points = 256;  // bound on PortfolioSimulation::equity_curve; 0 disables it
+    TradeSink trade_sink;  // optional; trades are only formatted when a sink asks for it
 };
 
 PortfolioSimulation simulate_portfolio(
@@ -74,9 +128,37 @@ PortfolioSimulation simulate_portfolio(
     const PortfolioConfig& portfolio_config = PortfolioConfig{}
 );
 
+// Outcome of one simulate_portfolio run per configuration, stored column-wise so a
+// sweep can be scanned or plotted per metric.
+struct PortfolioSweep {
+    std::vector<double> final_capital;
+    std::vector<double> total_return;
+    std::vector<double> max_drawdown;
+    std::vector<int> total_trades;
+    std::vector<double> win_rate;
+    std::vector<double> sharpe;
+    std::vector<double> sortino;
+
+    size_t size() const { return final_capital.size(); }
+};
+
+// Evaluates every configuration against the same signals and returns in one pass over
+// the events, matching simulate_portfolio per configuration (trade sinks, decision
+// logs and equity curves are not used). Configurations are processed in blocks on up to max_threads
+// workers (0 = all cores).
+PortfolioSweep simulate_portfolio_sweep(
+    const std::vector<double>& trading_signals,
+    const std::vector<double>& returns,
+    const std::vector<PortfolioConfig>& configs,
+    unsigned max_threads = 0
+);
+
+// One pass over the events. Entry rows come from the indices carried on the events,
+// falling back to a timestamp index built once, so the cost is O(events + rows).
 BarrierDiagnostics analyzeBarriers(
     const std::vector<LabeledEvent>& labeledEvents,
-    const std::vector<PreprocessedRow>& rows
+    const std::vector<PreprocessedRow>& rows,
+    const BarrierHistogramConfig& histograms = BarrierHistogramConfig{}
 );
 
 } // namespace MLPipeline
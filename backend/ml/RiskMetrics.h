@@ -0,0 +1,117 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace MLPipeline {
+
+// Equity sampled every `stride` periods from the start (period 0), plus the final
+// period when it falls between samples.
+struct EquityCurve {
+    size_t stride = 1;
+    std::vector<double> points;
+};
+
+struct RiskMetrics {
+    size_t periods = 0;
+    double final_equity = 0.0;
+    double total_return = 0.0;
+    double max_drawdown = 0.0;          // largest fall from a running peak, as a fraction of that peak
+    size_t max_drawdown_duration = 0;   // longest stretch of periods spent below an earlier peak
+    double sharpe = 0.0;                // mean over standard deviation of the period returns
+    double sortino = 0.0;               // mean over downside deviation of the period returns
+    double turnover = 0.0;              // mean fraction of equity traded per period
+};
+
+// Single-pass risk statistics over an equity series, fed one period at a time. Keeps
+// O(1) state plus an optional equity curve that is thinned by half whenever it would
+// exceed curve_points, so memory stays bounded however long the run.
+class RiskMetricsAccumulator {
+public:
+    explicit RiskMetricsAccumulator(double starting_capital, size_t curve_points = 0)
+        : start_(starting_capital), equity_(starting_capital), peak_(starting_capital),
+          curve_points_(curve_points == 1 ? 2 : curve_points) {
+        if (curve_points_ > 0) {
+            curve_.points.reserve(curve_points_ + 1);
+            curve_.points.push_back(starting_capital);
+        }
+    }
+
+    // Closes one period with `equity` after it, having traded `traded` (a fraction of equity).
+    void add(double equity, double traded = 0.0) {
+        const double r = equity_ != 0.0 ? equity / equity_ - 1.0 : 0.0;
+        equity_ = equity;
+        ++periods_;
+
+        const double delta = r - mean_;
+        mean_ += delta / static_cast<double>(periods_);
+        m2_ += delta * (r - mean_);
+        if (r < 0.0) downside_sq_ += r * r;
+        turnover_ += std::abs(traded);
+
+        if (equity >= peak_) {
+            peak_ = equity;
+            underwater_ = 0;
+        } else {
+            ++underwater_;
+            max_underwater_ = std::max(max_underwater_, underwater_);
+            if (peak_ > 0.0) max_drawdown_ = std::max(max_drawdown_, (peak_ - equity) / peak_);
+        }
+
+        if (curve_points_ > 0 && periods_ % curve_.stride == 0) {
+            curve_.points.push_back(equity);
+            if (curve_.points.size() > curve_points_) thinCurve();
+        }
+    }
+
+    RiskMetrics metrics() const {
+        RiskMetrics m;
+        m.periods = periods_;
+        m.final_equity = equity_;
+        m.total_return = start_ != 0.0 ? (equity_ - start_) / start_ : 0.0;
+        m.max_drawdown = max_drawdown_;
+        m.max_drawdown_duration = max_underwater_;
+        if (periods_ > 1) {
+            double stddev = std::sqrt(m2_ / (periods_ - 1));
+            m.sharpe = stddev > 0.0 ? mean_ / stddev : 0.0;
+        }
+        if (periods_ > 0) {
+            double downside = std::sqrt(downside_sq_ / periods_);
+            m.sortino = downside > 0.0 ? mean_ / downside : 0.0;
+            m.turnover = turnover_ / periods_;
+        }
+        return m;
+    }
+
+    // The sampled curve, ending on the latest period. Empty unless curve_points was set.
+    EquityCurve curve() const {
+        EquityCurve c = curve_;
+        if (curve_points_ > 0 && periods_ % curve_.stride != 0) c.points.push_back(equity_);
+        return c;
+    }
+
+private:
+    void thinCurve() {
+        size_t kept = 0;
+        for (size_t i = 0; i < curve_.points.size(); i += 2) curve_.points[kept++] = curve_.points[i];
+        curve_.points.resize(kept);
+        curve_.stride *= 2;
+    }
+
+    double start_;
+    double equity_;
+    double peak_;
+    size_t periods_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double downside_sq_ = 0.0;
+    double turnover_ = 0.0;
+    double max_drawdown_ = 0.0;
+    size_t underwater_ = 0;
+    size_t max_underwater_ = 0;
+    size_t curve_points_;
+    EquityCurve curve_;
+};
+
+}
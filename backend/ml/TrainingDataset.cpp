@@ -0,0 +1,318 @@
+#include "TrainingDataset.h"
+#include "MLSplits.h"
+#include "../utils/Exceptions.h"
+#include "../utils/ErrorHandling.h"
+#include <xgboost/c_api.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace MLPipeline {
+
+namespace {
+    // Describes the view as a NumPy-style __array_interface__. DMatrix constructors copy
+    // the values out of it; only XGBoosterPredictFromDense reads the buffer in place.
+    std::string arrayInterface(const DenseMatrixView& X) {
+        std::ostringstream out;
+        out << "{\"data\":[" << reinterpret_cast<uintptr_t>(X.data) << ",true],"
+            << "\"shape\":[" << X.rows << "," << X.cols << "],"
+            << "\"strides\":[" << X.stride * sizeof(float) << "," << sizeof(float) << "],"
+            << "\"typestr\":\"<f4\",\"version\":3}";
+        return out.str();
+    }
+
+    // QuantileDMatrix is built from an iterator; each block of rows is one batch, so the
+    // blocks of a purged fold are sketched straight out of the source matrix.
+    struct BlockIterator {
+        DMatrixHandle proxy = nullptr;
+        std::vector<std::string> array_interfaces;
+        std::vector<size_t> first_rows;
+        const std::vector<float>* labels = nullptr;
+        size_t next = 0;
+    };
+
+    int nextBatch(DataIterHandle handle) {
+        auto* iter = static_cast<BlockIterator*>(handle);
+        if (iter->next == iter->array_interfaces.size()) return 0;
+        const size_t k = iter->next;
+        if (XGProxyDMatrixSetDataDense(iter->proxy, iter->array_interfaces[k].c_str()) != 0) return -1;
+        if (iter->labels && !iter->labels->empty()) {
+            const size_t end = k + 1 < iter->first_rows.size() ? iter->first_rows[k + 1] : iter->labels->size();
+            if (XGDMatrixSetFloatInfo(iter->proxy, "label", iter->labels->data() + iter->first_rows[k],
+                                      end - iter->first_rows[k]) != 0) {
+                return -1;
+            }
+        }
+        ++iter->next;
+        return 1;
+    }
+
+    void resetBatches(DataIterHandle handle) {
+        static_cast<BlockIterator*>(handle)->next = 0;
+    }
+
+    DMatrixHandle createQuantileDMatrix(const std::vector<DenseMatrixView>& blocks, const std::vector<float>& y,
+                                        const TrainingDataset::Options& options) {
+        BlockIterator iter;
+        size_t first_row = 0;
+        for (const auto& block : blocks) {
+            iter.array_interfaces.push_back(arrayInterface(block));
+            iter.first_rows.push_back(first_row);
+            first_row += block.rows;
+        }
+        iter.labels = &y;
+        if (XGProxyDMatrixCreate(&iter.proxy) != 0) {
+            throw std::runtime_error("Failed to create proxy DMatrix: " + std::string(XGBGetLastError()));
+        }
+        std::string config = "{\"missing\":-1,\"nthread\":" + std::to_string(options.nthread) +
+                             ",\"max_bin\":" + std::to_string(options.max_bin) + "}";
+        DMatrixHandle handle = nullptr;
+        int ret = XGQuantileDMatrixCreateFromCallback(&iter, iter.proxy, nullptr, resetBatches, nextBatch,
+                                                      config.c_str(), &handle);
+        XGDMatrixFree(iter.proxy);
+        if (ret != 0) {
+            throw std::runtime_error("Failed to create QuantileDMatrix: " + std::string(XGBGetLastError()));
+        }
+        return handle;
+    }
+}
+
+void* TrainingDataset::createDMatrix(const DenseMatrixView& X, int nthread) {
+    std::string config = "{\"missing\":-1,\"nthread\":" + std::to_string(nthread) + "}";
+    DMatrixHandle handle;
+    if (XGDMatrixCreateFromDense(arrayInterface(X).c_str(), config.c_str(), &handle) != 0) {
+        throw std::runtime_error("Failed to create XGBoost DMatrix: " + std::string(XGBGetLastError()));
+    }
+    return handle;
+}
+
+TrainingDataset::TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                                 const std::string& objective)
+    : TrainingDataset(X, y, objective, Options{}) {}
+
+TrainingDataset::TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                                 const std::string& objective, const Options& options)
+    : rows_(X.rows), cols_(X.cols), has_labels_(!y.empty()), options_(options),
+      requested_objective_(objective), objective_(objective) {
+    validate(X, y);
+    build(X, fit_label_mapping(y));
+}
+
+TrainingDataset::TrainingDataset(const MLSplitUtils::RowRangeView& X, const std::vector<float>& y,
+                                 const std::string& objective, const Options& options)
+    : rows_(X.rows()), cols_(X.cols()), has_labels_(!y.empty()), options_(options),
+      requested_objective_(objective), objective_(objective) {
+    using namespace TripleBarrier;
+
+    if (rows_ == 0) {
+        throw DataValidationException("Empty container", "training_features");
+    }
+    if (has_labels_ && y.size() != rows_) {
+        throw DataValidationException("Size mismatch: features (" + std::to_string(rows_) +
+                                      ") vs labels (" + std::to_string(y.size()) + ")");
+    }
+
+    std::vector<DenseMatrixView> blocks;
+    size_t first_row = 0;
+    for (size_t k = 0; k < X.blocks(); ++k) {
+        blocks.push_back(X.block(k));
+        validate_layout(blocks.back());
+        validate_values(blocks.back(), has_labels_ ? y.data() + first_row : nullptr, first_row);
+        first_row += blocks.back().rows;
+    }
+
+    std::vector<float> adjusted_y = fit_label_mapping(y);
+    if (!options_.use_quantile && blocks.size() > 1) {
+        FlatFloatMatrix gathered = X.gather();
+        build(gathered.view(), adjusted_y);
+        return;
+    }
+    build(blocks, adjusted_y);
+}
+
+TrainingDataset::TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                                 const TrainingDataset& reference)
+    : rows_(X.rows), cols_(X.cols), has_labels_(!y.empty()), options_(reference.options_),
+      requested_objective_(reference.requested_objective_), objective_(reference.objective_),
+      num_class_(reference.num_class_), label_mapping_(reference.label_mapping_),
+      reverse_label_mapping_(reference.reverse_label_mapping_) {
+    using namespace TripleBarrier;
+
+    options_.use_quantile = false;
+    if (X.cols != reference.cols_) {
+        throw DataValidationException(
+            "Evaluation set has " + std::to_string(X.cols) + " features, training set has " +
+            std::to_string(reference.cols_));
+    }
+    validate(X, y);
+    build(X, encode_labels(y));
+}
+
+TrainingDataset::TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                                 const std::string& objective, const std::map<float, int>& label_mapping,
+                                 const Options& options)
+    : rows_(X.rows), cols_(X.cols), has_labels_(!y.empty()), options_(options),
+      requested_objective_(objective), objective_(objective),
+      num_class_(static_cast<int>(label_mapping.size())), label_mapping_(label_mapping) {
+    for (const auto& [label, index] : label_mapping_) {
+        reverse_label_mapping_[index] = label;
+    }
+    if (objective == "binary:logistic" && label_mapping_.size() > 2) objective_ = "multi:softmax";
+    validate(X, y);
+    build(X, encode_labels(y));
+}
+
+std::vector<float> TrainingDataset::encode_labels(const std::vector<float>& y) const {
+    std::vector<float> encoded = y;
+    if (label_mapping_.empty()) return encoded;
+
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        auto it = label_mapping_.find(y[i]);
+        if (it == label_mapping_.end()) {
+            throw TripleBarrier::DataValidationException(
+                "Label " + std::to_string(y[i]) + " does not occur in the training labels",
+                "row " + std::to_string(i));
+        }
+        encoded[i] = static_cast<float>(it->second);
+    }
+    return encoded;
+}
+
+std::map<float, int> TrainingDataset::classMapping(const std::vector<float>& y, const std::string& objective) {
+    std::map<float, int> mapping;
+    std::set<float> unique_labels(y.begin(), y.end());
+    const bool multiclass_objective = objective.rfind("multi:", 0) == 0;
+    if ((unique_labels.size() > 2 && objective == "binary:logistic") ||
+        (multiclass_objective && !unique_labels.empty())) {
+        int index = 0;
+        for (float label : unique_labels) {
+            mapping[label] = index++;
+        }
+    }
+    return mapping;
+}
+
+std::vector<float> TrainingDataset::fit_label_mapping(const std::vector<float>& y) {
+    label_mapping_ = classMapping(y, requested_objective_);
+    if (label_mapping_.empty()) return y;
+
+    if (requested_objective_.rfind("multi:", 0) != 0) objective_ = "multi:softmax";
+    for (const auto& [label, index] : label_mapping_) {
+        reverse_label_mapping_[index] = label;
+    }
+    num_class_ = static_cast<int>(label_mapping_.size());
+    return encode_labels(y);
+}
+
+void TrainingDataset::validate(const DenseMatrixView& X, const std::vector<float>& y) const {
+    TripleBarrier::Validation::validateNotEmpty(X, "training_features");
+    if (has_labels_) {
+        TripleBarrier::Validation::validateSizeMatch(X, y, "features", "labels");
+    }
+    validate_layout(X);
+    validate_values(X, has_labels_ ? y.data() : nullptr, 0);
+}
+
+void TrainingDataset::validate_layout(const DenseMatrixView& X) const {
+    using namespace TripleBarrier;
+
+    if (X.cols == 0 || X.data == nullptr || X.stride < X.cols) {
+        throw DataValidationException("Invalid feature matrix layout");
+    }
+    if (options_.use_quantile && options_.max_bin < 2) {
+        throw HyperparameterException("max_bin must be at least 2", "max_bin");
+    }
+}
+
+// y, when given, holds the labels of X's rows; first_row numbers the rows in messages.
+void TrainingDataset::validate_values(const DenseMatrixView& X, const float* y, size_t first_row) const {
+    using namespace TripleBarrier;
+
+    ErrorAccumulator dataErrors;
+    for (size_t i = 0; i < X.rows; ++i) {
+        const float* row = X.row(i);
+        const std::string row_name = "row " + std::to_string(first_row + i);
+        for (size_t j = 0; j < X.cols; ++j) {
+            if (std::isnan(row[j]) && dataErrors.errorCount() < 5) {
+                dataErrors.addError("NaN value in features", row_name + ", col " + std::to_string(j));
+            }
+            if (std::isinf(row[j]) && dataErrors.errorCount() < 5) {
+                dataErrors.addError("Infinite value in features", row_name + ", col " + std::to_string(j));
+            }
+        }
+        if (y && (std::isnan(y[i]) || std::isinf(y[i]))) {
+            dataErrors.addError("Invalid label value: " + std::to_string(y[i]), row_name);
+        }
+    }
+
+    if (dataErrors.hasErrors()) {
+        throw DataValidationException("Data quality issues detected", dataErrors.getAllErrors());
+    }
+}
+
+void TrainingDataset::build(const DenseMatrixView& X, const std::vector<float>& labels) {
+    build(std::vector<DenseMatrixView>{X}, labels);
+}
+
+// A plain DMatrix is built from exactly one block; callers gather scattered rows first.
+void TrainingDataset::build(const std::vector<DenseMatrixView>& blocks, const std::vector<float>& labels) {
+    if (options_.use_quantile) {
+        dmatrix_ = createQuantileDMatrix(blocks, labels, options_);
+        return;
+    }
+
+    dmatrix_ = createDMatrix(blocks.front(), options_.nthread);
+    if (has_labels_ && XGDMatrixSetFloatInfo(static_cast<DMatrixHandle>(dmatrix_), "label",
+                                             labels.data(), labels.size()) != 0) {
+        free_dmatrix();
+        throw std::runtime_error("Failed to set labels");
+    }
+}
+
+TrainingDataset::~TrainingDataset() {
+    free_dmatrix();
+}
+
+TrainingDataset::TrainingDataset(TrainingDataset&& other) noexcept
+    : dmatrix_(other.dmatrix_), rows_(other.rows_), cols_(other.cols_), has_labels_(other.has_labels_),
+      options_(other.options_), requested_objective_(std::move(other.requested_objective_)),
+      objective_(std::move(other.objective_)), num_class_(other.num_class_),
+      label_mapping_(std::move(other.label_mapping_)),
+      reverse_label_mapping_(std::move(other.reverse_label_mapping_)) {
+    other.dmatrix_ = nullptr;
+    other.rows_ = 0;
+    other.cols_ = 0;
+}
+
+TrainingDataset& TrainingDataset::operator=(TrainingDataset&& other) noexcept {
+    if (this != &other) {
+        free_dmatrix();
+        dmatrix_ = other.dmatrix_;
+        rows_ = other.rows_;
+        cols_ = other.cols_;
+        has_labels_ = other.has_labels_;
+        options_ = other.options_;
+        requested_objective_ = std::move(other.requested_objective_);
+        objective_ = std::move(other.objective_);
+        num_class_ = other.num_class_;
+        label_mapping_ = std::move(other.label_mapping_);
+        reverse_label_mapping_ = std::move(other.reverse_label_mapping_);
+
+        other.dmatrix_ = nullptr;
+        other.rows_ = 0;
+        other.cols_ = 0;
+    }
+    return *this;
+}
+
+void TrainingDataset::free_dmatrix() {
+    if (dmatrix_) {
+        XGDMatrixFree(static_cast<DMatrixHandle>(dmatrix_));
+        dmatrix_ = nullptr;
+    }
+}
+
+}
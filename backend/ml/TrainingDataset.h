@@ -0,0 +1,98 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "DenseMatrix.h"
+
+namespace MLSplitUtils {
+    struct RowRangeView;
+}
+
+namespace MLPipeline {
+
+// A validated feature matrix and its labels, converted to an XGBoost DMatrix once so
+// that many fits (e.g. every combination of a hyperparameter grid) can share it.
+// Labels are remapped here the same way XGBoostModel::fit does for a single fit, so
+// a dataset is tied to the objective it was prepared for. multi:* objectives always get
+// a mapping from the sorted distinct labels to 0..K-1 (e.g. barrier labels -1/0/1).
+class TrainingDataset {
+public:
+    struct Options {
+        bool use_quantile = false;  // build a QuantileDMatrix (hist only, far less memory)
+        int max_bin = 256;
+        int nthread = 4;
+    };
+
+    // Labels may be empty for a prediction-only matrix.
+    TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                    const std::string& objective, const Options& options);
+    TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                    const std::string& objective);
+    // Training rows scattered over several blocks of one matrix (a purged fold). With
+    // use_quantile each block is handed to XGBoost as its own batch, so the rows are never
+    // gathered into a contiguous copy; a plain DMatrix over several blocks still gathers.
+    // y holds the labels of the selected rows, in order.
+    TrainingDataset(const MLSplitUtils::RowRangeView& X, const std::vector<float>& y,
+                    const std::string& objective, const Options& options);
+    // Evaluation set for `reference`: same objective and label mapping, always a plain
+    // DMatrix so it can be scored by boosters trained on a quantized reference.
+    TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                    const TrainingDataset& reference);
+    // Labels encoded with a fixed mapping (e.g. the one a loaded model was trained with),
+    // so new data that lacks some classes is still encoded consistently. binary:logistic
+    // with more than two classes trains as multi:softmax, as above.
+    TrainingDataset(const DenseMatrixView& X, const std::vector<float>& y,
+                    const std::string& objective, const std::map<float, int>& label_mapping,
+                    const Options& options);
+    ~TrainingDataset();
+
+    TrainingDataset(const TrainingDataset&) = delete;
+    TrainingDataset& operator=(const TrainingDataset&) = delete;
+    TrainingDataset(TrainingDataset&& other) noexcept;
+    TrainingDataset& operator=(TrainingDataset&& other) noexcept;
+
+    // The mapping the constructors above build from y for objective: sorted distinct
+    // labels to 0..K-1 for multi:* and for binary:logistic with more than two classes,
+    // empty otherwise.
+    static std::map<float, int> classMapping(const std::vector<float>& y, const std::string& objective);
+
+    // Plain DMatrix over X for prediction; XGBoost copies the values it needs.
+    static void* createDMatrix(const DenseMatrixView& X, int nthread);
+
+    void* handle() const { return dmatrix_; }
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+    bool has_labels() const { return has_labels_; }
+    const Options& options() const { return options_; }
+
+    // Objective the dataset was prepared for, and the one XGBoost will actually train
+    // (binary:logistic with more than two classes becomes multi:softmax).
+    const std::string& requested_objective() const { return requested_objective_; }
+    const std::string& objective() const { return objective_; }
+    int num_class() const { return num_class_; }
+    const std::map<float, int>& label_mapping() const { return label_mapping_; }
+    const std::map<int, float>& reverse_label_mapping() const { return reverse_label_mapping_; }
+
+private:
+    void validate(const DenseMatrixView& X, const std::vector<float>& y) const;
+    void validate_layout(const DenseMatrixView& X) const;
+    void validate_values(const DenseMatrixView& X, const float* y, size_t first_row) const;
+    std::vector<float> fit_label_mapping(const std::vector<float>& y);
+    std::vector<float> encode_labels(const std::vector<float>& y) const;
+    void build(const DenseMatrixView& X, const std::vector<float>& labels);
+    void build(const std::vector<DenseMatrixView>& blocks, const std::vector<float>& labels);
+    void free_dmatrix();
+
+    void* dmatrix_ = nullptr;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    bool has_labels_ = false;
+    Options options_;
+    std::string requested_objective_;
+    std::string objective_;
+    int num_class_ = 0;
+    std::map<float, int> label_mapping_;
+    std::map<int, float> reverse_label_mapping_;
+};
+
+}
@@ -0,0 +1,155 @@
+#include "WalkForward.h"
+#include "TrainingDataset.h"
+#include "../utils/Exceptions.h"
+#include "../utils/ParallelUtils.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace MLPipeline {
+
+std::vector<WalkForwardStep> planWalkForward(size_t samples, const WalkForwardConfig& config) {
+    if (config.train_size == 0 || config.test_size == 0) {
+        throw std::invalid_argument("Walk-forward needs positive train and test sizes");
+    }
+    if (config.train_size + config.embargo >= samples) {
+        throw std::invalid_argument("Walk-forward needs more than " +
+                                    std::to_string(config.train_size + config.embargo) +
+                                    " samples, got " + std::to_string(samples));
+    }
+
+    std::vector<WalkForwardStep> steps;
+    for (size_t test_begin = config.train_size + config.embargo; test_begin < samples;
+         test_begin += config.test_size) {
+        WalkForwardStep step;
+        step.test = {test_begin, std::min(test_begin + config.test_size, samples)};
+        step.train.end = test_begin - config.embargo;
+        step.train.begin = config.window == WalkForwardWindow::ROLLING ? step.train.end - config.train_size : 0;
+        step.train_rows = {step.train};
+        steps.push_back(step);
+    }
+    return steps;
+}
+
+std::vector<WalkForwardStep> planWalkForward(const std::vector<MLSplitUtils::EventWindow>& windows,
+                                             const WalkForwardConfig& config) {
+    MLSplitUtils::detail::validateWindows(windows);
+    auto steps = planWalkForward(windows.size(), config);
+    for (size_t k = 0; k < steps.size(); ++k) {
+        auto& step = steps[k];
+        const size_t test_start = MLSplitUtils::detail::span(windows, step.test).start;
+        step.train_rows.clear();
+        for (size_t i = step.train.begin; i < step.train.end; ++i) {
+            if (windows[i].end < test_start) MLSplitUtils::appendRange(step.train_rows, i, i + 1);
+        }
+        step.purged = step.train.size() - MLSplitUtils::rangeCount(step.train_rows);
+        if (step.train_rows.empty()) {
+            throw std::invalid_argument("Purging left walk-forward step " + std::to_string(k) +
+                                        " without training samples");
+        }
+    }
+    return steps;
+}
+
+WalkForwardResult runWalkForward(
+    const std::vector<WalkForwardStep>& steps,
+    const std::vector<double>& returns,
+    const CoreBudget& budget,
+    const WalkForwardPredictor& predict,
+    const PortfolioConfig& portfolio
+) {
+    WalkForwardResult result;
+    result.steps = steps;
+    if (steps.empty()) {
+        throw std::invalid_argument("Walk-forward has no steps");
+    }
+    for (size_t k = 0; k < steps.size(); ++k) {
+        if (steps[k].test.end > returns.size() || (k > 0 && steps[k].test.begin != steps[k - 1].test.end)) {
+            throw std::invalid_argument("Walk-forward test blocks must be consecutive and within the returns");
+        }
+    }
+    result.tested = {steps.front().test.begin, steps.back().test.end};
+
+    std::vector<std::vector<double>> step_signals(steps.size());
+    TripleBarrier::Parallel::parallelFor(steps.size(), static_cast<unsigned>(budget.jobs), [&](size_t k) {
+        step_signals[k] = predict(steps[k], budget.threads_per_job);
+        if (step_signals[k].size() != steps[k].test.size()) {
+            throw std::runtime_error("Walk-forward step " + std::to_string(k) + " returned " +
+                                     std::to_string(step_signals[k].size()) + " signals for " +
+                                     std::to_string(steps[k].test.size()) + " samples");
+        }
+    });
+
+    result.signals.reserve(result.tested.size());
+    for (const auto& s : step_signals) {
+        result.signals.insert(result.signals.end(), s.begin(), s.end());
+    }
+    std::vector<double> tested_returns(returns.begin() + result.tested.begin, returns.begin() + result.tested.end);
+    result.portfolio = simulate_portfolio(result.signals, tested_returns, portfolio);
+    result.sharpe = result.portfolio.sharpe;
+    return result;
+}
+
+WalkForwardResult runModelWalkForward(
+    const DenseMatrixView& X,
+    const std::vector<float>& y,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const std::vector<double>& returns,
+    const XGBoostConfig& model_config,
+    const WalkForwardConfig& config,
+    const SignalFunction& signals,
+    const PortfolioConfig& portfolio
+) {
+    if (X.empty()) {
+        throw std::invalid_argument("Input feature matrix cannot be empty");
+    }
+    if (X.rows != y.size() || X.rows != returns.size() || X.rows != windows.size()) {
+        throw std::invalid_argument("Features, labels, returns and event windows must have the same number of rows");
+    }
+    if (config.warm_start && config.warm_start_rounds <= 0) {
+        throw TripleBarrier::HyperparameterException("warm_start_rounds must be positive", "warm_start_rounds");
+    }
+
+    auto steps = planWalkForward(windows, config);
+
+    // A warm-started booster carries state from step to step, so those steps run in
+    // order on one job with every core.
+    CoreBudget budget = planCoreBudget(steps.size(), config.warm_start ? 1 : config.jobs,
+                                       model_config.nthread, TripleBarrier::Parallel::hardwareThreads());
+    XGBoostModel warm_model;
+    const std::map<float, int> warm_classes =
+        config.warm_start ? TrainingDataset::classMapping(y, model_config.objective) : std::map<float, int>{};
+
+    auto predict = [&](const WalkForwardStep& step, int nthread) {
+        MLSplitUtils::RowRangeView X_train(X, step.train_rows);
+        std::vector<float> y_train = MLSplitUtils::selectRanges(y, step.train_rows);
+
+        XGBoostConfig step_config = model_config;
+        step_config.nthread = nthread;
+        step_config.early_stopping_rounds = 0;
+
+        XGBoostModel fresh;
+        XGBoostModel& model = config.warm_start ? warm_model : fresh;
+        if (!model.is_trained()) {
+            TrainingDataset::Options options;
+            options.nthread = nthread;
+            if (config.warm_start) {
+                FlatFloatMatrix rows = X_train.gather();
+                TrainingDataset train_data(rows.view(), y_train, step_config.objective, warm_classes, options);
+                model.fit(train_data, step_config);
+            } else {
+                TrainingDataset train_data(X_train, y_train, step_config.objective, options);
+                model.fit(train_data, step_config);
+            }
+        } else {
+            FlatFloatMatrix rows = X_train.gather();
+            model.continue_training(rows.view(), y_train, config.warm_start_rounds);
+        }
+        return signals(model, X.rowRange(step.test.begin, step.test.end));
+    };
+
+    return runWalkForward(steps, returns, budget, predict, portfolio);
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "DenseMatrix.h"
+#include "HyperparameterSearch.h"
+#include "MLSplits.h"
+#include "PortfolioSimulator.h"
+#include "XGBoostModel.h"
+
+namespace MLPipeline {
+
+enum class WalkForwardWindow {
+    EXPANDING,  // every step trains on all samples before its test block
+    ROLLING     // every step trains on the train_size samples before its test block
+};
+
+struct WalkForwardConfig {
+    size_t train_size = 0;  // samples in the first training window (every window when rolling)
+    size_t test_size = 0;   // samples scored by each model before it is refreshed
+    size_t embargo = 0;     // samples left out between a training window and its test block
+    WalkForwardWindow window = WalkForwardWindow::EXPANDING;
+    // Continue the previous step's booster on the new window instead of retraining from
+    // scratch. Steps then depend on each other and run one after another.
+    bool warm_start = false;
+    int warm_start_rounds = 10;  // rounds added per step when warm starting
+    int jobs = 0;                // concurrent retraining steps; 0 splits the cores into jobs of nthread each
+};
+
+struct WalkForwardStep {
+    MLSplitUtils::IndexRange train;    // window of samples before the test block
+    MLSplitUtils::IndexRange test;
+    MLSplitUtils::RangeList train_rows;  // samples of train the model is fit on, after purging
+    size_t purged = 0;                   // samples of train dropped by purging
+};
+
+struct WalkForwardResult {
+    std::vector<WalkForwardStep> steps;
+    MLSplitUtils::IndexRange tested;  // samples with an out-of-sample signal
+    std::vector<double> signals;      // one per tested sample
+    PortfolioSimulation portfolio;    // simulated on the tested samples' returns
+    double sharpe = 0.0;
+};
+
+// Consecutive test blocks of test_size samples (the last may be shorter) after the
+// first train_size + embargo samples, each with the training window it is scored by.
+std::vector<WalkForwardStep> planWalkForward(size_t samples, const WalkForwardConfig& config);
+// The same steps over event-ordered samples, with every training sample whose window
+// reaches the first bar of its step's test block purged, so no training label is
+// resolved inside the test period.
+std::vector<WalkForwardStep> planWalkForward(const std::vector<MLSplitUtils::EventWindow>& windows,
+                                             const WalkForwardConfig& config);
+
+// Trains on step.train_rows and returns one signal per sample of step.test.
+using WalkForwardPredictor = std::function<std::vector<double>(const WalkForwardStep& step, int nthread)>;
+
+// Runs the steps under the core budget and stitches their out-of-sample signals into one
+// portfolio simulation over the tested samples. Steps are handed out in order, so a
+// budget of one job runs them sequentially.
+WalkForwardResult runWalkForward(
+    const std::vector<WalkForwardStep>& steps,
+    const std::vector<double>& returns,
+    const CoreBudget& budget,
+    const WalkForwardPredictor& predict,
+    const PortfolioConfig& portfolio = PortfolioConfig{}
+);
+
+// Trading signals for X from a trained model.
+using SignalFunction = std::function<std::vector<double>(const XGBoostModel& model, const DenseMatrixView& X)>;
+
+// Walk-forward backtest of model_config on event-ordered samples, retraining (in
+// parallel) or warm-starting (sequentially) the booster at every step. Training rows are
+// purged by event window. A warm-started classifier fixes its classes from every label in
+// y at the first fit, so a class that only appears in a later window still continues the
+// same booster.
+WalkForwardResult runModelWalkForward(
+    const DenseMatrixView& X,
+    const std::vector<float>& y,
+    const std::vector<MLSplitUtils::EventWindow>& windows,
+    const std::vector<double>& returns,
+    const XGBoostConfig& model_config,
+    const WalkForwardConfig& config,
+    const SignalFunction& signals,
+    const PortfolioConfig& portfolio = PortfolioConfig{}
+);
+
+}
@@ -1,11 +1,17 @@
 #include "XGBoostModel.h"
+#include "XGBoostModelDetail.h"
 #include "../utils/Exceptions.h"
 #include "../utils/ErrorHandling.h"
 #include <xgboost/c_api.h>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <fstream>
 #include <cmath>
 #include <algorithm>
@@ -13,6 +19,143 @@
 
 namespace MLPipeline {
 
+namespace detail {
+
+bool parseEvalResult(const std::string& line, std::string& metric, double& value) {
+    size_t colon = line.rfind(':');
+    if (colon == std::string::npos || colon + 1 >= line.size()) return false;
+    size_t start = line.find_last_of("\t ", colon);
+    start = (start == std::string::npos) ? 0 : start + 1;
+    
+    std::string name = line.substr(start, colon - start);
+    size_t dash = name.find('-');
+    if (dash != std::string::npos) name = name.substr(dash + 1);
+    if (name.empty()) return false;
+    
+    const char* begin = line.c_str() + colon + 1;
+    char* end = nullptr;
+    double parsed = std::strtod(begin, &end);
+    if (end == begin) return false;
+    
+    metric = name;
+    value = parsed;
+    return true;
+}
+
+bool metricIsMaximized(const std::string& metric) {
+    std::string base = metric.substr(0, metric.find('@'));
+    return base == "auc" || base == "aucpr" || base == "map" || base == "ndcg" || base == "pre";
+}
+
+}
+
+bool isClassificationObjective(const std::string& objective) {
+    return objective.rfind("binary:", 0) == 0 || objective.rfind("multi:", 0) == 0;
+}
+
+namespace {
+    // Booster attribute keys for the state XGBoost itself does not persist.
+    constexpr const char* ATTR_FORMAT = "triple_barrier_format";
+    constexpr const char* ATTR_CONFIG = "triple_barrier_config";
+    constexpr const char* ATTR_LABELS = "triple_barrier_label_mapping";
+    constexpr const char* ATTR_FEATURES = "triple_barrier_feature_names";
+    constexpr const char* ATTR_STATE = "triple_barrier_state";
+    constexpr const char* MODEL_FORMAT_VERSION = "1";
+
+    std::string serializeConfig(const XGBoostConfig& config) {
+        std::ostringstream out;
+        out << std::setprecision(17)
+            << "n_rounds=" << config.n_rounds << ";max_depth=" << config.max_depth
+            << ";nthread=" << config.nthread << ";objective=" << config.objective
+            << ";learning_rate=" << config.learning_rate << ";subsample=" << config.subsample
+            << ";colsample_bytree=" << config.colsample_bytree << ";reg_alpha=" << config.reg_alpha
+            << ";reg_lambda=" << config.reg_lambda << ";min_child_weight=" << config.min_child_weight
+            << ";binary_threshold=" << config.binary_threshold << ";num_class=" << config.num_class
+            << ";early_stopping_rounds=" << config.early_stopping_rounds
+            << ";eval_metric=" << config.eval_metric;
+        return out.str();
+    }
+
+    std::map<std::string, std::string> splitPairs(const std::string& text, char separator) {
+        std::map<std::string, std::string> pairs;
+        std::istringstream in(text);
+        std::string item;
+        while (std::getline(in, item, separator)) {
+            size_t eq = item.find('=');
+            if (eq != std::string::npos) pairs[item.substr(0, eq)] = item.substr(eq + 1);
+        }
+        return pairs;
+    }
+
+    XGBoostConfig parseConfig(const std::string& text) {
+        auto pairs = splitPairs(text, ';');
+        auto get = [&](const char* key) -> const std::string& {
+            auto it = pairs.find(key);
+            if (it == pairs.end()) throw std::runtime_error(std::string("missing config field ") + key);
+            return it->second;
+        };
+        XGBoostConfig config;
+        config.n_rounds = std::stoi(get("n_rounds"));
+        config.max_depth = std::stoi(get("max_depth"));
+        config.nthread = std::stoi(get("nthread"));
+        config.objective = get("objective");
+        config.learning_rate = std::stod(get("learning_rate"));
+        config.subsample = std::stod(get("subsample"));
+        config.colsample_bytree = std::stod(get("colsample_bytree"));
+        config.reg_alpha = std::stod(get("reg_alpha"));
+        config.reg_lambda = std::stod(get("reg_lambda"));
+        config.min_child_weight = std::stod(get("min_child_weight"));
+        config.binary_threshold = std::stod(get("binary_threshold"));
+        config.num_class = std::stoi(get("num_class"));
+        config.early_stopping_rounds = std::stoi(get("early_stopping_rounds"));
+        config.eval_metric = get("eval_metric");
+        return config;
+    }
+
+    std::string serializeLabelMapping(const std::map<float, int>& mapping) {
+        std::ostringstream out;
+        out << std::setprecision(9);
+        for (const auto& [label, index] : mapping) {
+            out << label << '=' << index << ';';
+        }
+        return out.str();
+    }
+
+    std::map<float, int> parseLabelMapping(const std::string& text) {
+        std::map<float, int> mapping;
+        for (const auto& [label, index] : splitPairs(text, ';')) {
+            mapping[std::stof(label)] = std::stoi(index);
+        }
+        return mapping;
+    }
+
+    std::string joinLines(const std::vector<std::string>& names) {
+        std::string joined;
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (i > 0) joined += '\n';
+            joined += names[i];
+        }
+        return joined;
+    }
+
+    std::vector<std::string> splitLines(const std::string& text) {
+        std::vector<std::string> lines;
+        if (text.empty()) return lines;
+        std::istringstream in(text);
+        std::string line;
+        while (std::getline(in, line)) lines.push_back(line);
+        return lines;
+    }
+
+    bool getAttr(BoosterHandle booster, const char* key, std::string& value) {
+        const char* out = nullptr;
+        int success = 0;
+        if (XGBoosterGetAttr(booster, key, &out, &success) != 0 || !success || out == nullptr) return false;
+        value = out;
+        return true;
+    }
+}
+
 XGBoostModel::XGBoostModel() = default;
 
 XGBoostModel::~XGBoostModel() { 
@@ -21,11 +164,16 @@ XGBoostModel::~XGBoostModel() {
 
 XGBoostModel::XGBoostModel(XGBoostModel&& other) noexcept 
     : booster_(other.booster_), n_features_(other.n_features_), 
-      feature_names_(std::move(other.feature_names_)), config_(other.config_), trained_(other.trained_) {
-    other.booster_ = nullptr;
+      feature_names_(std::move(other.feature_names_)), config_(other.config_), trained_(other.trained_),
+      boosted_rounds_(other.boosted_rounds_), best_iteration_(other.best_iteration_),
+      best_score_(other.best_score_), max_bin_(other.max_bin_), label_mapping_(std::move(other.label_mapping_)),
+      reverse_label_mapping_(std::move(other.reverse_label_mapping_)),
+      inplace_config_(std::move(other.inplace_config_)) {
     other.booster_ = nullptr;
     other.n_features_ = 0;
     other.trained_ = false;
+    other.boosted_rounds_ = 0;
+    other.best_iteration_ = -1;
 }
 
 XGBoostModel& XGBoostModel::operator=(XGBoostModel&& other) noexcept {
@@ -36,10 +184,19 @@ XGBoostModel& XGBoostModel::operator=(XGBoostModel&& other) noexcept {
         feature_names_ = std::move(other.feature_names_);
         config_ = other.config_;
         trained_ = other.trained_;
+        boosted_rounds_ = other.boosted_rounds_;
+        best_iteration_ = other.best_iteration_;
+        best_score_ = other.best_score_;
+        max_bin_ = other.max_bin_;
+        label_mapping_ = std::move(other.label_mapping_);
+        reverse_label_mapping_ = std::move(other.reverse_label_mapping_);
+        inplace_config_ = std::move(other.inplace_config_);
         
         other.booster_ = nullptr;
         other.n_features_ = 0;
         other.trained_ = false;
+        other.boosted_rounds_ = 0;
+        other.best_iteration_ = -1;
     }
     return *this;
 }
@@ -47,6 +204,10 @@ XGBoostModel& XGBoostModel::operator=(XGBoostModel&& other) noexcept {
 void XGBoostModel::clear() { 
     free_booster(); 
     trained_ = false;
+    boosted_rounds_ = 0;
+    best_iteration_ = -1;
+    best_score_ = 0.0;
+    max_bin_ = 0;
     n_features_ = 0;
     feature_names_.clear();
     label_mapping_.clear();
@@ -79,6 +240,34 @@ void XGBoostModel::validate_input_dimensions(const std::vector<std::vector<float
     }
 }
 
+void XGBoostModel::validate_input_dimensions(const DenseMatrixView& X) const {
+    if (X.empty()) {
+        throw std::invalid_argument("Input feature matrix cannot be empty");
+    }
+    
+    if (trained_ && n_features_ > 0 && static_cast<int>(X.cols) != n_features_) {
+        throw std::invalid_argument("Input feature dimensions do not match training dimensions. Expected: " + 
+                                  std::to_string(n_features_) + ", got: " + std::to_string(X.cols));
+    }
+}
+
+void XGBoostModel::validate_hyperparameters(const XGBoostConfig& config) const {
+    using namespace TripleBarrier;
+    
+    if (config.n_rounds <= 0) {
+        throw HyperparameterException("n_rounds must be positive", "n_rounds");
+    }
+    if (config.max_depth <= 0) {
+        throw HyperparameterException("max_depth must be positive", "max_depth");
+    }
+    if (config.learning_rate <= 0.0) {
+        throw HyperparameterException("learning_rate must be positive", "learning_rate");
+    }
+    if (config.early_stopping_rounds < 0) {
+        throw HyperparameterException("early_stopping_rounds cannot be negative", "early_stopping_rounds");
+    }
+}
+
 void XGBoostModel::set_xgboost_parameters(const XGBoostConfig& config) {
     int ret;
     
@@ -113,6 +302,18 @@ void XGBoostModel::set_xgboost_parameters(const XGBoostConfig& config) {
         ret = XGBoosterSetParam(static_cast<BoosterHandle>(booster_), "num_class", std::to_string(config.num_class).c_str());
         if (ret != 0) throw std::runtime_error("Failed to set num_class parameter");
     }
+    
+    if (!config.eval_metric.empty()) {
+        ret = XGBoosterSetParam(static_cast<BoosterHandle>(booster_), "eval_metric", config.eval_metric.c_str());
+        if (ret != 0) throw std::runtime_error("Failed to set eval_metric parameter");
+    }
+}
+
+void XGBoostModel::set_max_bin_parameter() {
+    if (max_bin_ > 0 &&
+        XGBoosterSetParam(static_cast<BoosterHandle>(booster_), "max_bin", std::to_string(max_bin_).c_str()) != 0) {
+        throw std::runtime_error("Failed to set max_bin parameter");
+    }
 }
 
 void XGBoostModel::fit(const std::vector<std::vector<float>>& X, const std::vector<float>& y, const XGBoostConfig& config) {
@@ -122,189 +323,295 @@ void XGBoostModel::fit(const std::vector<std::vector<float>>& X, const std::vect
     Validation::validateNotEmpty(y, "training_labels");
     Validation::validateSizeMatch(X, y, "features", "labels");
     
-    if (config.n_rounds <= 0) {
-        throw HyperparameterException("n_rounds must be positive", "n_rounds");
-    }
-    if (config.max_depth <= 0) {
-        throw HyperparameterException("max_depth must be positive", "max_depth");
-    }
-    if (config.learning_rate <= 0.0) {
-        throw HyperparameterException("learning_rate must be positive", "learning_rate");
-    }
-    
-    if (!X.empty()) {
-        size_t expected_features = X[0].size();
-        for (size_t i = 1; i < X.size(); ++i) {
-            if (X[i].size() != expected_features) {
-                throw DataValidationException(
-                    "Inconsistent feature dimensions at row " + std::to_string(i) + 
-                    ": expected " + std::to_string(expected_features) + 
-                    ", got " + std::to_string(X[i].size())
-                );
-            }
+    size_t expected_features = X[0].size();
+    for (size_t i = 1; i < X.size(); ++i) {
+        if (X[i].size() != expected_features) {
+            throw DataValidationException(
+                "Inconsistent feature dimensions at row " + std::to_string(i) + 
+                ": expected " + std::to_string(expected_features) + 
+                ", got " + std::to_string(X[i].size())
+            );
         }
     }
     
-    if (X.size() != y.size()) {
-        throw DataValidationException(
-            "Size mismatch: features (" + std::to_string(X.size()) + 
-            ") vs labels (" + std::to_string(y.size()) + ")"
-        );
+    std::vector<float> flat_X;
+    flat_X.reserve(X.size() * expected_features);
+    for (const auto& row : X) {
+        flat_X.insert(flat_X.end(), row.begin(), row.end());
     }
     
-    ErrorAccumulator dataErrors;
-    int nan_count = 0, inf_count = 0;
+    fit(DenseMatrixView(flat_X.data(), X.size(), expected_features), y, config);
+}
+
+void XGBoostModel::fit(const DenseMatrixView& X, const std::vector<float>& y, const XGBoostConfig& config) {
+    using namespace TripleBarrier;
     
-    for (size_t i = 0; i < X.size(); ++i) {
-        for (size_t j = 0; j < X[i].size(); ++j) {
-            if (std::isnan(X[i][j])) {
-                nan_count++;
-                if (dataErrors.errorCount() < 5) {
-                    dataErrors.addError("NaN value in features", 
-                                       "row " + std::to_string(i) + ", col " + std::to_string(j));
-                }
-            }
-            if (std::isinf(X[i][j])) {
-                inf_count++;
-                if (dataErrors.errorCount() < 5) {
-                    dataErrors.addError("Infinite value in features", 
-                                       "row " + std::to_string(i) + ", col " + std::to_string(j));
-                }
-            }
-        }
-        if (std::isnan(y[i]) || std::isinf(y[i])) {
-            dataErrors.addError("Invalid label value: " + std::to_string(y[i]), 
-                               "row " + std::to_string(i));
-        }
+    Validation::validateNotEmpty(X, "training_features");
+    Validation::validateNotEmpty(y, "training_labels");
+    Validation::validateSizeMatch(X, y, "features", "labels");
+    validate_hyperparameters(config);
+    
+    TrainingDataset::Options options;
+    options.nthread = config.nthread;
+    TrainingDataset dataset(X, y, config.objective, options);
+    fit(dataset, config);
+}
+
+void XGBoostModel::fit(const TrainingDataset& dataset, const XGBoostConfig& config) {
+    start_training(dataset, config, nullptr);
+}
+
+void XGBoostModel::fit(const TrainingDataset& dataset, const TrainingDataset& eval_set, const XGBoostConfig& config) {
+    using namespace TripleBarrier;
+    
+    if (!eval_set.has_labels()) {
+        throw DataValidationException("Evaluation dataset has no labels");
     }
+    if (eval_set.cols() != dataset.cols() || eval_set.objective() != dataset.objective()) {
+        throw DataValidationException("Evaluation dataset was not prepared like the training dataset");
+    }
+    start_training(dataset, config, &eval_set);
+}
+
+void XGBoostModel::start_training(const TrainingDataset& dataset, const XGBoostConfig& config,
+                                  const TrainingDataset* eval_set) {
+    using namespace TripleBarrier;
     
-    if (dataErrors.hasErrors()) {
-        throw DataValidationException("Data quality issues detected", dataErrors.getAllErrors());
+    validate_hyperparameters(config);
+    if (!dataset.has_labels()) {
+        throw DataValidationException("Training dataset has no labels");
+    }
+    if (config.objective != dataset.requested_objective()) {
+        throw HyperparameterException(
+            "objective " + config.objective + " does not match the training dataset (" + 
+            dataset.requested_objective() + ")", "objective");
     }
     
     XGBoostConfig adjusted_config = config;
-    std::vector<float> adjusted_y = y;
-    std::set<float> unique_labels(y.begin(), y.end());
-    if (unique_labels.size() > 2 && config.objective == "binary:logistic") {
-        adjusted_config.objective = "multi:softmax";
-        
-        std::vector<float> sorted_labels(unique_labels.begin(), unique_labels.end());
-        std::sort(sorted_labels.begin(), sorted_labels.end());
-        
-        label_mapping_.clear();
-        reverse_label_mapping_.clear();
-        for (size_t i = 0; i < sorted_labels.size(); ++i) {
-            label_mapping_[sorted_labels[i]] = i;
-            reverse_label_mapping_[i] = sorted_labels[i];
-        }
-        
-        for (size_t i = 0; i < adjusted_y.size(); ++i) {
-            adjusted_y[i] = label_mapping_[y[i]];
-        }
-        
-        adjusted_config.num_class = static_cast<int>(unique_labels.size());
+    adjusted_config.objective = dataset.objective();
+    if (dataset.num_class() > 0) {
+        adjusted_config.num_class = dataset.num_class();
     }
     
     free_booster();
     trained_ = false;
-    n_features_ = 0;
+    boosted_rounds_ = 0;
+    best_iteration_ = -1;
+    best_score_ = 0.0;
+    max_bin_ = dataset.options().use_quantile ? dataset.options().max_bin : 0;
     feature_names_.clear();
-    
-    int n_samples = static_cast<int>(X.size());
-    n_features_ = static_cast<int>(X[0].size());
+    label_mapping_ = dataset.label_mapping();
+    reverse_label_mapping_ = dataset.reverse_label_mapping();
+    n_features_ = static_cast<int>(dataset.cols());
     config_ = adjusted_config;
     
-    for (const auto& row : X) {
-        if (static_cast<int>(row.size()) != n_features_) {
-            throw std::invalid_argument("All feature vectors must have the same dimensions");
-        }
+    DMatrixHandle cached[2] = {static_cast<DMatrixHandle>(dataset.handle()), nullptr};
+    bst_ulong n_cached = 1;
+    if (eval_set) {
+        cached[n_cached++] = static_cast<DMatrixHandle>(eval_set->handle());
     }
     
-    std::vector<float> flat_X;
-    flat_X.reserve(n_samples * n_features_);
-    for (const auto& row : X) {
-        flat_X.insert(flat_X.end(), row.begin(), row.end());
+    BoosterHandle temp_booster;
+    int ret = XGBoosterCreate(cached, n_cached, &temp_booster);
+    if (ret != 0) throw std::runtime_error("Failed to create XGBoost booster");
+    booster_ = temp_booster;
+    
+    set_xgboost_parameters(adjusted_config); 
+    set_max_bin_parameter();
+    
+    if (eval_set && config.early_stopping_rounds > 0) {
+        boost_with_early_stopping(dataset, *eval_set, config.n_rounds, config.early_stopping_rounds);
+    } else {
+        boost_rounds(dataset, config.n_rounds);
     }
+    update_inplace_config();
+    trained_ = true;
+}
+
+void XGBoostModel::continue_training(const DenseMatrixView& X, const std::vector<float>& y, int additional_rounds) {
+    using namespace TripleBarrier;
     
-    DMatrixHandle dtrain;
-    int ret = XGDMatrixCreateFromMat(flat_X.data(), n_samples, n_features_, -1, &dtrain);
-    if (ret != 0) {
-        throw std::runtime_error("Failed to create XGBoost DMatrix");
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before training can be continued");
     }
+    Validation::validateNotEmpty(y, "training_labels");
     
-    try {
-        ret = XGDMatrixSetFloatInfo(dtrain, "label", adjusted_y.data(), n_samples); 
-        if (ret != 0) throw std::runtime_error("Failed to set labels");
-        
-        BoosterHandle temp_booster;
-        ret = XGBoosterCreate(&dtrain, 1, &temp_booster);
-        if (ret != 0) throw std::runtime_error("Failed to create XGBoost booster");
-        booster_ = temp_booster;
-        
-        set_xgboost_parameters(adjusted_config); 
+    TrainingDataset::Options options;
+    options.nthread = config_.nthread;
+    options.use_quantile = max_bin_ > 0;
+    if (options.use_quantile) options.max_bin = max_bin_;
+    TrainingDataset dataset(X, y, config_.objective, label_mapping_, options);
+    continue_training(dataset, additional_rounds);
+}
+
+void XGBoostModel::continue_training(const TrainingDataset& dataset, int additional_rounds) {
+    using namespace TripleBarrier;
+    
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before training can be continued");
+    }
+    if (additional_rounds <= 0) {
+        throw HyperparameterException("additional_rounds must be positive", "n_rounds");
+    }
+    if (!dataset.has_labels() || static_cast<int>(dataset.cols()) != n_features_ ||
+        dataset.objective() != config_.objective || dataset.label_mapping() != label_mapping_) {
+        throw DataValidationException("Dataset does not match the one the model was trained on");
+    }
+    if (dataset.options().use_quantile && dataset.options().max_bin != max_bin_) {
+        throw DataValidationException("QuantileDMatrix max_bin " + std::to_string(dataset.options().max_bin) +
+                                      " does not match the model's " + std::to_string(max_bin_));
+    }
+    
+    boost_rounds(dataset, additional_rounds);
+    config_.n_rounds = boosted_rounds_;
+    best_iteration_ = -1;
+    update_inplace_config();
+}
+
+void XGBoostModel::boost_rounds(const TrainingDataset& dataset, int rounds) {
+    DMatrixHandle dtrain = static_cast<DMatrixHandle>(dataset.handle());
+    for (int i = 0; i < rounds; ++i) {
+        int iter = boosted_rounds_;
+        int ret = XGBoosterUpdateOneIter(static_cast<BoosterHandle>(booster_), iter, dtrain);
+        if (ret != 0) {
+            const char* error_msg = XGBGetLastError();
+            std::string full_error = "Training failed at iteration " + std::to_string(iter) + 
+                                   ". XGBoost error: " + std::string(error_msg);
+            throw std::runtime_error(full_error);
+        }
+        ++boosted_rounds_;
+    }
+}
+
+void XGBoostModel::boost_with_early_stopping(const TrainingDataset& dataset, const TrainingDataset& eval_set,
+                                             int max_rounds, int patience) {
+    DMatrixHandle dtrain = static_cast<DMatrixHandle>(dataset.handle());
+    DMatrixHandle deval = static_cast<DMatrixHandle>(eval_set.handle());
+    const char* eval_names[] = {"eval"};
+    
+    bool maximize = false;
+    for (int i = 0; i < max_rounds; ++i) {
+        int iter = boosted_rounds_;
+        if (XGBoosterUpdateOneIter(static_cast<BoosterHandle>(booster_), iter, dtrain) != 0) {
+            throw std::runtime_error("Training failed at iteration " + std::to_string(iter) + 
+                                   ". XGBoost error: " + std::string(XGBGetLastError()));
+        }
+        ++boosted_rounds_;
         
-        for (int iter = 0; iter < config.n_rounds; ++iter) {
-            ret = XGBoosterUpdateOneIter(static_cast<BoosterHandle>(booster_), iter, dtrain);
-            if (ret != 0) {
-                const char* error_msg = XGBGetLastError();
-                std::string full_error = "Training failed at iteration " + std::to_string(iter) + 
-                                       ". XGBoost error: " + std::string(error_msg);
-                throw std::runtime_error(full_error);
-            }
+        const char* eval_result = nullptr;
+        if (XGBoosterEvalOneIter(static_cast<BoosterHandle>(booster_), iter, &deval, eval_names, 1, &eval_result) != 0) {
+            throw std::runtime_error("Evaluation failed at iteration " + std::to_string(iter) + 
+                                   ". XGBoost error: " + std::string(XGBGetLastError()));
         }
         
-        trained_ = true;
+        std::string metric;
+        double score = 0.0;
+        if (!detail::parseEvalResult(eval_result ? eval_result : "", metric, score) || std::isnan(score)) {
+            throw std::runtime_error("Could not parse evaluation result: " + std::string(eval_result ? eval_result : ""));
+        }
         
-    } catch (...) {
-        XGDMatrixFree(dtrain);
-        throw;
+        if (best_iteration_ < 0) {
+            maximize = detail::metricIsMaximized(metric);
+        }
+        if (best_iteration_ < 0 || (maximize ? score > best_score_ : score < best_score_)) {
+            best_iteration_ = iter;
+            best_score_ = score;
+        } else if (iter - best_iteration_ >= patience) {
+            break;
+        }
     }
-    
-    XGDMatrixFree(dtrain);
 }
 
 std::vector<int> XGBoostModel::predict(const std::vector<std::vector<float>>& X) const {
     if (!is_trained()) {
         throw std::runtime_error("Model must be trained before making predictions");
     }
-    std::vector<float> raw_predictions = predict_raw(X);
+    return predictions_from_raw(predict_raw(X), X.size());
+}
+
+std::vector<int> XGBoostModel::predict(const DenseMatrixView& X) const {
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before making predictions");
+    }
+    return predictions_from_raw(predict_raw(X), X.rows);
+}
+
+std::vector<int> XGBoostModel::predictions_from_raw(const std::vector<float>& raw_predictions, size_t n_samples) const {
     std::vector<int> predictions;
-    predictions.reserve(X.size());
+    predictions.reserve(n_samples);
+    
+    size_t stride = static_cast<size_t>(raw_outputs_per_row());
+    for (size_t i = 0; stride > 0 && (i + 1) * stride <= raw_predictions.size(); ++i) {
+        predictions.push_back(prediction_from_raw_row(raw_predictions.data() + i * stride));
+    }
+    return predictions;
+}
+
+int XGBoostModel::raw_outputs_per_row() const {
+    return (config_.objective == "multi:softprob") ? config_.num_class : 1;
+}
 
+int XGBoostModel::prediction_from_raw_row(const float* raw) const {
     if (config_.objective == "multi:softmax") {
-        for (float pred : raw_predictions) {
-            int xgb_index = static_cast<int>(pred);
-            if (reverse_label_mapping_.count(xgb_index)) {
-                predictions.push_back(static_cast<int>(reverse_label_mapping_.at(xgb_index)));
-            } else {
-                predictions.push_back(xgb_index);
-            }
-        }
-    } else if (config_.objective == "multi:softprob") {
-        int n_classes = config_.num_class;
-        int n_samples = static_cast<int>(X.size());
-        for (int i = 0; i < n_samples; ++i) {
-            int best_class = 0;
-            float best_prob = raw_predictions[i * n_classes];
-            for (int c = 1; c < n_classes; ++c) {
-                float prob = raw_predictions[i * n_classes + c];
-                if (prob > best_prob) {
-                    best_prob = prob;
-                    best_class = c;
-                }
-            }
-            if (reverse_label_mapping_.count(best_class)) {
-                predictions.push_back(static_cast<int>(reverse_label_mapping_.at(best_class)));
-            } else {
-                predictions.push_back(best_class);
+        int xgb_index = static_cast<int>(raw[0]);
+        auto it = reverse_label_mapping_.find(xgb_index);
+        return it != reverse_label_mapping_.end() ? static_cast<int>(it->second) : xgb_index;
+    }
+    if (config_.objective == "multi:softprob") {
+        int best_class = 0;
+        float best_prob = raw[0];
+        for (int c = 1; c < config_.num_class; ++c) {
+            if (raw[c] > best_prob) {
+                best_prob = raw[c];
+                best_class = c;
             }
         }
-    } else {
-        for (float prob : raw_predictions) {
-            predictions.push_back((prob > config_.binary_threshold) ? 1 : 0);
-        }
+        auto it = reverse_label_mapping_.find(best_class);
+        return it != reverse_label_mapping_.end() ? static_cast<int>(it->second) : best_class;
     }
-    return predictions;
+    return (raw[0] > config_.binary_threshold) ? 1 : 0;
+}
+
+int XGBoostModel::predict_one(const float* features) const {
+    const std::vector<float>& raw = predict_batch_inplace(
+        DenseMatrixView(features, 1, static_cast<size_t>(n_features_)));
+    return prediction_from_raw_row(raw.data());
+}
+
+const std::vector<float>& XGBoostModel::predict_batch_inplace(const DenseMatrixView& X) const {
+    thread_local std::vector<float> output;
+    thread_local char array_interface[192];
+    
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before making predictions");
+    }
+    
+    std::snprintf(array_interface, sizeof(array_interface),
+                  "{\"data\":[%llu,true],\"shape\":[%llu,%llu],\"strides\":[%llu,%llu],"
+                  "\"typestr\":\"<f4\",\"version\":3}",
+                  static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(X.data)),
+                  static_cast<unsigned long long>(X.rows), static_cast<unsigned long long>(X.cols),
+                  static_cast<unsigned long long>(X.stride * sizeof(float)),
+                  static_cast<unsigned long long>(sizeof(float)));
+    
+    const bst_ulong* out_shape;
+    bst_ulong out_dim;
+    const float* out_result;
+    if (XGBoosterPredictFromDense(static_cast<BoosterHandle>(booster_), array_interface, inplace_config_.c_str(),
+                                  nullptr, &out_shape, &out_dim, &out_result) != 0) {
+        throw std::runtime_error("Prediction failed: " + std::string(XGBGetLastError()));
+    }
+    
+    size_t out_len = 1;
+    for (bst_ulong d = 0; d < out_dim; ++d) out_len *= out_shape[d];
+    output.assign(out_result, out_result + out_len);
+    return output;
+}
+
+void XGBoostModel::update_inplace_config() {
+    int iteration_end = (best_iteration_ >= 0 && best_iteration_ + 1 < boosted_rounds_) ? best_iteration_ + 1 : 0;
+    inplace_config_ = "{\"type\":0,\"training\":false,\"iteration_begin\":0,\"iteration_end\":" +
+                      std::to_string(iteration_end) + ",\"strict_shape\":false,\"cache_id\":0,\"missing\":-1}";
 }
 
 std::vector<float> XGBoostModel::predict_raw(const std::vector<std::vector<float>>& X) const {
@@ -314,32 +621,27 @@ std::vector<float> XGBoostModel::predict_raw(const std::vector<std::vector<float
     
     validate_input_dimensions(X);
     
-    int n_samples = static_cast<int>(X.size());
-    
     std::vector<float> flat_X;
-    flat_X.reserve(n_samples * n_features_);
+    flat_X.reserve(X.size() * n_features_);
     for (const auto& row : X) {
         flat_X.insert(flat_X.end(), row.begin(), row.end());
     }
     
-    DMatrixHandle dtest;
-    int ret = XGDMatrixCreateFromMat(flat_X.data(), n_samples, n_features_, -1, &dtest);
-    if (ret != 0) {
-        throw std::runtime_error("Failed to create prediction DMatrix");
+    return predict_raw(DenseMatrixView(flat_X.data(), X.size(), static_cast<size_t>(n_features_)));
+}
+
+std::vector<float> XGBoostModel::predict_raw(const DenseMatrixView& X) const {
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before making predictions");
     }
     
+    validate_input_dimensions(X);
+    
+    DMatrixHandle dtest = static_cast<DMatrixHandle>(TrainingDataset::createDMatrix(X, config_.nthread));
+    
     std::vector<float> predictions;
     try {
-        bst_ulong out_len;
-        const float* out_result;
-        
-        ret = XGBoosterPredict(static_cast<BoosterHandle>(booster_), dtest, 0, 0, 0, &out_len, &out_result);
-        if (ret != 0) {
-            throw std::runtime_error("Prediction failed");
-        }
-        
-        predictions.assign(out_result, out_result + out_len);
-        
+        predictions = predict_raw_dmatrix(dtest);
     } catch (...) {
         XGDMatrixFree(dtest);
         throw;
@@ -349,6 +651,282 @@ std::vector<float> XGBoostModel::predict_raw(const std::vector<std::vector<float
     return predictions;
 }
 
+std::vector<float> XGBoostModel::predict_raw(const TrainingDataset& dataset) const {
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before making predictions");
+    }
+    if (static_cast<int>(dataset.cols()) != n_features_) {
+        throw std::invalid_argument("Input feature dimensions do not match training dimensions. Expected: " + 
+                                  std::to_string(n_features_) + ", got: " + std::to_string(dataset.cols()));
+    }
+    return predict_raw_dmatrix(dataset.handle());
+}
+
+std::vector<int> XGBoostModel::predict(const TrainingDataset& dataset) const {
+    return predictions_from_raw(predict_raw(dataset), dataset.rows());
+}
+
+std::vector<float> XGBoostModel::predict_margin(const DenseMatrixView& X) const {
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before making predictions");
+    }
+    
+    validate_input_dimensions(X);
+    
+    DMatrixHandle dtest = static_cast<DMatrixHandle>(TrainingDataset::createDMatrix(X, config_.nthread));
+    
+    std::vector<float> margins;
+    try {
+        margins = predict_raw_dmatrix(dtest, true);
+    } catch (...) {
+        XGDMatrixFree(dtest);
+        throw;
+    }
+    
+    XGDMatrixFree(dtest);
+    return margins;
+}
+
+std::vector<float> XGBoostModel::predict_raw_dmatrix(void* dmatrix, bool output_margin) const {
+    bst_ulong out_len;
+    const float* out_result;
+    
+    if (best_iteration_ >= 0 && best_iteration_ + 1 < boosted_rounds_) {
+        // Trees boosted past the best iteration are kept but left out of prediction.
+        std::string config = "{\"type\":" + std::string(output_margin ? "1" : "0") +
+                             ",\"training\":false,\"iteration_begin\":0,\"iteration_end\":" +
+                             std::to_string(best_iteration_ + 1) + ",\"strict_shape\":false}";
+        const bst_ulong* out_shape;
+        bst_ulong out_dim;
+        if (XGBoosterPredictFromDMatrix(static_cast<BoosterHandle>(booster_), static_cast<DMatrixHandle>(dmatrix),
+                                        config.c_str(), &out_shape, &out_dim, &out_result) != 0) {
+            throw std::runtime_error("Prediction failed");
+        }
+        out_len = 1;
+        for (bst_ulong d = 0; d < out_dim; ++d) out_len *= out_shape[d];
+        return std::vector<float>(out_result, out_result + out_len);
+    }
+    
+    int ret = XGBoosterPredict(static_cast<BoosterHandle>(booster_), static_cast<DMatrixHandle>(dmatrix),
+                               output_margin ? 1 : 0, 0, 0, &out_len, &out_result);
+    if (ret != 0) {
+        throw std::runtime_error("Prediction failed");
+    }
+    
+    return std::vector<float>(out_result, out_result + out_len);
+}
+
+ClassificationOutput XGBoostModel::predict_full(const DenseMatrixView& X) const {
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before making predictions");
+    }
+    
+    ClassificationOutput output;
+    output.rows = X.rows;
+    
+    if (config_.objective == "multi:softprob" || config_.objective == "multi:softmax") {
+        output.num_classes = static_cast<size_t>(config_.num_class);
+        if (config_.objective == "multi:softprob") {
+            output.probabilities = predict_raw(X);
+        } else {
+            output.probabilities = predict_margin(X);
+            for (size_t i = 0; i < X.rows && output.num_classes > 0; ++i) {
+                float* row = output.probabilities.data() + i * output.num_classes;
+                float max_margin = *std::max_element(row, row + output.num_classes);
+                float total = 0.0f;
+                for (size_t c = 0; c < output.num_classes; ++c) {
+                    row[c] = std::exp(row[c] - max_margin);
+                    total += row[c];
+                }
+                for (size_t c = 0; c < output.num_classes; ++c) row[c] /= total;
+            }
+        }
+        if (output.num_classes == 0 || output.probabilities.size() != X.rows * output.num_classes) {
+            throw std::runtime_error("Unexpected prediction shape for " + config_.objective);
+        }
+        
+        output.class_indices.resize(X.rows);
+        for (size_t i = 0; i < X.rows; ++i) {
+            const float* row = output.row(i);
+            output.class_indices[i] = static_cast<int>(std::max_element(row, row + output.num_classes) - row);
+        }
+    } else if (config_.objective == "binary:logistic") {
+        output.num_classes = 2;
+        std::vector<float> p = predict_raw(X);
+        output.probabilities.resize(X.rows * 2);
+        output.class_indices.resize(X.rows);
+        for (size_t i = 0; i < X.rows; ++i) {
+            output.probabilities[2 * i] = 1.0f - p[i];
+            output.probabilities[2 * i + 1] = p[i];
+            output.class_indices[i] = p[i] > config_.binary_threshold ? 1 : 0;
+        }
+    } else {
+        throw std::invalid_argument("predict_full requires a classification objective, got " + config_.objective);
+    }
+    
+    output.class_labels.resize(output.num_classes);
+    for (size_t c = 0; c < output.num_classes; ++c) {
+        auto it = reverse_label_mapping_.find(static_cast<int>(c));
+        output.class_labels[c] = it != reverse_label_mapping_.end() ? it->second : static_cast<float>(c);
+    }
+    output.labels.resize(X.rows);
+    for (size_t i = 0; i < X.rows; ++i) {
+        output.labels[i] = static_cast<int>(output.class_labels[output.class_indices[i]]);
+    }
+    return output;
+}
+
+std::vector<std::string> XGBoostModel::dump_trees_json() const {
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before it can be dumped");
+    }
+    
+    bst_ulong n_trees = 0;
+    const char** dumps = nullptr;
+    if (XGBoosterDumpModelEx(static_cast<BoosterHandle>(booster_), "", 0, "json", &n_trees, &dumps) != 0) {
+        throw std::runtime_error("Failed to dump model: " + std::string(XGBGetLastError()));
+    }
+    return std::vector<std::string>(dumps, dumps + n_trees);
+}
+
+int XGBoostModel::prediction_rounds() const {
+    return (best_iteration_ >= 0 && best_iteration_ + 1 < boosted_rounds_) ? best_iteration_ + 1 : boosted_rounds_;
+}
+
+int XGBoostModel::num_output_groups() const {
+    return (config_.objective.find("multi:") == 0 && config_.num_class > 0) ? config_.num_class : 1;
+}
+
+std::vector<char> XGBoostModel::save_to_buffer() const {
+    if (!is_trained()) {
+        throw std::runtime_error("Model must be trained before it can be saved");
+    }
+    
+    std::ostringstream state;
+    state << std::setprecision(17) << "num_features=" << n_features_ << ";boosted_rounds=" << boosted_rounds_
+          << ";best_iteration=" << best_iteration_ << ";best_score=" << best_score_ << ";max_bin=" << max_bin_;
+    
+    // Attributes are written on a copy so the live booster is only ever read here and
+    // concurrent predictions on a shared const model are unaffected.
+    bst_ulong out_len = 0;
+    const char* out_data = nullptr;
+    if (XGBoosterSaveModelToBuffer(static_cast<BoosterHandle>(booster_), "{\"format\":\"ubj\"}",
+                                   &out_len, &out_data) != 0) {
+        throw std::runtime_error("Failed to serialize model: " + std::string(XGBGetLastError()));
+    }
+    BoosterHandle copy = nullptr;
+    if (XGBoosterCreate(nullptr, 0, &copy) != 0) {
+        throw std::runtime_error("Failed to create XGBoost booster");
+    }
+    std::vector<char> buffer;
+    const bool saved =
+        XGBoosterLoadModelFromBuffer(copy, out_data, out_len) == 0 &&
+        XGBoosterSetAttr(copy, ATTR_FORMAT, MODEL_FORMAT_VERSION) == 0 &&
+        XGBoosterSetAttr(copy, ATTR_CONFIG, serializeConfig(config_).c_str()) == 0 &&
+        XGBoosterSetAttr(copy, ATTR_LABELS, serializeLabelMapping(label_mapping_).c_str()) == 0 &&
+        XGBoosterSetAttr(copy, ATTR_FEATURES, joinLines(feature_names_).c_str()) == 0 &&
+        XGBoosterSetAttr(copy, ATTR_STATE, state.str().c_str()) == 0 &&
+        XGBoosterSaveModelToBuffer(copy, "{\"format\":\"ubj\"}", &out_len, &out_data) == 0;
+    if (saved) buffer.assign(out_data, out_data + out_len);
+    std::string error = saved ? "" : XGBGetLastError();
+    XGBoosterFree(copy);
+    if (!saved) {
+        throw std::runtime_error("Failed to store model metadata: " + error);
+    }
+    return buffer;
+}
+
+void XGBoostModel::load_from_buffer(const char* data, size_t size) {
+    BoosterHandle booster = nullptr;
+    if (XGBoosterCreate(nullptr, 0, &booster) != 0) {
+        throw std::runtime_error("Failed to create XGBoost booster");
+    }
+    
+    try {
+        if (XGBoosterLoadModelFromBuffer(booster, data, size) != 0) {
+            throw std::runtime_error("not a valid XGBoost model: " + std::string(XGBGetLastError()));
+        }
+        
+        std::string format, config_text, labels_text, features_text, state_text;
+        if (!getAttr(booster, ATTR_FORMAT, format) || !getAttr(booster, ATTR_CONFIG, config_text) ||
+            !getAttr(booster, ATTR_STATE, state_text)) {
+            throw std::runtime_error("model was not saved by XGBoostModel");
+        }
+        if (format != MODEL_FORMAT_VERSION) {
+            throw std::runtime_error("unsupported model format version " + format);
+        }
+        getAttr(booster, ATTR_LABELS, labels_text);
+        getAttr(booster, ATTR_FEATURES, features_text);
+        
+        XGBoostConfig config = parseConfig(config_text);
+        auto state = splitPairs(state_text, ';');
+        std::map<float, int> mapping = parseLabelMapping(labels_text);
+        int n_features = std::stoi(state.at("num_features"));
+        int boosted_rounds = std::stoi(state.at("boosted_rounds"));
+        int best_iteration = std::stoi(state.at("best_iteration"));
+        double best_score = std::stod(state.at("best_score"));
+        // Files written before max_bin was persisted were trained on a plain DMatrix.
+        int max_bin = state.count("max_bin") ? std::stoi(state.at("max_bin")) : 0;
+        
+        clear();
+        booster_ = booster;
+        booster = nullptr;
+        config_ = config;
+        n_features_ = n_features;
+        boosted_rounds_ = boosted_rounds;
+        best_iteration_ = best_iteration;
+        best_score_ = best_score;
+        max_bin_ = max_bin;
+        label_mapping_ = mapping;
+        for (const auto& [label, index] : label_mapping_) {
+            reverse_label_mapping_[index] = label;
+        }
+        feature_names_ = splitLines(features_text);
+        
+        // Training parameters are not part of the model file; restore them for warm starts.
+        set_xgboost_parameters(config_);
+        set_max_bin_parameter();
+        update_inplace_config();
+        trained_ = true;
+    } catch (const std::exception& e) {
+        if (booster) XGBoosterFree(booster);
+        if (!trained_) clear();
+        throw std::runtime_error("Failed to load model: " + std::string(e.what()));
+    }
+}
+
+void XGBoostModel::save(const std::string& path) const {
+    std::vector<char> buffer = save_to_buffer();
+    
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!out) {
+            std::remove(tmp_path.c_str());
+            throw std::runtime_error("Failed to write model file " + tmp_path);
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Failed to write model file " + path);
+    }
+}
+
+void XGBoostModel::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw TripleBarrier::DataLoadException(path, "cannot open model file");
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    try {
+        load_from_buffer(buffer.data(), buffer.size());
+    } catch (const std::exception& e) {
+        throw TripleBarrier::DataLoadException(path, e.what());
+    }
+}
+
 void XGBoostModel::set_feature_names(const std::vector<std::string>& names) {
     if (trained_ && !names.empty() && static_cast<int>(names.size()) != n_features_) {
         throw std::invalid_argument("Number of feature names must match number of features");
@@ -371,4 +949,8 @@ std::vector<float> XGBoostModel::predict_proba(const std::vector<std::vector<flo
     return predict_raw(X);
 }
 
+std::vector<float> XGBoostModel::predict_proba(const DenseMatrixView& X) const {
+    return predict_raw(X);
+}
+
 }
@@ -3,6 +3,8 @@
 #include <string>
 #include <memory>
 #include <map>
+#include "DenseMatrix.h"
+#include "TrainingDataset.h"
 
 namespace MLPipeline {
 
@@ -19,6 +21,24 @@ struct XGBoostConfig {
     double min_child_weight = 1.0;
     double binary_threshold = 0.5;
     int num_class = 0;
+    int early_stopping_rounds = 0;   // stop after this many rounds without eval improvement (0 = off)
+    std::string eval_metric;         // empty = XGBoost's default for the objective
+};
+
+// binary:* and multi:* objectives, whose predictions are class labels.
+bool isClassificationObjective(const std::string& objective);
+
+// Everything a classifier produces for a batch, from a single booster call.
+struct ClassificationOutput {
+    size_t rows = 0;
+    size_t num_classes = 0;
+    std::vector<float> probabilities;  // rows x num_classes, row-major
+    std::vector<int> class_indices;    // most probable column of each row
+    std::vector<int> labels;           // class_indices mapped back to the training labels
+    std::vector<float> class_labels;   // training label of each probability column
+    
+    const float* row(size_t i) const { return probabilities.data() + i * num_classes; }
+    float confidence(size_t i) const { return row(i)[class_indices[i]]; }
 };
 
 class IMLModel {
@@ -50,12 +70,80 @@ public:
              int n_rounds = 10, int max_depth = 3, int nthread = 4, const std::string& objective = "binary:logistic");
     std::vector<float> predict_proba(const std::vector<std::vector<float>>& X) const;
     
+    // Contiguous-buffer variants: XGBoost reads the caller's buffer through its array
+    // interface, skipping the nested-vector conversion. The DMatrix still copies the
+    // values into its own storage; only the in-place calls below avoid that copy.
+    void fit(const DenseMatrixView& X, const std::vector<float>& y, const XGBoostConfig& config);
+    std::vector<int> predict(const DenseMatrixView& X) const;
+    std::vector<float> predict_raw(const DenseMatrixView& X) const;
+    std::vector<float> predict_proba(const DenseMatrixView& X) const;
+    
+    // Class indices, the probability matrix and mapped labels in one pass. multi:softmax
+    // probabilities come from the margins; binary:logistic yields two columns.
+    ClassificationOutput predict_full(const DenseMatrixView& X) const;
+    
+    // Low-latency scoring for live signals: no validation, no DMatrix, no copies of the
+    // input. XGBoost reads the caller's buffer in place and the outputs land in a
+    // thread-local buffer that is reused, so the returned reference stays valid until
+    // the next in-place call on the same thread. Rows must have get_num_features() values.
+    // These are the only prediction calls that may run concurrently on one model; the
+    // DMatrix-based predict/predict_raw/predict_margin share XGBoost's prediction cache.
+    int predict_one(const float* features) const;
+    const std::vector<float>& predict_batch_inplace(const DenseMatrixView& X) const;
+    
+    // Decodes one row of raw output (raw_outputs_per_row() values) into a label.
+    int prediction_from_raw_row(const float* raw) const;
+    int raw_outputs_per_row() const;
+    
+    // Untransformed scores (log-odds, per-class margins) before the objective's link function.
+    std::vector<float> predict_margin(const DenseMatrixView& X) const;
+    
+    // JSON dump of every boosted tree in boosting order, num_output_groups() trees per round.
+    std::vector<std::string> dump_trees_json() const;
+    // Rounds used at prediction time: all of them, or those up to the best iteration.
+    int prediction_rounds() const;
+    int num_output_groups() const;
+    
+    // Trains on a prepared dataset without re-validating or rebuilding the DMatrix.
+    // config.objective must match the objective the dataset was prepared for.
+    void fit(const TrainingDataset& dataset, const XGBoostConfig& config);
+    // With config.early_stopping_rounds > 0, evaluates on eval_set after every round and
+    // stops once that many rounds pass without improvement; prediction then uses the trees
+    // up to the best iteration only. eval_set should be prepared against dataset.
+    void fit(const TrainingDataset& dataset, const TrainingDataset& eval_set, const XGBoostConfig& config);
+    std::vector<int> predict(const TrainingDataset& dataset) const;
+    std::vector<float> predict_raw(const TrainingDataset& dataset) const;
+    
+    // Boosts additional_rounds more trees on top of the current model; the dataset must
+    // be the one (or one prepared like the one) passed to fit.
+    void continue_training(const TrainingDataset& dataset, int additional_rounds);
+    // Warm start: keeps boosting a trained or loaded model on newly arrived rows, encoding
+    // their labels with the model's existing label mapping.
+    void continue_training(const DenseMatrixView& X, const std::vector<float>& y, int additional_rounds);
+    int boosted_rounds() const { return boosted_rounds_; }
+    // Zero-based best round found by early stopping, -1 if prediction uses every tree.
+    int best_iteration() const { return best_iteration_; }
+    double best_score() const { return best_score_; }
+    // Bins of the QuantileDMatrix the model was trained on, 0 for a plain DMatrix; warm
+    // starts from raw rows rebuild their dataset the same way.
+    int quantile_max_bin() const { return max_bin_; }
+    
+    // The booster is stored as UBJSON with the label mappings, feature names, config and
+    // QuantileDMatrix max_bin kept in its attributes, so a loaded model predicts and
+    // warm-starts like the original. Saving only reads the live booster and may run while
+    // other threads predict.
+    std::vector<char> save_to_buffer() const;
+    void load_from_buffer(const char* data, size_t size);
+    void save(const std::string& path) const;
+    void load(const std::string& path);
+    
     void clear() override;
     bool is_trained() const override;
     
     int get_num_features() const { return n_features_; }
     void set_feature_names(const std::vector<std::string>& names);
     const std::vector<std::string>& get_feature_names() const { return feature_names_; }
+    const XGBoostConfig& get_config() const { return config_; }
     
 private:
     void* booster_ = nullptr;
@@ -63,13 +151,31 @@ private:
     std::vector<std::string> feature_names_;
     XGBoostConfig config_;
     bool trained_ = false;
+    int boosted_rounds_ = 0;
+    int best_iteration_ = -1;
+    double best_score_ = 0.0;
+    int max_bin_ = 0;
     
     std::map<float, int> label_mapping_;
     std::map<int, float> reverse_label_mapping_;
     
     void free_booster();
     void validate_input_dimensions(const std::vector<std::vector<float>>& X) const;
+    void validate_input_dimensions(const DenseMatrixView& X) const;
+    void validate_hyperparameters(const XGBoostConfig& config) const;
+    std::vector<float> predict_raw_dmatrix(void* dmatrix, bool output_margin = false) const;
+    void boost_rounds(const TrainingDataset& dataset, int rounds);
+    void boost_with_early_stopping(const TrainingDataset& dataset, const TrainingDataset& eval_set,
+                                   int max_rounds, int patience);
+    void start_training(const TrainingDataset& dataset, const XGBoostConfig& config,
+                        const TrainingDataset* eval_set);
+    std::vector<int> predictions_from_raw(const std::vector<float>& raw_predictions, size_t n_samples) const;
     void set_xgboost_parameters(const XGBoostConfig& config);
+    void set_max_bin_parameter();
+    void update_inplace_config();
+    
+    // Prediction config for XGBoosterPredictFromDense, rebuilt whenever the booster changes.
+    std::string inplace_config_;
 };
 
 }
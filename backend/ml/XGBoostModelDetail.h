@@ -0,0 +1,15 @@
+#pragma once
+#include <string>
+
+// Internal helpers of XGBoostModel, exposed only so they can be unit tested.
+namespace MLPipeline {
+namespace detail {
+
+// Last metric of an XGBoosterEvalOneIter line such as "[3]\teval-logloss:0.51\teval-error:0.2",
+// the one early stopping follows. Returns false if the line holds no metric.
+bool parseEvalResult(const std::string& line, std::string& metric, double& value);
+// Whether a larger value of the metric is better (auc, aucpr, map, ndcg, pre and their @k forms).
+bool metricIsMaximized(const std::string& metric);
+
+}
+}
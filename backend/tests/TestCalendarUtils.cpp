@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "../data/CalendarUtils.h"
+#include "../data/FeatureCalculator.h"
+#include <ctime>
+#include <string>
+#include <vector>
+
+TEST(CalendarUtilsTest, DaysFromCivilEpoch) {
+    EXPECT_EQ(CalendarUtils::daysFromCivil(1970, 1, 1), 0);
+    EXPECT_EQ(CalendarUtils::daysFromCivil(1970, 1, 2), 1);
+    EXPECT_EQ(CalendarUtils::daysFromCivil(1969, 12, 31), -1);
+    EXPECT_EQ(CalendarUtils::daysFromCivil(2000, 3, 1), 11017);
+}
+
+TEST(CalendarUtilsTest, LeapYears) {
+    EXPECT_EQ(CalendarUtils::daysFromCivil(2024, 3, 1) - CalendarUtils::daysFromCivil(2024, 2, 28), 2);
+    EXPECT_EQ(CalendarUtils::daysFromCivil(2023, 3, 1) - CalendarUtils::daysFromCivil(2023, 2, 28), 1);
+    EXPECT_EQ(CalendarUtils::daysFromCivil(1900, 3, 1) - CalendarUtils::daysFromCivil(1900, 2, 28), 1);
+}
+
+TEST(CalendarUtilsTest, WeekdayMatchesKnownDates) {
+    EXPECT_EQ(CalendarUtils::weekdayFromDays(CalendarUtils::daysFromCivil(1970, 1, 1)), 4);
+    EXPECT_EQ(CalendarUtils::weekdayFromDays(CalendarUtils::daysFromCivil(2021, 1, 3)), 0);
+    EXPECT_EQ(CalendarUtils::weekdayFromDays(CalendarUtils::daysFromCivil(2023, 7, 3)), 1);
+    EXPECT_EQ(CalendarUtils::weekdayFromDays(CalendarUtils::daysFromCivil(1965, 6, 15)), 2);
+}
+
+TEST(CalendarUtilsTest, WeekdayMatchesTimegmOverRange) {
+    for (int64_t days = -800; days < 25000; days += 37) {
+        std::time_t t = static_cast<std::time_t>(days) * 86400;
+        std::tm tm = *std::gmtime(&t);
+        int64_t civil = CalendarUtils::daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+        EXPECT_EQ(civil, days);
+        EXPECT_EQ(CalendarUtils::weekdayFromDays(civil), tm.tm_wday);
+    }
+}
+
+TEST(CalendarUtilsTest, ParsesDateAndTimeFormats) {
+    auto ts = CalendarUtils::parseTimestamp("2023-07-04T13:45:10");
+    ASSERT_TRUE(ts.valid);
+    EXPECT_EQ(ts.year, 2023);
+    EXPECT_EQ(ts.month, 7);
+    EXPECT_EQ(ts.day, 4);
+    EXPECT_EQ(ts.hour, 13);
+    EXPECT_EQ(ts.minute, 45);
+    EXPECT_EQ(ts.second, 10);
+
+    auto spaced = CalendarUtils::parseTimestamp("2023/07/04 09:30");
+    ASSERT_TRUE(spaced.valid);
+    EXPECT_EQ(CalendarUtils::minuteOfDay(spaced), 9 * 60 + 30);
+
+    auto dateOnly = CalendarUtils::parseTimestamp("2023-07-04");
+    ASSERT_TRUE(dateOnly.valid);
+    EXPECT_EQ(dateOnly.hour, 0);
+}
+
+TEST(CalendarUtilsTest, RejectsMalformedTimestamps) {
+    EXPECT_FALSE(CalendarUtils::parseTimestamp("").valid);
+    EXPECT_FALSE(CalendarUtils::parseTimestamp("2023-13-01").valid);
+    EXPECT_FALSE(CalendarUtils::parseTimestamp("2023-07/01").valid);
+    EXPECT_FALSE(CalendarUtils::parseTimestamp("not a date").valid);
+    EXPECT_FALSE(CalendarUtils::parseTimestamp("2023-07-01 25:00").valid);
+}
+
+TEST(CalendarUtilsTest, SessionBuckets) {
+    EXPECT_EQ(CalendarUtils::sessionBucket(0), CalendarUtils::ASIA);
+    EXPECT_EQ(CalendarUtils::sessionBucket(8 * 60 - 1), CalendarUtils::ASIA);
+    EXPECT_EQ(CalendarUtils::sessionBucket(8 * 60), CalendarUtils::EUROPE);
+    EXPECT_EQ(CalendarUtils::sessionBucket(14 * 60), CalendarUtils::EUROPE_US);
+    EXPECT_EQ(CalendarUtils::sessionBucket(18 * 60), CalendarUtils::US);
+    EXPECT_EQ(CalendarUtils::sessionBucket(23 * 60 + 59), CalendarUtils::OFF_HOURS);
+}
+
+TEST(CalendarUtilsTest, CalendarFeatures) {
+    std::vector<double> prices = {100, 101};
+    std::vector<std::string> timestamps = {"2023-07-03 09:15:00", "2023-07-04 14:30:00"};
+    std::vector<int> eventIndices = {1};
+    std::set<std::string> feats = {
+        FeatureCalculator::DAY_OF_WEEK, FeatureCalculator::HOUR_OF_DAY, FeatureCalculator::MINUTE_OF_DAY,
+        FeatureCalculator::MONTH_OF_YEAR, FeatureCalculator::SESSION_BUCKET
+    };
+    auto result = FeatureCalculator::calculateFeatures(prices, timestamps, eventIndices, 0, feats);
+    EXPECT_EQ(result[FeatureCalculator::DAY_OF_WEEK], 2);
+    EXPECT_EQ(result[FeatureCalculator::HOUR_OF_DAY], 14);
+    EXPECT_EQ(result[FeatureCalculator::MINUTE_OF_DAY], 14 * 60 + 30);
+    EXPECT_EQ(result[FeatureCalculator::MONTH_OF_YEAR], 7);
+    EXPECT_EQ(result[FeatureCalculator::SESSION_BUCKET], CalendarUtils::EUROPE_US);
+}
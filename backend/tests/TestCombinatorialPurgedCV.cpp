@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "../ml/CombinatorialPurgedCV.h"
+#include "../ml/MLSplits.h"
+#include "TestHelpers.h"
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+using TestHelpers::alternatingReturns;
+using TestHelpers::evenlySpacedWindows;
+using MLSplitUtils::EventWindow;
+
+namespace {
+    // Trades the sign of the realized return, so every path sees equally perfect signals,
+    // scaled by 1 + s / 100 so each signal identifies the split s whose model produced it.
+    SignalPredictor foresight(const vector<MLSplitUtils::CombinatorialSplit>& splits,
+                              const vector<double>& returns, atomic<int>& calls) {
+        return [&splits, &returns, &calls](const MLSplitUtils::RangeList& train, const MLSplitUtils::RangeList& rows,
+                                           int) {
+            ++calls;
+            size_t s = 0;
+            while (s < splits.size() && !(splits[s].fold.train == train && splits[s].fold.val == rows)) ++s;
+            EXPECT_LT(s, splits.size()) << "predictor called with ranges of no split";
+            vector<double> signals;
+            for (size_t i : MLSplitUtils::expandRanges(rows)) {
+                signals.push_back((returns[i] > 0 ? 1.0 : -1.0) * (1.0 + 0.01 * s));
+            }
+            return signals;
+        };
+    }
+}
+
+TEST(CombinatorialPurgedCVTest, EnumeratesEveryTestGroupCombination) {
+    auto windows = evenlySpacedWindows(60, 5);
+    auto splits = MLSplitUtils::combinatorialPurgedSplit(windows, 6, 2, 2);
+    ASSERT_EQ(splits.size(), 15u);
+
+    set<vector<size_t>> seen;
+    auto groups = MLSplitUtils::contiguousGroups(60, 6);
+    for (const auto& split : splits) {
+        ASSERT_EQ(split.test_groups.size(), 2u);
+        EXPECT_LT(split.test_groups[0], split.test_groups[1]);
+        seen.insert(split.test_groups);
+        EXPECT_EQ(MLSplitUtils::rangeCount(split.fold.val), 20u);
+        for (size_t i : MLSplitUtils::expandRanges(split.fold.train)) {
+            for (size_t g : split.test_groups) {
+                size_t span_start = windows[groups[g].begin].start;
+                size_t span_end = windows[groups[g].end - 1].end;
+                EXPECT_TRUE(windows[i].end < span_start || windows[i].start > span_end + 2)
+                    << "sample " << i << " leaks into group " << g;
+            }
+        }
+    }
+    EXPECT_EQ(seen.size(), 15u);
+}
+
+TEST(CombinatorialPurgedCVTest, PathsUseEachSplitOncePerTestedGroup) {
+    auto splits = MLSplitUtils::combinatorialPurgedSplit(evenlySpacedWindows(30, 1), 5, 2);
+    auto paths = MLSplitUtils::combinatorialPaths(splits, 5);
+    ASSERT_EQ(paths.size(), 4u);  // C(4, 1)
+
+    vector<int> uses(splits.size(), 0);
+    for (const auto& path : paths) {
+        ASSERT_EQ(path.size(), 5u);
+        for (size_t g = 0; g < 5; ++g) {
+            const auto& tested = splits[path[g]].test_groups;
+            EXPECT_NE(find(tested.begin(), tested.end(), g), tested.end());
+            uses[path[g]]++;
+        }
+    }
+    for (int n : uses) EXPECT_EQ(n, 2);
+
+    EXPECT_THROW(MLSplitUtils::combinatorialPurgedSplit(evenlySpacedWindows(30, 1), 5, 5), std::invalid_argument);
+    EXPECT_THROW(MLSplitUtils::combinatorialPurgedSplit(evenlySpacedWindows(3, 1), 5, 2), std::invalid_argument);
+}
+
+TEST(CombinatorialPurgedCVTest, ReassemblesOutOfSamplePredictionsIntoPaths) {
+    const size_t n = 48;
+    auto returns = alternatingReturns(n);
+    auto splits = MLSplitUtils::combinatorialPurgedSplit(evenlySpacedWindows(n, 3), 4, 2, 1);
+    CoreBudget budget;
+    budget.jobs = 3;
+
+    atomic<int> calls{0};
+    auto result = runCombinatorialBacktest(splits, 4, returns, budget, foresight(splits, returns, calls));
+    EXPECT_EQ(calls.load(), 6);
+    ASSERT_EQ(result.paths.size(), 3u);  // C(3, 1)
+    ASSERT_EQ(result.path_sharpes.size(), 3u);
+
+    auto groups = MLSplitUtils::contiguousGroups(n, 4);
+    for (const auto& path : result.paths) {
+        ASSERT_EQ(path.signals.size(), n);
+        ASSERT_EQ(path.splits.size(), groups.size());
+        for (size_t g = 0; g < groups.size(); ++g) {
+            const double scale = 1.0 + 0.01 * path.splits[g];
+            for (size_t i = groups[g].begin; i < groups[g].end; ++i) {
+                EXPECT_DOUBLE_EQ(path.signals[i], (returns[i] > 0 ? 1.0 : -1.0) * scale)
+                    << "sample " << i << " of group " << g << " not from split " << path.splits[g];
+            }
+        }
+        EXPECT_GT(path.portfolio.final_capital, path.portfolio.starting_capital);
+        EXPECT_GT(path.sharpe, 0.0);
+        EXPECT_DOUBLE_EQ(path.sharpe, result.paths.front().sharpe);
+    }
+    EXPECT_DOUBLE_EQ(result.mean_sharpe, result.path_sharpes.front());
+    EXPECT_NEAR(result.std_sharpe, 0.0, 1e-12);
+}
+
+TEST(CombinatorialPurgedCVTest, RejectsPredictorsReturningTheWrongCount) {
+    auto returns = alternatingReturns(12);
+    auto splits = MLSplitUtils::combinatorialPurgedSplit(evenlySpacedWindows(12, 1), 3, 1);
+    CoreBudget budget;
+    auto short_predictor = [](const MLSplitUtils::RangeList&, const MLSplitUtils::RangeList& rows, int) {
+        return vector<double>(MLSplitUtils::rangeCount(rows) - 1, 0.0);
+    };
+    EXPECT_THROW(runCombinatorialBacktest(splits, 3, returns, budget, short_predictor), std::runtime_error);
+}
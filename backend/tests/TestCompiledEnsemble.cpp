@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include "../ml/CompiledEnsemble.h"
+#include "../ml/XGBoostModel.h"
+#include "../ml/TrainingDataset.h"
+#include "../utils/Exceptions.h"
+#include "TestHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+using TestHelpers::SyntheticData;
+using TestHelpers::makeSyntheticData;
+
+namespace {
+    // f0 < 0.5 -> -0.2, otherwise f1 < 2 -> 0.1 else 0.3; missing f0 goes left, missing f1 right.
+    const string kSplitTree = R"({ "nodeid": 0, "depth": 0, "split": "f0", "split_condition": 0.5,
+        "yes": 1, "no": 2, "missing": 1, "children": [
+          { "nodeid": 1, "leaf": -0.2 },
+          { "nodeid": 2, "depth": 1, "split": "f1", "split_condition": 2, "yes": 3, "no": 4, "missing": 4,
+            "children": [ { "nodeid": 3, "leaf": 0.1 }, { "nodeid": 4, "leaf": 0.3 } ] }
+        ]})";
+    const string kLeafTree = R"({ "nodeid": 0, "leaf": 0.05 })";
+
+    float referenceMargin(float f0, float f1) {
+        bool f0_missing = std::isnan(f0) || f0 == -1.0f;
+        bool f1_missing = std::isnan(f1) || f1 == -1.0f;
+        float first;
+        if (f0_missing || f0 < 0.5f) {
+            first = -0.2f;
+        } else {
+            first = (!f1_missing && f1 < 2.0f) ? 0.1f : 0.3f;
+        }
+        return 0.5f + first + 0.05f;
+    }
+
+    XGBoostConfig trainingConfig(const string& objective, int n_rounds) {
+        XGBoostConfig config;
+        config.objective = objective;
+        config.n_rounds = n_rounds;
+        config.max_depth = 4;
+        config.nthread = 1;
+        return config;
+    }
+
+    // Rows with -1 and NaN holes, so the compiled trees must follow XGBoost's default
+    // directions; the all-zero probe row is included too.
+    SyntheticData rowsWithMissingValues(size_t cols, bool three_classes) {
+        SyntheticData test = makeSyntheticData(300, cols, three_classes, 21);
+        for (size_t i = 0; i < test.rows; ++i) {
+            if (i % 5 == 0) test.X[i * cols + (i % cols)] = -1.0f;
+            if (i % 9 == 0) test.X[i * cols + ((i + 1) % cols)] = NAN;
+        }
+        fill(test.X.begin(), test.X.begin() + cols, 0.0f);
+        return test;
+    }
+
+    void expectSamePredictions(const XGBoostModel& model, const DenseMatrixView& X) {
+        CompiledEnsemble compiled = CompiledEnsemble::compile(model);
+        auto expected = model.predict_raw(X);
+        auto actual = compiled.predict_raw(X);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_NEAR(actual[i], expected[i], 1e-5f * max(1.0f, fabs(expected[i]))) << "output " << i;
+        }
+    }
+}
+
+TEST(CompiledEnsembleTest, MatchesHandEvaluatedTrees) {
+    auto ensemble = CompiledEnsemble::fromJsonDump({kSplitTree, kLeafTree}, 2, "reg:squarederror", {0.5f});
+    EXPECT_EQ(ensemble.num_trees(), 2u);
+    EXPECT_EQ(ensemble.num_nodes(), 6u);
+
+    vector<float> rows = {0.0f, 0.0f,
+                          1.0f, 1.0f,
+                          1.0f, 5.0f,
+                          -1.0f, 1.0f,
+                          1.0f, -1.0f,
+                          NAN, 3.0f};
+    auto raw = ensemble.predict_raw(DenseMatrixView(rows.data(), 6, 2));
+    ASSERT_EQ(raw.size(), 6u);
+    for (size_t i = 0; i < 6; ++i) {
+        EXPECT_FLOAT_EQ(raw[i], referenceMargin(rows[2 * i], rows[2 * i + 1])) << "row " << i;
+    }
+}
+
+TEST(CompiledEnsembleTest, BlocksLargerThanOneBatchAgreeWithRowByRow) {
+    auto ensemble = CompiledEnsemble::fromJsonDump({kSplitTree, kLeafTree, kSplitTree}, 3,
+                                                   "binary:logistic", {0.0f});
+    vector<float> rows;
+    for (int i = 0; i < 53; ++i) {
+        rows.push_back(static_cast<float>(i % 3) * 0.4f);
+        rows.push_back(static_cast<float>(i % 5));
+        rows.push_back(static_cast<float>(i));
+    }
+    DenseMatrixView view(rows.data(), 53, 3);
+    auto batch = ensemble.predict_raw(view);
+    ASSERT_EQ(batch.size(), 53u);
+    for (size_t i = 0; i < 53; ++i) {
+        auto single = ensemble.predict_raw(view.rowRange(i, i + 1));
+        EXPECT_FLOAT_EQ(batch[i], single[0]);
+        EXPECT_GT(batch[i], 0.0f);
+        EXPECT_LT(batch[i], 1.0f);
+    }
+}
+
+TEST(CompiledEnsembleTest, MultiClassTreesAreInterleavedByGroup) {
+    const string group0 = R"({"nodeid":0,"leaf":1.0})";
+    const string group1 = R"({"nodeid":0,"leaf":0.0})";
+    const string group2 = R"({"nodeid":0,"split":"f0","split_condition":0,"yes":1,"no":2,"missing":1,
+                              "children":[{"nodeid":1,"leaf":-1.0},{"nodeid":2,"leaf":3.0}]})";
+    auto probs = CompiledEnsemble::fromJsonDump({group0, group1, group2}, 1, "multi:softprob", {0.5f, 0.5f, 0.5f});
+    vector<float> rows = {-2.0f, 2.0f};
+    auto out = probs.predict_raw(DenseMatrixView(rows.data(), 2, 1));
+    ASSERT_EQ(out.size(), 6u);
+    EXPECT_NEAR(out[0] + out[1] + out[2], 1.0f, 1e-6f);
+    EXPECT_GT(out[0], out[1]);
+    EXPECT_GT(out[5], out[3]);
+
+    auto classes = CompiledEnsemble::fromJsonDump({group0, group1, group2}, 1, "multi:softmax", {0.5f, 0.5f, 0.5f});
+    auto predicted = classes.predict_raw(DenseMatrixView(rows.data(), 2, 1));
+    ASSERT_EQ(predicted.size(), 2u);
+    EXPECT_FLOAT_EQ(predicted[0], 0.0f);
+    EXPECT_FLOAT_EQ(predicted[1], 2.0f);
+}
+
+TEST(CompiledEnsembleTest, RejectsInvalidDumpsAndInputs) {
+    using TripleBarrier::ModelPredictionException;
+    EXPECT_THROW(CompiledEnsemble::fromJsonDump({kSplitTree}, 2, "rank:pairwise", {0.0f}), ModelPredictionException);
+    EXPECT_THROW(CompiledEnsemble::fromJsonDump({"{\"nodeid\":0,"}, 2, "reg:squarederror", {0.0f}),
+                 ModelPredictionException);
+    EXPECT_THROW(CompiledEnsemble::fromJsonDump({kSplitTree}, 1, "reg:squarederror", {0.0f}),
+                 ModelPredictionException);
+    EXPECT_THROW(CompiledEnsemble::fromJsonDump(
+                     {R"({"nodeid":0,"split":"f0","split_condition":1,"yes":1,"no":7,"missing":1,
+                         "children":[{"nodeid":1,"leaf":0}]})"}, 1, "reg:squarederror", {0.0f}),
+                 ModelPredictionException);
+
+    auto ensemble = CompiledEnsemble::fromJsonDump({kSplitTree}, 2, "reg:squarederror", {0.0f});
+    vector<float> rows = {1.0f, 2.0f, 3.0f};
+    EXPECT_THROW(ensemble.predict_raw(DenseMatrixView(rows.data(), 1, 3)), std::invalid_argument);
+
+    XGBoostModel untrained;
+    EXPECT_THROW(CompiledEnsemble::compile(untrained), ModelPredictionException);
+}
+
+TEST(CompiledEnsembleTest, CompiledBinaryModelMatchesXGBoost) {
+    SyntheticData train = makeSyntheticData(800, 6, false, 20);
+    train.X[3] = -1.0f;  // missing values seen in training give the splits learned defaults
+    XGBoostModel model;
+    model.fit(train.view(), train.y, trainingConfig("binary:logistic", 25));
+
+    SyntheticData test = rowsWithMissingValues(6, false);
+    expectSamePredictions(model, test.view());
+}
+
+TEST(CompiledEnsembleTest, CompiledSoftprobModelMatchesXGBoost) {
+    SyntheticData train = makeSyntheticData(900, 5, true, 22);
+    for (size_t i = 0; i < train.rows; i += 11) train.X[i * train.cols + 2] = -1.0f;
+    XGBoostModel model;
+    model.fit(train.view(), train.y, trainingConfig("multi:softprob", 15));
+
+    CompiledEnsemble compiled = CompiledEnsemble::compile(model);
+    EXPECT_EQ(compiled.num_groups(), 3);
+    EXPECT_EQ(compiled.num_trees(), 45u);
+    SyntheticData test = rowsWithMissingValues(5, true);
+    expectSamePredictions(model, test.view());
+}
+
+TEST(CompiledEnsembleTest, CompiledEarlyStoppedModelUsesOnlyTheBestTrees) {
+    SyntheticData train = makeSyntheticData(800, 6, false, 23);
+    SyntheticData eval = makeSyntheticData(300, 6, false, 24);
+    for (float& label : eval.y) label = 1.0f - label;
+    TrainingDataset train_data(train.view(), train.y, "binary:logistic");
+    TrainingDataset eval_data(eval.view(), eval.y, train_data);
+    XGBoostConfig config = trainingConfig("binary:logistic", 200);
+    config.early_stopping_rounds = 5;
+    XGBoostModel model;
+    model.fit(train_data, eval_data, config);
+    ASSERT_LT(model.prediction_rounds(), model.boosted_rounds());
+
+    CompiledEnsemble compiled = CompiledEnsemble::compile(model);
+    EXPECT_EQ(compiled.num_trees(), static_cast<size_t>(model.prediction_rounds()));
+    SyntheticData test = rowsWithMissingValues(6, false);
+    expectSamePredictions(model, test.view());
+}
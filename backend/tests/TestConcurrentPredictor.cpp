@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "../ml/ConcurrentPredictor.h"
+#include "../ml/XGBoostModel.h"
+#include "../utils/Exceptions.h"
+#include "TestHelpers.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+using TestHelpers::SyntheticData;
+using TestHelpers::makeSyntheticData;
+
+namespace {
+    shared_ptr<const XGBoostModel> train(const SyntheticData& data) {
+        auto model = make_shared<XGBoostModel>();
+        XGBoostConfig config;
+        config.n_rounds = 30;
+        config.max_depth = 4;
+        config.nthread = 1;
+        model->fit(data.view(), data.y, config);
+        return model;
+    }
+}
+
+TEST(ConcurrentPredictorTest, RejectsUntrainedModelsAndBadInput) {
+    EXPECT_THROW(ConcurrentPredictor(nullptr), TripleBarrier::ModelPredictionException);
+    EXPECT_THROW(ConcurrentPredictor(make_shared<XGBoostModel>()), TripleBarrier::ModelPredictionException);
+}
+
+TEST(ConcurrentPredictorTest, ManyThreadsMatchSerialPredictions) {
+    SyntheticData data = makeSyntheticData(2000, 8, false);
+    auto model = train(data);
+    ConcurrentPredictor predictor(model);
+
+    DenseMatrixView all = data.view();
+    const vector<float> expected_raw = model->predict_raw(all);
+    const vector<int> expected = model->predict(all);
+
+    vector<float> wrong_width(data.cols + 1, 0.0f);
+    EXPECT_THROW(predictor.predict_raw(DenseMatrixView(wrong_width.data(), 1, data.cols + 1)), std::invalid_argument);
+
+    const unsigned n_threads = 8;
+    const size_t passes = 20;
+    atomic<size_t> mismatches{0};
+    atomic<size_t> scored{0};
+    vector<thread> threads;
+    for (unsigned t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            ConcurrentPredictor::Context context;
+            for (size_t pass = 0; pass < passes; ++pass) {
+                // Alternate between single rows, own-context batches and thread-local batches.
+                size_t batch = 1 + (t * 7 + pass * 13) % 64;
+                for (size_t start = t; start + batch <= data.rows; start += batch * n_threads) {
+                    DenseMatrixView block = all.rowRange(start, start + batch);
+                    if (batch == 1) {
+                        if (predictor.predict_one(block.row(0)) != expected[start]) mismatches++;
+                    } else if (pass % 2 == 0) {
+                        const auto& raw = predictor.predict_raw(block, context);
+                        for (size_t i = 0; i < batch; ++i) {
+                            if (std::abs(raw[i] - expected_raw[start + i]) > 1e-6f) mismatches++;
+                        }
+                    } else {
+                        const auto& labels = predictor.predict(block);
+                        for (size_t i = 0; i < batch; ++i) {
+                            if (labels[i] != expected[start + i]) mismatches++;
+                        }
+                    }
+                    scored += batch;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    EXPECT_EQ(mismatches.load(), 0u);
+    EXPECT_GT(scored.load(), data.rows * passes / 2);
+}
+
+TEST(ConcurrentPredictorTest, MultiClassLabelsSurviveConcurrentDecoding) {
+    SyntheticData data = makeSyntheticData(1500, 6, true);
+    auto model = train(data);
+    ConcurrentPredictor predictor(model);
+
+    DenseMatrixView all = data.view();
+    const vector<int> expected = model->predict(all);
+
+    atomic<size_t> mismatches{0};
+    vector<thread> threads;
+    for (unsigned t = 0; t < 6; ++t) {
+        threads.emplace_back([&]() {
+            for (int repeat = 0; repeat < 10; ++repeat) {
+                const auto& labels = predictor.predict(all);
+                for (size_t i = 0; i < labels.size(); ++i) {
+                    if (labels[i] != expected[i]) mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    EXPECT_EQ(mismatches.load(), 0u);
+}
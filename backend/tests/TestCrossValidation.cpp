@@ -0,0 +1,292 @@
+#include <gtest/gtest.h>
+#include "../ml/CrossValidation.h"
+#include "../ml/MLPipeline.h"
+#include "../ml/MLSplits.h"
+#include "TestHelpers.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+using MLSplitUtils::EventWindow;
+using MLSplitUtils::RangeFold;
+using TestHelpers::evenlySpacedWindows;
+
+namespace {
+    bool contains(const vector<size_t>& v, size_t x) {
+        return find(v.begin(), v.end(), x) != v.end();
+    }
+}
+
+TEST(CrossValidationTest, NonOverlappingWindowsKeepEverySample) {
+    auto folds = MLSplitUtils::purgedKFoldSplit(evenlySpacedWindows(20, 1), 4);
+    ASSERT_EQ(folds.size(), 4u);
+    for (const auto& fold : folds) {
+        EXPECT_EQ(fold.val_indices.size(), 5u);
+        EXPECT_EQ(fold.train_indices.size(), 15u);
+    }
+}
+
+TEST(CrossValidationTest, PurgesTrainingLabelsOverlappingValidationBlock) {
+    // Windows span 5 bars, so each event overlaps the next two.
+    auto windows = evenlySpacedWindows(20, 5);
+    auto folds = MLSplitUtils::purgedKFoldSplit(windows, 4);
+
+    // Fold 1 validates events 5..9, bars 10..23.
+    const auto& fold = folds[1];
+    EXPECT_FALSE(contains(fold.train_indices, 3));   // bars 6..11
+    EXPECT_FALSE(contains(fold.train_indices, 4));   // bars 8..13
+    EXPECT_TRUE(contains(fold.train_indices, 2));    // bars 4..9
+    EXPECT_FALSE(contains(fold.train_indices, 10));  // bars 20..25
+    EXPECT_FALSE(contains(fold.train_indices, 11));  // bars 22..27
+    EXPECT_TRUE(contains(fold.train_indices, 12));   // bars 24..29
+    for (size_t i : fold.train_indices) {
+        EXPECT_TRUE(windows[i].end < 10 || windows[i].start > 23) << "sample " << i;
+    }
+
+    auto legacy = MLSplitUtils::purgedKFoldSplit(windows.size(), 4);
+    EXPECT_LT(fold.train_indices.size(), legacy[1].train_indices.size());
+}
+
+TEST(CrossValidationTest, EmbargoDropsSamplesStartingRightAfterValidation) {
+    auto windows = evenlySpacedWindows(20, 1);
+    auto folds = MLSplitUtils::purgedKFoldSplit(windows, 4, 4);
+
+    // Fold 0 validates events 0..4, bars 0..9; the embargo runs through bar 13.
+    const auto& fold = folds[0];
+    EXPECT_FALSE(contains(fold.train_indices, 5));  // starts at bar 10
+    EXPECT_FALSE(contains(fold.train_indices, 6));  // starts at bar 12
+    EXPECT_TRUE(contains(fold.train_indices, 7));   // starts at bar 14
+    // The embargo only applies after the validation block.
+    EXPECT_TRUE(contains(folds[1].train_indices, 4));
+}
+
+TEST(CrossValidationTest, RejectsInvalidWindows) {
+    EXPECT_THROW(MLSplitUtils::purgedKFoldSplit(vector<EventWindow>{}, 3), std::invalid_argument);
+    EXPECT_THROW(MLSplitUtils::purgedKFoldSplit(evenlySpacedWindows(3, 1), 4), std::invalid_argument);
+    vector<EventWindow> backwards = {{5, 2}, {6, 7}};
+    EXPECT_THROW(MLSplitUtils::purgedKFoldSplit(backwards, 2), std::invalid_argument);
+
+    EXPECT_THROW(eventWindows({1, 2}, {3}), std::invalid_argument);
+    EXPECT_THROW(eventWindows({-1}, {3}), std::invalid_argument);
+    auto windows = eventWindows({4, 7}, {9, -1});
+    EXPECT_EQ(windows[0].end, 9u);
+    EXPECT_EQ(windows[1].end, 7u);
+}
+
+TEST(CrossValidationTest, FoldsRunConcurrentlyAndAggregateInOrder) {
+    auto folds = MLSplitUtils::purgedKFoldRanges(evenlySpacedWindows(40, 3), 4, 2);
+    CoreBudget budget;
+    budget.jobs = 4;
+    budget.threads_per_job = 2;
+
+    // Every fold waits at a barrier until all four are running, so the test only passes
+    // if the folds really overlap (the timeout keeps a serial run from hanging).
+    mutex barrierMutex;
+    condition_variable arrivedAll;
+    int running = 0;
+    int peak = 0;
+    auto evaluate = [&](const RangeFold& fold, int nthread) {
+        EXPECT_EQ(nthread, 2);
+        {
+            unique_lock<mutex> lock(barrierMutex);
+            peak = max(peak, ++running);
+            arrivedAll.notify_all();
+            arrivedAll.wait_for(lock, chrono::seconds(10), [&] { return peak >= budget.jobs; });
+        }
+
+        FoldScore score;
+        score.score = static_cast<double>(fold.val.front().begin);
+        score.metrics["train"] = static_cast<double>(MLSplitUtils::rangeCount(fold.train));
+        return score;
+    };
+
+    auto result = runCrossValidation(folds, budget, evaluate);
+    ASSERT_EQ(result.folds.size(), 4u);
+    EXPECT_EQ(result.successful_folds, 4u);
+    EXPECT_DOUBLE_EQ(result.mean_score, (0.0 + 10.0 + 20.0 + 30.0) / 4.0);
+    EXPECT_NEAR(result.std_score, std::sqrt(500.0 / 3.0), 1e-9);
+    for (size_t k = 0; k < 4; ++k) {
+        EXPECT_EQ(result.folds[k].fold, static_cast<int>(k));
+        EXPECT_EQ(result.folds[k].train_size + result.folds[k].val_size + result.folds[k].purged, 40u);
+        EXPECT_GT(result.folds[k].purged, 0u);
+    }
+    double mean_train = 0.0;
+    for (const auto& fold : folds) mean_train += MLSplitUtils::rangeCount(fold.train) / 4.0;
+    EXPECT_DOUBLE_EQ(result.mean_metrics.at("train"), mean_train);
+    EXPECT_EQ(peak, budget.jobs);
+}
+
+TEST(CrossValidationTest, FailedFoldsAreExcludedFromAggregates) {
+    auto folds = MLSplitUtils::purgedKFoldRanges(evenlySpacedWindows(12, 1), 3);
+    CoreBudget budget;
+    budget.jobs = 2;
+    auto evaluate = [](const RangeFold& fold, int) -> FoldScore {
+        if (fold.val.front().begin == 4) throw std::runtime_error("boom");
+        FoldScore score;
+        score.score = fold.val.front().begin == 0 ? 0.5 : 0.7;
+        return score;
+    };
+
+    auto result = runCrossValidation(folds, budget, evaluate);
+    EXPECT_EQ(result.successful_folds, 2u);
+    EXPECT_FALSE(result.folds[1].success);
+    EXPECT_EQ(result.folds[1].error, "boom");
+    EXPECT_NEAR(result.mean_score, 0.6, 1e-12);
+
+    auto none = runCrossValidation(folds, budget, [](const RangeFold&, int) -> FoldScore {
+        throw std::runtime_error("no");
+    });
+    EXPECT_EQ(none.successful_folds, 0u);
+    EXPECT_TRUE(std::isnan(none.mean_score));
+}
+
+TEST(CrossValidationTest, RangeFoldsMatchIndexFolds) {
+    for (int embargo : {0, 3, 7}) {
+        auto ranges = MLSplitUtils::purgedKFoldRanges(53, 5, embargo);
+        auto indices = MLSplitUtils::purgedKFoldSplit(53, 5, embargo);
+        ASSERT_EQ(ranges.size(), indices.size());
+        for (size_t k = 0; k < ranges.size(); ++k) {
+            EXPECT_LE(ranges[k].train.size(), 2u);
+            EXPECT_EQ(MLSplitUtils::expandRanges(ranges[k].train), indices[k].train_indices);
+            EXPECT_EQ(MLSplitUtils::expandRanges(ranges[k].val), indices[k].val_indices);
+        }
+    }
+
+    // Fold 2 (samples 20..29) with a 4-sample embargo trains on 0..15 and 34..52.
+    auto fold = MLSplitUtils::purgedKFoldRanges(53, 5, 4)[2];
+    ASSERT_EQ(fold.train.size(), 2u);
+    EXPECT_EQ(fold.train[0], (MLSplitUtils::IndexRange{0, 16}));
+    EXPECT_EQ(fold.train[1], (MLSplitUtils::IndexRange{34, 53}));
+    EXPECT_EQ(MLSplitUtils::rankInRanges(fold.train, 40), 22u);
+}
+
+TEST(CrossValidationTest, RowRangeViewExposesBlocksWithoutCopying) {
+    vector<float> values(10 * 3);
+    for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(i);
+    DenseMatrixView X(values.data(), 10, 3);
+
+    MLSplitUtils::RowRangeView view(X, {{1, 3}, {6, 9}});
+    EXPECT_EQ(view.rows(), 5u);
+    EXPECT_EQ(view.blocks(), 2u);
+    EXPECT_EQ(view.block(1).data, values.data() + 18);
+    EXPECT_EQ(view.block(1).rows, 3u);
+
+    auto gathered = view.gather();
+    ASSERT_EQ(gathered.rows, 5u);
+    vector<size_t> rows = {1, 2, 6, 7, 8};
+    for (size_t i = 0; i < rows.size(); ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            EXPECT_EQ(gathered.view().at(i, j), X.at(rows[i], j));
+        }
+    }
+    vector<int> labels = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(MLSplitUtils::selectRanges(labels, view.ranges), (vector<int>{1, 2, 6, 7, 8}));
+    EXPECT_THROW(MLSplitUtils::RowRangeView(X, {{8, 11}}), std::out_of_range);
+}
+
+TEST(CrossValidationTest, PipelineCrossValidationUsesTheConfiguredQuantileBins) {
+    vector<map<string, double>> X(30);
+    vector<int> y(30);
+    for (size_t i = 0; i < X.size(); ++i) {
+        X[i] = {{"a", static_cast<double>(i)}, {"b", static_cast<double>(i % 4)}};
+        y[i] = static_cast<int>(i % 2);
+    }
+    UnifiedPipelineConfig config;
+    config.cv_folds = 3;
+    config.nthread = 1;
+    config.tuning_jobs = 1;
+
+    // max_bin 1 is rejected while a fold's QuantileDMatrix is prepared, so every fold
+    // fails on it only if the pipeline's setting reaches the fold fits.
+    config.max_bin = 1;
+    auto quantized = runCrossValidation(X, y, evenlySpacedWindows(X.size(), 1), config);
+    ASSERT_EQ(quantized.folds.size(), 3u);
+    for (const auto& fold : quantized.folds) {
+        EXPECT_FALSE(fold.success);
+        EXPECT_NE(fold.error.find("max_bin"), string::npos) << fold.error;
+    }
+
+    config.use_quantile_dmatrix = false;
+    auto plain = runCrossValidation(X, y, evenlySpacedWindows(X.size(), 1), config);
+    for (const auto& fold : plain.folds) {
+        EXPECT_EQ(fold.error.find("max_bin"), string::npos) << fold.error;
+    }
+}
+
+TEST(CrossValidationTest, PurgedTuningNeedsOneWindowPerSample) {
+    vector<map<string, double>> X(20);
+    vector<int> y(20);
+    vector<double> returns(20, 0.01);
+    for (size_t i = 0; i < X.size(); ++i) {
+        X[i] = {{"a", static_cast<double>(i)}};
+        y[i] = static_cast<int>(i % 2);
+    }
+    UnifiedPipelineConfig config;
+    config.nthread = 1;
+    config.tuning_jobs = 1;
+
+    EXPECT_THROW(runPipelineWithTuning(X, y, returns, config), std::invalid_argument);
+    EXPECT_THROW(runPipelineWithTuning(X, y, returns, evenlySpacedWindows(X.size() - 1, 1), config),
+                 std::invalid_argument);
+}
+
+TEST(CrossValidationTest, TuningScoresEachCombinationByItsPurgedCrossValidationMean) {
+    vector<map<string, double>> X(120);
+    vector<int> y(120);
+    vector<double> returns(120);
+    unsigned state = 11;
+    for (size_t i = 0; i < X.size(); ++i) {
+        state = state * 1103515245u + 12345u;
+        double a = static_cast<double>((state >> 16) % 1000) / 1000.0;
+        state = state * 1103515245u + 12345u;
+        double noise = static_cast<double>((state >> 16) % 1000) / 1000.0 - 0.5;
+        X[i] = {{"a", a}, {"b", static_cast<double>(i % 7)}};
+        y[i] = a + noise > 0.5 ? 1 : 0;
+        returns[i] = y[i] == 1 ? 0.01 : -0.01;
+    }
+    auto windows = evenlySpacedWindows(X.size(), 3);
+
+    UnifiedPipelineConfig config;
+    config.nthread = 1;
+    config.tuning_jobs = 1;
+    config.cv_folds = 4;
+    config.embargo = 2;
+    config.hyperparameter_grid.n_rounds = {5};
+    config.hyperparameter_grid.max_depth = {1, 3};
+    config.hyperparameter_grid.learning_rate = {0.1, 0.3};
+    config.hyperparameter_grid.subsample = {1.0};
+    config.hyperparameter_grid.colsample_bytree = {1.0};
+
+    double expected = -numeric_limits<double>::infinity();
+    for (int depth : config.hyperparameter_grid.max_depth) {
+        for (double rate : config.hyperparameter_grid.learning_rate) {
+            UnifiedPipelineConfig combo = config;
+            combo.n_rounds = 5;
+            combo.max_depth = depth;
+            combo.learning_rate = rate;
+            auto cv = runCrossValidation(X, y, windows, combo);
+            ASSERT_EQ(cv.successful_folds, 4u);
+            expected = max(expected, cv.mean_score);
+        }
+    }
+    // Classification tuning stops early above 0.95; the noisy labels keep every
+    // combination below it so all of them are scored.
+    ASSERT_LT(expected, 0.95);
+
+    TuningProgress last;
+    config.tuning_progress = [&](const TuningProgress& progress) { last = progress; };
+    runPipelineWithTuning(X, y, returns, windows, config);
+
+    ASSERT_TRUE(last.has_best);
+    EXPECT_EQ(last.completed, 4u);
+    EXPECT_NEAR(last.best_score, expected, 1e-9);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "../ml/EventBacktester.h"
+#include "../data/LabeledEvent.h"
+#include "../data/PreprocessedRow.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+
+namespace {
+    vector<PreprocessedRow> priceSeries(const vector<double>& prices) {
+        vector<PreprocessedRow> rows(prices.size());
+        for (size_t i = 0; i < prices.size(); ++i) {
+            rows[i].timestamp = "t" + to_string(i);
+            rows[i].price = prices[i];
+        }
+        return rows;
+    }
+
+    LabeledEvent event(int entry, int periods) {
+        LabeledEvent e;
+        e.entry_time = "t" + to_string(entry);
+        e.periods_to_exit = periods;
+        return e;
+    }
+}
+
+TEST(EventBacktesterTest, HoldsOverlappingPositionsUntilTheirBarrierExit) {
+    auto rows = priceSeries({100, 100, 110, 120, 110, 100, 100});
+    vector<LabeledEvent> events = {event(1, 2), event(2, 3)};
+    events[1].entry_index = 2;  // resolved from the carried index, not the timestamp
+
+    EventBacktestConfig config;
+    auto result = runEventBacktest(rows, events, {1.0, -1.0}, config);
+
+    ASSERT_EQ(result.trade_log.size(), 2u);
+    EXPECT_EQ(result.total_trades, 2);
+    EXPECT_EQ(result.max_concurrent_positions, 2u);
+
+    // Long 250 notional at 100, closed at 120.
+    const auto& first = result.trade_log[0];
+    EXPECT_EQ(first.index, 0u);
+    EXPECT_EQ(first.decision, TradeDecision::BUY);
+    EXPECT_NEAR(first.trade_return, 50.0, 1e-9);
+
+    // Short 0.25 of equity at 110 (equity 1025 then), closed at 100.
+    const auto& second = result.trade_log[1];
+    EXPECT_EQ(second.decision, TradeDecision::SELL);
+    EXPECT_NEAR(second.capital_before, 1025.0, 1e-9);
+    EXPECT_NEAR(second.trade_return, 1025.0 * 0.25 / 110.0 * 10.0, 1e-9);
+
+    // Bar 3 marks both open positions at 120.
+    EXPECT_NEAR(result.equity[3], 1000.0 + 2.5 * 20.0 - 1025.0 * 0.25 / 110.0 * 10.0, 1e-9);
+    EXPECT_NEAR(result.final_equity, 1000.0 + first.trade_return + second.trade_return, 1e-9);
+    EXPECT_DOUBLE_EQ(result.win_rate, 1.0);
+}
+
+TEST(EventBacktesterTest, DrawdownFollowsTheMarkedEquity) {
+    auto rows = priceSeries({100, 80, 90, 90});
+    auto result = runEventBacktest(rows, {event(0, 2)}, {1.0});
+    EXPECT_NEAR(result.equity[1], 950.0, 1e-9);
+    EXPECT_NEAR(result.max_drawdown, 0.05, 1e-12);
+    EXPECT_NEAR(result.final_equity, 975.0, 1e-9);
+    EXPECT_DOUBLE_EQ(result.win_rate, 0.0);
+}
+
+TEST(EventBacktesterTest, CapsGrossExposureAndSkipsUnresolvableEvents) {
+    auto rows = priceSeries({100, 100, 100, 100, 100});
+    vector<LabeledEvent> events = {event(0, 4), event(0, 4), event(1, 2), event(1, 1)};
+    events.push_back(event(0, 1));
+    events.back().entry_time = "missing";
+
+    EventBacktestConfig config;
+    config.max_gross_exposure = 0.6;
+    auto result = runEventBacktest(rows, events, {1.0, 1.0, 1.0, 0.1, 1.0}, config);
+
+    // 0.25 + 0.25 fit, the third gets the remaining 0.1, the fourth never clears the threshold.
+    EXPECT_EQ(result.total_trades, 3);
+    EXPECT_EQ(result.skipped_events, 1u);
+    EXPECT_NEAR(result.peak_gross_exposure, 0.6, 1e-12);
+    ASSERT_EQ(result.trade_log.size(), 3u);
+    EXPECT_NEAR(result.trade_log[0].position_pct, 0.1, 1e-12);  // closes first, at bar 3
+
+    config.max_gross_exposure = 0.5;
+    EXPECT_EQ(runEventBacktest(rows, events, {1.0, 1.0, 1.0, 0.1, 1.0}, config).skipped_events, 2u);
+}
+
+TEST(EventBacktesterTest, RejectsMisalignedInputs) {
+    auto rows = priceSeries({100, 101});
+    EXPECT_THROW(runEventBacktest(rows, {event(0, 1)}, {}), std::invalid_argument);
+    EXPECT_THROW(runEventBacktest({}, {}, {}), std::invalid_argument);
+    auto flat = runEventBacktest(rows, {event(0, 1)}, {0.0});
+    EXPECT_EQ(flat.total_trades, 0);
+    EXPECT_DOUBLE_EQ(flat.final_equity, 1000.0);
+}
@@ -3,6 +3,8 @@
 #include "../data/FeatureExtractor.h"
 #include "../data/PreprocessedRow.h"
 #include "../data/LabeledEvent.h"
+#include <algorithm>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -557,3 +559,176 @@ TEST(FeatureExtractorTest, DayOfWeek_ShortWindow) {
     // 2021-01-03 is a Sunday (day 0)
     EXPECT_EQ(result.features[0][FeatureCalculator::DAY_OF_WEEK], 0);
 }
+
+// ------------------ EVENT ROW LOOKUP ------------------
+TEST(FeatureExtractorTest, EventLookup_UsesCarriedEntryIndex) {
+    vector<PreprocessedRow> rows = {makeRow(100, "2021-01-01"), makeRow(110, "2021-01-02"), makeRow(121, "2021-01-03")};
+    LabeledEvent event = makeEvent(1, "2021-01-03", 121, 121);
+    event.entry_index = 2;
+    set<string> features = {"Close-to-close return for the previous day"};
+    auto result = FeatureExtractor::extractFeaturesForClassification(features, rows, {event});
+    ASSERT_EQ(result.features.size(), 1);
+    EXPECT_NEAR(result.features[0][FeatureCalculator::CLOSE_TO_CLOSE_RETURN_1D], 0.1, 0.01);
+}
+
+TEST(FeatureExtractorTest, EventLookup_StaleIndexFallsBackToTimestamp) {
+    vector<PreprocessedRow> rows = {makeRow(100, "2021-01-01"), makeRow(110, "2021-01-02"), makeRow(99, "2021-01-03")};
+    LabeledEvent event = makeEvent(1, "2021-01-02", 110, 110);
+    event.entry_index = 2;
+    set<string> features = {"Close-to-close return for the previous day"};
+    auto result = FeatureExtractor::extractFeaturesForClassification(features, rows, {event});
+    ASSERT_EQ(result.features.size(), 1);
+    EXPECT_NEAR(result.features[0][FeatureCalculator::CLOSE_TO_CLOSE_RETURN_1D], 0.1, 0.01);
+}
+
+TEST(FeatureExtractorTest, EventLookup_UnmatchedEventKeepsLabelsAligned) {
+    vector<PreprocessedRow> rows = {makeRow(100, "2021-01-01"), makeRow(110, "2021-01-02"), makeRow(99, "2021-01-03")};
+    vector<LabeledEvent> events = {
+        makeEvent(-1, "2020-12-31", 100, 90),
+        makeEvent(1, "2021-01-02", 110, 121)
+    };
+    set<string> features = {"Close-to-close return for the previous day"};
+    auto result = FeatureExtractor::extractFeaturesForClassification(features, rows, events);
+    ASSERT_EQ(result.features.size(), 1);
+    ASSERT_EQ(result.labels.size(), 1);
+    EXPECT_EQ(result.labels[0], 1);
+    EXPECT_NEAR(result.returns[0], 0.1, 1e-9);
+}
+
+// ------------------ ROBUST SCALING ------------------
+TEST(FeatureExtractorTest, RobustScaling_MatchesSortedQuantiles) {
+    vector<map<string, double>> features;
+    vector<double> raw = {9, 1, 7, 3, 5, 2, 8, 4, 6, 10};
+    for (double v : raw) features.push_back({{"a", v}, {"b", 3.0}});
+    auto params = FeatureExtractor::fitRobustScaling(features);
+    ASSERT_EQ(params.feature_names, (vector<string>{"a", "b"}));
+    // sorted: 1..10, median (5+6)/2, q1 = v[2] = 3, q3 = v[7] = 8
+    EXPECT_DOUBLE_EQ(params.medians[0], 5.5);
+    EXPECT_DOUBLE_EQ(params.iqrs[0], 5.0);
+    // constant feature falls back to unit IQR
+    EXPECT_DOUBLE_EQ(params.medians[1], 3.0);
+    EXPECT_DOUBLE_EQ(params.iqrs[1], 1.0);
+}
+
+TEST(FeatureExtractorTest, RobustScaling_HandlesSparseRows) {
+    vector<map<string, double>> features = {
+        {{"a", 1.0}},
+        {{"a", 3.0}, {"c", 10.0}},
+        {{"b", 4.0}, {"c", 20.0}}
+    };
+    auto params = FeatureExtractor::applyRobustScaling(features);
+    ASSERT_EQ(params.feature_names, (vector<string>{"a", "b", "c"}));
+    EXPECT_DOUBLE_EQ(params.medians[0], 2.0);
+    EXPECT_DOUBLE_EQ(params.medians[1], 4.0);
+    EXPECT_DOUBLE_EQ(params.medians[2], 15.0);
+    EXPECT_DOUBLE_EQ(features[0]["a"], (1.0 - 2.0) / 2.0);
+    EXPECT_DOUBLE_EQ(features[2]["b"], 0.0);
+    EXPECT_DOUBLE_EQ(features[2]["c"], (20.0 - 15.0) / 10.0);
+}
+
+TEST(FeatureExtractorTest, RobustScaling_ReappliesFittedParams) {
+    vector<map<string, double>> train = {{{"a", 0.0}}, {{"a", 2.0}}, {{"a", 4.0}}, {{"a", 6.0}}};
+    auto params = FeatureExtractor::fitRobustScaling(train);
+    vector<map<string, double>> test = {{{"a", 3.0}, {"unseen", 7.0}}};
+    FeatureExtractor::applyRobustScaling(test, params);
+    EXPECT_DOUBLE_EQ(test[0]["a"], 0.0);
+    EXPECT_DOUBLE_EQ(test[0]["unseen"], 7.0);
+}
+
+TEST(FeatureExtractorTest, RobustScaling_LargeInputMatchesSequentialResult) {
+    vector<map<string, double>> features;
+    for (int i = 0; i < 20000; ++i) {
+        map<string, double> row;
+        for (int f = 0; f < 8; ++f) {
+            row["f" + to_string(f)] = static_cast<double>((i * (f + 7)) % 997);
+        }
+        features.push_back(row);
+    }
+    auto params = FeatureExtractor::fitRobustScaling(features);
+    for (size_t j = 0; j < params.feature_names.size(); ++j) {
+        vector<double> values;
+        for (const auto& row : features) values.push_back(row.at(params.feature_names[j]));
+        sort(values.begin(), values.end());
+        size_t n = values.size();
+        EXPECT_DOUBLE_EQ(params.medians[j], (values[n/2-1] + values[n/2]) / 2.0);
+        EXPECT_DOUBLE_EQ(params.iqrs[j], values[3*n/4] - values[n/4]);
+    }
+}
+
+// ------------------ EVENT TIMING ------------------
+namespace {
+    vector<string> dailyTimestamps(int n) {
+        vector<string> timestamps;
+        for (int i = 0; i < n; ++i) {
+            int day = i % 28 + 1;
+            int month = i / 28 + 1;
+            timestamps.push_back("2021-" + string(month < 10 ? "0" : "") + to_string(month) + "-" +
+                                 string(day < 10 ? "0" : "") + to_string(day));
+        }
+        return timestamps;
+    }
+}
+
+TEST(FeatureExtractorTest, EventTiming_BatchPassHandlesUnsortedAndDuplicateEvents) {
+    auto timestamps = dailyTimestamps(60);
+    vector<int> eventIndices = {30, 2, 5, 5, 55};
+    auto timing = FeatureCalculator::calculateEventTimingFeatures(timestamps, eventIndices);
+
+    // 2021-02-03 (row 30) back to 2021-01-06 (row 5)
+    EXPECT_DOUBLE_EQ(timing.days_since_last_event[0], 28.0);
+    EXPECT_DOUBLE_EQ(timing.days_since_last_event[1], 2.0);   // first event measures from series start
+    EXPECT_DOUBLE_EQ(timing.days_since_last_event[2], 3.0);
+    EXPECT_DOUBLE_EQ(timing.days_since_last_event[3], 3.0);   // same row: previous is the earlier row
+
+    EXPECT_EQ(timing.events_last_20_bars[0], 0.0);            // rows 2 and 5 are more than 20 bars back
+    EXPECT_EQ(timing.events_last_50_bars[0], 3.0);
+    EXPECT_EQ(timing.events_last_20_bars[2], 1.0);
+    EXPECT_EQ(timing.events_last_50_bars[4], 3.0);            // rows 5, 5 and 30 within [5, 55)
+    EXPECT_EQ(timing.events_last_20_bars[1], 0.0);
+}
+
+TEST(FeatureExtractorTest, EventTiming_PerEventPathMatchesBatchPass) {
+    auto timestamps = dailyTimestamps(80);
+    vector<int> eventIndices = {3, 7, 8, 15, 40, 41, 41, 60, 79};
+    auto timing = FeatureCalculator::calculateEventTimingFeatures(timestamps, eventIndices);
+    set<string> selected = {FeatureCalculator::DAYS_SINCE_LAST_EVENT,
+                            FeatureCalculator::EVENTS_LAST_20_BARS,
+                            FeatureCalculator::EVENTS_LAST_50_BARS};
+    vector<double> prices(timestamps.size(), 100.0);
+    for (size_t i = 0; i < eventIndices.size(); ++i) {
+        auto features = FeatureCalculator::calculateFeatures(prices, timestamps, eventIndices, int(i), selected);
+        EXPECT_DOUBLE_EQ(features[FeatureCalculator::DAYS_SINCE_LAST_EVENT], timing.days_since_last_event[i]);
+        EXPECT_EQ(features[FeatureCalculator::EVENTS_LAST_20_BARS], timing.events_last_20_bars[i]);
+        EXPECT_EQ(features[FeatureCalculator::EVENTS_LAST_50_BARS], timing.events_last_50_bars[i]);
+    }
+
+    // Out of order: each call sorts internally unless handed the rows sorted once.
+    vector<int> shuffled = {41, 3, 79, 8, 40, 15, 60, 7, 41};
+    vector<int> sortedRows = shuffled;
+    sort(sortedRows.begin(), sortedRows.end());
+    auto shuffledTiming = FeatureCalculator::calculateEventTimingFeatures(timestamps, shuffled);
+    for (size_t i = 0; i < shuffled.size(); ++i) {
+        auto internal = FeatureCalculator::calculateFeatures(prices, timestamps, shuffled, int(i), selected);
+        auto presorted = FeatureCalculator::calculateFeatures(prices, timestamps, shuffled, int(i), selected, &sortedRows);
+        for (const auto& feat : {FeatureCalculator::EVENTS_LAST_20_BARS, FeatureCalculator::EVENTS_LAST_50_BARS}) {
+            EXPECT_EQ(internal[feat], presorted[feat]);
+        }
+        EXPECT_EQ(presorted[FeatureCalculator::EVENTS_LAST_20_BARS], shuffledTiming.events_last_20_bars[i]);
+        EXPECT_EQ(presorted[FeatureCalculator::EVENTS_LAST_50_BARS], shuffledTiming.events_last_50_bars[i]);
+    }
+}
+
+TEST(FeatureExtractorTest, EventTiming_DaysSinceLastEventIsExtracted) {
+    vector<PreprocessedRow> rows;
+    for (const auto& ts : dailyTimestamps(10)) rows.push_back(makeRow(100, ts));
+    vector<LabeledEvent> events = {
+        makeEvent(1, "2021-01-03", 100, 101),
+        makeEvent(-1, "2021-01-07", 100, 99)
+    };
+    set<string> features = {"Days since last event", "Events in the last 20 bars"};
+    auto result = FeatureExtractor::extractFeaturesForClassification(features, rows, events);
+    ASSERT_EQ(result.features.size(), 2);
+    EXPECT_DOUBLE_EQ(result.features[0][FeatureCalculator::DAYS_SINCE_LAST_EVENT], 2.0);
+    EXPECT_DOUBLE_EQ(result.features[1][FeatureCalculator::DAYS_SINCE_LAST_EVENT], 4.0);
+    EXPECT_DOUBLE_EQ(result.features[1][FeatureCalculator::EVENTS_LAST_20_BARS], 1.0);
+}
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include "../data/FeatureStore.h"
+#include "../data/FeatureExtractor.h"
+#include "../data/PreprocessedRow.h"
+#include "../data/LabeledEvent.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+    class FeatureStoreTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            dir = (filesystem::temp_directory_path() /
+                   ("tbfs_test_" + string(::testing::UnitTest::GetInstance()->current_test_info()->name()))).string();
+            filesystem::remove_all(dir);
+        }
+        void TearDown() override { filesystem::remove_all(dir); }
+
+        string dir;
+    };
+
+    vector<PreprocessedRow> makeRows(int n) {
+        vector<PreprocessedRow> rows;
+        for (int i = 0; i < n; ++i) {
+            PreprocessedRow row;
+            row.timestamp = "2021-01-" + string(i + 1 < 10 ? "0" : "") + to_string(i + 1);
+            row.price = 100.0 + i * (i % 3 == 0 ? 1.5 : -0.5);
+            row.volume = 1000.0 + i;
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    vector<LabeledEvent> makeEvents(const vector<PreprocessedRow>& rows) {
+        vector<LabeledEvent> events;
+        for (size_t i = 5; i + 2 < rows.size(); i += 4) {
+            LabeledEvent e;
+            e.entry_time = rows[i].timestamp;
+            e.exit_time = rows[i + 2].timestamp;
+            e.entry_price = rows[i].price;
+            e.exit_price = rows[i + 2].price;
+            e.label = e.exit_price > e.entry_price ? 1 : -1;
+            e.ttbm_label = 0.25 * e.label;
+            e.entry_index = static_cast<int>(i);
+            e.exit_index = static_cast<int>(i + 2);
+            events.push_back(e);
+        }
+        return events;
+    }
+}
+
+TEST_F(FeatureStoreTest, KeyDependsOnSeriesEventsAndSpec) {
+    auto rows = makeRows(20);
+    auto events = makeEvents(rows);
+    set<string> spec = {"sma_5d", "rsi_14d"};
+    using Mode = FeatureStore::Mode;
+
+    uint64_t key = FeatureStore::computeKey(Mode::CLASSIFICATION, spec, rows, events);
+    EXPECT_EQ(key, FeatureStore::computeKey(Mode::CLASSIFICATION, spec, rows, events));
+    EXPECT_NE(key, FeatureStore::computeKey(Mode::REGRESSION, spec, rows, events));
+    EXPECT_NE(key, FeatureStore::computeKey(Mode::CLASSIFICATION, {"sma_10d", "rsi_14d"}, rows, events));
+
+    auto changedRows = rows;
+    changedRows[3].price += 1e-9;
+    EXPECT_NE(key, FeatureStore::computeKey(Mode::CLASSIFICATION, spec, changedRows, events));
+
+    auto changedEvents = events;
+    changedEvents.pop_back();
+    EXPECT_NE(key, FeatureStore::computeKey(Mode::CLASSIFICATION, spec, rows, changedEvents));
+}
+
+TEST_F(FeatureStoreTest, ClassificationRoundTrip) {
+    auto rows = makeRows(30);
+    auto events = makeEvents(rows);
+    set<string> selected = {"5-day simple moving average (SMA)", "Relative Strength Index (RSI) over 14 days", "Day of the week"};
+    auto expected = FeatureExtractor::extractFeaturesForClassification(selected, rows, events);
+    ASSERT_FALSE(expected.features.empty());
+
+    FeatureStore store(dir);
+    uint64_t key = FeatureStore::computeKey(FeatureStore::Mode::CLASSIFICATION,
+        FeatureExtractor::resolveBackendFeatures(selected), rows, events);
+    EXPECT_FALSE(store.contains(key));
+    FeatureExtractor::FeatureExtractionResult loaded;
+    EXPECT_FALSE(store.load(key, loaded));
+
+    ASSERT_TRUE(store.save(key, FeatureStore::Mode::CLASSIFICATION, expected));
+    EXPECT_TRUE(store.contains(key));
+    ASSERT_TRUE(store.load(key, loaded));
+
+    ASSERT_EQ(loaded.features.size(), expected.features.size());
+    for (size_t i = 0; i < expected.features.size(); ++i) {
+        ASSERT_EQ(loaded.features[i].size(), expected.features[i].size());
+        for (const auto& kv : expected.features[i]) {
+            double actual = loaded.features[i].at(kv.first);
+            if (std::isnan(kv.second)) EXPECT_TRUE(std::isnan(actual));
+            else EXPECT_DOUBLE_EQ(actual, kv.second);
+        }
+    }
+    EXPECT_EQ(loaded.labels, expected.labels);
+    EXPECT_TRUE(loaded.labels_double.empty());
+    EXPECT_EQ(loaded.returns, expected.returns);
+    ASSERT_EQ(expected.entry_indices.size(), expected.features.size());
+    EXPECT_EQ(expected.entry_indices.front(), events.front().entry_index);
+    EXPECT_EQ(expected.exit_indices.front(), events.front().exit_index);
+    EXPECT_EQ(loaded.entry_indices, expected.entry_indices);
+    EXPECT_EQ(loaded.exit_indices, expected.exit_indices);
+}
+
+TEST_F(FeatureStoreTest, SparseRegressionRoundTripKeepsScaling) {
+    FeatureExtractor::FeatureExtractionResult expected;
+    expected.features = {{{"a", 1.0}, {"b", 2.0}}, {{"a", 3.0}}, {{"b", -4.0}}};
+    expected.labels_double = {0.1, -0.2, 0.3};
+    expected.returns = {0.01, -0.02, 0.03};
+    expected.scaling = FeatureExtractor::fitRobustScaling(expected.features);
+
+    FeatureStore store(dir);
+    ASSERT_TRUE(store.save(7, FeatureStore::Mode::REGRESSION, expected));
+
+    auto entry = FeatureStore::MappedEntry::open(store.pathForKey(7), 7);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->rows(), 3u);
+    ASSERT_EQ(entry->featureNames(), (vector<string>{"a", "b"}));
+    EXPECT_EQ(entry->mode(), FeatureStore::Mode::REGRESSION);
+    EXPECT_DOUBLE_EQ(entry->column(0)[1], 3.0);
+    EXPECT_FALSE(entry->present(0, 2));
+    EXPECT_TRUE(entry->present(1, 2));
+
+    FeatureExtractor::FeatureExtractionResult loaded = entry->toResult();
+    EXPECT_EQ(loaded.features, expected.features);
+    EXPECT_TRUE(loaded.labels.empty());
+    EXPECT_EQ(loaded.labels_double, expected.labels_double);
+    EXPECT_EQ(loaded.scaling.feature_names, expected.scaling.feature_names);
+    EXPECT_EQ(loaded.scaling.medians, expected.scaling.medians);
+    EXPECT_EQ(loaded.scaling.iqrs, expected.scaling.iqrs);
+}
+
+TEST_F(FeatureStoreTest, RejectsWrongKeyAndTruncatedFile) {
+    FeatureExtractor::FeatureExtractionResult expected;
+    expected.features = {{{"a", 1.0}}, {{"a", 2.0}}};
+    expected.labels = {1, -1};
+    expected.returns = {0.1, -0.1};
+
+    FeatureStore store(dir);
+    ASSERT_TRUE(store.save(42, FeatureStore::Mode::CLASSIFICATION, expected));
+    EXPECT_EQ(FeatureStore::MappedEntry::open(store.pathForKey(42), 43), nullptr);
+
+    auto size = filesystem::file_size(store.pathForKey(42));
+    filesystem::resize_file(store.pathForKey(42), size - 8);
+    FeatureExtractor::FeatureExtractionResult loaded;
+    EXPECT_FALSE(store.load(42, loaded));
+}
+
+TEST_F(FeatureStoreTest, EvictsLeastRecentlyUsedEntriesPastTheSizeCap) {
+    FeatureExtractor::FeatureExtractionResult entry;
+    for (int i = 0; i < 200; ++i) {
+        entry.features.push_back({{"a", 1.0 * i}, {"b", -1.0 * i}});
+        entry.labels.push_back(i % 2 ? 1 : -1);
+        entry.returns.push_back(0.001 * i);
+    }
+
+    FeatureStore unbounded(dir, 0);
+    ASSERT_TRUE(unbounded.save(1, FeatureStore::Mode::CLASSIFICATION, entry));
+    const uint64_t entryBytes = unbounded.sizeOnDisk();
+    filesystem::remove_all(dir);
+
+    // Room for two entries.
+    FeatureStore store(dir, 2 * entryBytes + entryBytes / 2);
+    auto age = [&](uint64_t key, int secondsAgo) {
+        filesystem::last_write_time(store.pathForKey(key),
+                                    filesystem::file_time_type::clock::now() - chrono::seconds(secondsAgo));
+    };
+    ASSERT_TRUE(store.save(1, FeatureStore::Mode::CLASSIFICATION, entry));
+    age(1, 30);
+    ASSERT_TRUE(store.save(2, FeatureStore::Mode::CLASSIFICATION, entry));
+    age(2, 20);
+
+    // Using entry 1 makes entry 2 the least recently used.
+    ASSERT_NE(store.open(1), nullptr);
+    ASSERT_TRUE(store.save(3, FeatureStore::Mode::CLASSIFICATION, entry));
+    EXPECT_TRUE(store.contains(1));
+    EXPECT_FALSE(store.contains(2));
+    EXPECT_TRUE(store.contains(3));
+    EXPECT_LE(store.sizeOnDisk(), store.maxBytes());
+
+    // An entry larger than the cap is still kept until something newer replaces it.
+    FeatureStore tiny(dir, 1);
+    ASSERT_TRUE(tiny.save(4, FeatureStore::Mode::CLASSIFICATION, entry));
+    EXPECT_TRUE(tiny.contains(4));
+    EXPECT_FALSE(tiny.contains(1));
+    EXPECT_FALSE(tiny.contains(3));
+}
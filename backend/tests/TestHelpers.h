@@ -0,0 +1,73 @@
+#pragma once
+#include "../ml/DenseMatrix.h"
+#include "../ml/MLSplits.h"
+#include "../ml/XGBoostModel.h"
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+// Fixtures shared by the test executables.
+namespace TestHelpers {
+
+// Row-major Gaussian features whose labels follow the first two columns: 0/1, or the
+// barrier labels -1/0/1 when three_classes is set.
+struct SyntheticData {
+    std::vector<float> X;
+    std::vector<float> y;
+    size_t rows = 0;
+    size_t cols = 0;
+
+    MLPipeline::DenseMatrixView view() const { return MLPipeline::DenseMatrixView(X.data(), rows, cols); }
+};
+
+// One event every 2 bars, each resolved `holding` bars after entry.
+inline std::vector<MLSplitUtils::EventWindow> evenlySpacedWindows(size_t n, size_t holding) {
+    std::vector<MLSplitUtils::EventWindow> windows(n);
+    for (size_t i = 0; i < n; ++i) {
+        windows[i].start = 2 * i;
+        windows[i].end = 2 * i + holding;
+    }
+    return windows;
+}
+
+// Mostly positive per-sample returns with a repeating pattern of losses.
+inline std::vector<double> alternatingReturns(size_t n) {
+    std::vector<double> returns(n);
+    for (size_t i = 0; i < n; ++i) returns[i] = (i % 3 == 0 ? -0.01 : 0.02) * (1.0 + 0.1 * (i % 5));
+    return returns;
+}
+
+inline SyntheticData makeSyntheticData(size_t rows, size_t cols, bool three_classes, unsigned seed = 7) {
+    SyntheticData data;
+    data.rows = rows;
+    data.cols = cols;
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    data.X.resize(rows * cols);
+    data.y.resize(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) data.X[i * cols + j] = noise(rng);
+        float signal = data.X[i * cols] + 0.5f * data.X[i * cols + 1] + 0.5f * noise(rng);
+        if (three_classes) {
+            data.y[i] = signal > 0.5f ? 1.0f : (signal < -0.5f ? -1.0f : 0.0f);
+        } else {
+            data.y[i] = signal > 0.0f ? 1.0f : 0.0f;
+        }
+    }
+    return data;
+}
+
+// Single-threaded, unsampled boosting so two fits on the same rows grow the same trees.
+inline MLPipeline::XGBoostConfig deterministicConfig(const std::string& objective, int n_rounds) {
+    MLPipeline::XGBoostConfig config;
+    config.objective = objective;
+    config.n_rounds = n_rounds;
+    config.max_depth = 4;
+    config.nthread = 1;
+    config.subsample = 1.0;
+    config.colsample_bytree = 1.0;
+    return config;
+}
+
+}
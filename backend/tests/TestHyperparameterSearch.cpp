@@ -0,0 +1,291 @@
+#include <gtest/gtest.h>
+#include "../ml/HyperparameterSearch.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+
+namespace {
+    HyperparameterGrid smallGrid() {
+        HyperparameterGrid grid;
+        grid.n_rounds = {10, 20};
+        grid.max_depth = {2, 4, 6};
+        grid.learning_rate = {0.1};
+        grid.subsample = {1.0};
+        grid.colsample_bytree = {0.5, 1.0};
+        return grid;
+    }
+}
+
+TEST(HyperparameterSearchTest, ExpandGridFollowsNestedLoopOrder) {
+    auto combos = expandGrid(smallGrid());
+    ASSERT_EQ(combos.size(), 12u);
+    EXPECT_EQ(combos[0].n_rounds, 10);
+    EXPECT_EQ(combos[0].max_depth, 2);
+    EXPECT_DOUBLE_EQ(combos[0].colsample_bytree, 0.5);
+    EXPECT_DOUBLE_EQ(combos[1].colsample_bytree, 1.0);
+    EXPECT_EQ(combos[2].max_depth, 4);
+    EXPECT_EQ(combos[6].n_rounds, 20);
+}
+
+TEST(HyperparameterSearchTest, CoreBudgetSplitsCoresBetweenJobs) {
+    CoreBudget derived = planCoreBudget(108, 0, 8, 32);
+    EXPECT_EQ(derived.jobs, 4);
+    EXPECT_EQ(derived.threads_per_job, 8);
+
+    CoreBudget requested = planCoreBudget(108, 3, 8, 32);
+    EXPECT_EQ(requested.jobs, 3);
+    EXPECT_EQ(requested.threads_per_job, 10);
+
+    CoreBudget capped = planCoreBudget(2, 0, 1, 16);
+    EXPECT_EQ(capped.jobs, 2);
+    EXPECT_EQ(capped.threads_per_job, 8);
+
+    CoreBudget tiny = planCoreBudget(10, 0, 8, 2);
+    EXPECT_EQ(tiny.jobs, 1);
+    EXPECT_EQ(tiny.threads_per_job, 2);
+
+    CoreBudget oversubscribed = planCoreBudget(108, 12, 8, 4);
+    EXPECT_EQ(oversubscribed.jobs, 4);
+    EXPECT_EQ(oversubscribed.threads_per_job, 1);
+}
+
+TEST(HyperparameterSearchTest, ParallelSearchPicksSameWinnerAsSerialScan) {
+    auto combos = expandGrid(smallGrid());
+    auto score = [](size_t, const HyperparameterCombination& c, int) {
+        return c.max_depth == 4 ? 0.8 : 0.1 * c.max_depth + 0.01 * c.colsample_bytree;
+    };
+    auto never = [](double) { return false; };
+
+    GridSearchResult serial = runGridSearch(combos, {1, 1}, score, never);
+    GridSearchResult parallel = runGridSearch(combos, {4, 2}, score, never);
+    ASSERT_TRUE(serial.has_best);
+    EXPECT_EQ(parallel.best_index, serial.best_index);
+    EXPECT_EQ(serial.best_index, 2u);  // first of the tied 0.8 scores
+    EXPECT_EQ(parallel.evaluated, combos.size());
+    EXPECT_FALSE(parallel.early_stopped);
+}
+
+TEST(HyperparameterSearchTest, EvaluatorReceivesTheIndexOfEachCombination) {
+    auto combos = expandGrid(smallGrid());
+    vector<int> depth_at(combos.size(), 0);
+    vector<atomic<int>> calls(combos.size());
+    auto score = [&](size_t index, const HyperparameterCombination& c, int) {
+        depth_at[index] = c.max_depth;
+        ++calls[index];
+        return 0.0;
+    };
+    runGridSearch(combos, {3, 1}, score, [](double) { return false; });
+    for (size_t i = 0; i < combos.size(); ++i) {
+        EXPECT_EQ(calls[i].load(), 1) << i;
+        EXPECT_EQ(depth_at[i], combos[i].max_depth) << i;
+    }
+}
+
+TEST(HyperparameterSearchTest, EarlyStopIgnoresCombinationsAfterTheStoppingOne) {
+    auto combos = expandGrid(smallGrid());
+    auto score = [](size_t, const HyperparameterCombination& c, int) {
+        this_thread::sleep_for(chrono::milliseconds(2));
+        if (c.n_rounds == 10 && c.max_depth == 4 && c.colsample_bytree == 0.5) return 0.97;
+        if (c.n_rounds == 20) return 0.99;  // better, but after the stopping combination
+        return 0.5;
+    };
+    auto stop = [](double s) { return s > 0.95; };
+
+    GridSearchResult result = runGridSearch(combos, {3, 1}, score, stop);
+    EXPECT_TRUE(result.early_stopped);
+    EXPECT_EQ(result.best_index, 2u);
+    EXPECT_DOUBLE_EQ(result.best_score, 0.97);
+    EXPECT_LT(result.evaluated, combos.size());
+}
+
+TEST(HyperparameterSearchTest, EarlyStopIndexOnlySkipsIndicesAfterTheFirstStop) {
+    EarlyStopIndex stop(10);
+    EXPECT_FALSE(stop.skips(9));
+
+    // Index 4 was claimed before index 5 stopped the search; it must still run.
+    stop.record(5);
+    EXPECT_FALSE(stop.skips(4));
+    EXPECT_FALSE(stop.skips(5));
+    EXPECT_TRUE(stop.skips(6));
+
+    // A later stop never raises the bound; an earlier one lowers it.
+    stop.record(8);
+    EXPECT_EQ(stop.index(), 5u);
+    stop.record(2);
+    EXPECT_EQ(stop.index(), 2u);
+    EXPECT_TRUE(stop.skips(4));
+}
+
+TEST(HyperparameterSearchTest, CombinationClaimedBeforeALaterStopStillCounts) {
+    auto combos = expandGrid(smallGrid());
+    // Combination 0 does not finish until combination 1 has stopped the search.
+    mutex m;
+    condition_variable stopped;
+    bool second_done = false;
+    auto score = [&](size_t index, const HyperparameterCombination&, int) {
+        if (index == 0) {
+            unique_lock<mutex> lock(m);
+            stopped.wait_for(lock, chrono::seconds(10), [&] { return second_done; });
+            return 0.99;
+        }
+        if (index == 1) {
+            lock_guard<mutex> lock(m);
+            second_done = true;
+            stopped.notify_all();
+            return 0.97;
+        }
+        return 0.5;
+    };
+
+    GridSearchResult result = runGridSearch(combos, {2, 1}, score, [](double s) { return s > 0.95; });
+    EXPECT_TRUE(result.early_stopped);
+    EXPECT_DOUBLE_EQ(result.scores[0], 0.99);
+    EXPECT_EQ(result.best_index, 0u);
+    EXPECT_LT(result.evaluated, combos.size());
+}
+
+TEST(HyperparameterSearchTest, FailedCombinationsAreSkippedAndProgressIsReported) {
+    auto combos = expandGrid(smallGrid());
+    atomic<int> nthreadSeen{0};
+    auto score = [&](size_t, const HyperparameterCombination& c, int nthread) -> double {
+        nthreadSeen = nthread;
+        if (c.max_depth == 6) throw runtime_error("boom");
+        return c.max_depth;
+    };
+    vector<size_t> completed;
+    size_t total = 0;
+    double lastBest = 0.0;
+    auto progress = [&](const TuningProgress& p) {
+        completed.push_back(p.completed);
+        total = p.total;
+        lastBest = p.best_score;
+    };
+
+    GridSearchResult result = runGridSearch(combos, {2, 3}, score, [](double) { return false; }, progress);
+    EXPECT_EQ(nthreadSeen.load(), 3);
+    ASSERT_EQ(completed.size(), combos.size());
+    for (size_t i = 0; i < completed.size(); ++i) EXPECT_EQ(completed[i], i + 1);
+    EXPECT_EQ(total, combos.size());
+    EXPECT_DOUBLE_EQ(lastBest, 4.0);
+    EXPECT_TRUE(std::isnan(result.scores[4]));
+    EXPECT_EQ(result.best_index, 2u);
+}
+
+// ------------------ SUCCESSIVE HALVING ------------------
+TEST(HyperparameterSearchTest, HalvingRungsGrowByEtaUpToMaxRounds) {
+    SuccessiveHalvingConfig config;
+    config.min_rounds = 10;
+    config.eta = 3;
+    EXPECT_EQ(successiveHalvingRungs(config, 200), (vector<int>{10, 30, 90, 200}));
+    EXPECT_EQ(successiveHalvingRungs(config, 90), (vector<int>{10, 30, 90}));
+    EXPECT_EQ(successiveHalvingRungs(config, 5), (vector<int>{5}));
+    config.eta = 1;
+    EXPECT_THROW(successiveHalvingRungs(config, 100), std::invalid_argument);
+}
+
+TEST(HyperparameterSearchTest, GridWithoutRoundsUsesLargestRoundBudget) {
+    auto combos = expandGridWithoutRounds(smallGrid());
+    ASSERT_EQ(combos.size(), 6u);
+    for (const auto& c : combos) EXPECT_EQ(c.n_rounds, 20);
+
+    HyperparameterGrid noRounds = smallGrid();
+    noRounds.n_rounds.clear();
+    EXPECT_THROW(expandGridWithoutRounds(noRounds), std::invalid_argument);
+    noRounds.n_rounds = {0};
+    EXPECT_THROW(expandGridWithoutRounds(noRounds), std::invalid_argument);
+}
+
+TEST(HyperparameterSearchTest, HalvingPromotesTopTrialsAndContinuesTraining) {
+    HyperparameterGrid grid;
+    grid.n_rounds = {90};
+    grid.max_depth = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    grid.learning_rate = {0.1};
+    grid.subsample = {1.0};
+    grid.colsample_bytree = {1.0};
+    auto combos = expandGridWithoutRounds(grid);
+
+    // Deeper trees start slower but end higher: only trials that keep training can win.
+    atomic<int> created{0};
+    vector<vector<int>> calls(combos.size());
+    mutex callsMutex;
+    auto make_trial = [&](const HyperparameterCombination& c, int) -> IncrementalTrial {
+        created++;
+        size_t id = static_cast<size_t>(c.max_depth - 1);
+        return [&, id, depth = c.max_depth](int rounds) {
+            { lock_guard<mutex> lock(callsMutex); calls[id].push_back(rounds); }
+            return rounds < 30 ? 10.0 - depth : depth * rounds / 90.0;
+        };
+    };
+
+    SuccessiveHalvingConfig config;
+    config.min_rounds = 10;
+    config.eta = 3;
+    vector<size_t> completed;
+    auto progress = [&](const TuningProgress& p) { completed.push_back(p.total); };
+    SuccessiveHalvingResult result = runSuccessiveHalving(combos, {3, 1}, config, 90, make_trial,
+                                                          [](double) { return false; }, progress);
+
+    EXPECT_EQ(created.load(), 9);
+    EXPECT_EQ(result.rungs, (vector<int>{10, 30, 90}));
+    // rung 1 keeps depths 1-3 (best early scores); rung 2 keeps the best of those.
+    EXPECT_EQ(calls[0], (vector<int>{10, 30}));
+    EXPECT_EQ(calls[2], (vector<int>{10, 30, 90}));
+    EXPECT_EQ(calls[8], (vector<int>{10}));
+    ASSERT_TRUE(result.has_best);
+    EXPECT_EQ(result.best_index, 2u);
+    EXPECT_EQ(result.best_rounds, 90);
+    EXPECT_EQ(result.total_rounds, 9 * 10 + 3 * 20 + 1 * 60);
+    EXPECT_EQ(completed.size(), 13u);
+    EXPECT_EQ(completed.back(), 13u);
+}
+
+TEST(HyperparameterSearchTest, HalvingStopsAfterRungThatMeetsThreshold) {
+    auto combos = expandGridWithoutRounds(smallGrid());
+    auto make_trial = [](const HyperparameterCombination& c, int) -> IncrementalTrial {
+        return [depth = c.max_depth](int rounds) { return depth != 6 ? 0.5 : (rounds >= 6 ? 0.99 : 0.9); };
+    };
+    SuccessiveHalvingConfig config;
+    config.min_rounds = 2;
+    config.eta = 3;
+    SuccessiveHalvingResult result = runSuccessiveHalving(combos, {2, 1}, config, 20, make_trial,
+                                                          [](double s) { return s > 0.95; });
+    EXPECT_TRUE(result.early_stopped);
+    EXPECT_EQ(combos[result.best_index].max_depth, 6);
+    EXPECT_EQ(result.best_rounds, 6);
+}
+
+TEST(HyperparameterSearchTest, HalvingDoesNotChargeRoundsForFailedTrials) {
+    auto combos = expandGridWithoutRounds(smallGrid());
+    auto make_trial = [](const HyperparameterCombination& c, int) -> IncrementalTrial {
+        if (c.max_depth == 2) throw std::runtime_error("cannot build trial");
+        return [depth = c.max_depth](int rounds) {
+            if (depth == 4 && rounds > 2) throw std::runtime_error("diverged");
+            return 0.1 * depth;
+        };
+    };
+    SuccessiveHalvingConfig config;
+    config.min_rounds = 2;
+    config.eta = 2;
+
+    testing::internal::CaptureStderr();
+    SuccessiveHalvingResult result = runSuccessiveHalving(combos, {1, 1}, config, 8, make_trial,
+                                                          [](double) { return false; });
+    testing::internal::GetCapturedStderr();
+
+    // Rungs 2, 4, 8. The depth 2 trials never build, and the promoted depth 4 trial fails
+    // on rung 2; only the four trials that trained on rung 1 and the two depth 6 trials
+    // that continue are charged.
+    EXPECT_EQ(result.rungs, (vector<int>{2, 4, 8}));
+    ASSERT_TRUE(result.has_best);
+    EXPECT_EQ(combos[result.best_index].max_depth, 6);
+    EXPECT_EQ(result.best_rounds, 8);
+    EXPECT_EQ(result.total_rounds, 4 * 2 + 2 * 2 + 2 * 4);
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "../ml/ModelUtils.h"
+#include "../ml/XGBoostModel.h"
+#include "../ml/XGBoostModelDetail.h"
+#include "../ml/TrainingDataset.h"
+#include "../ml/MLSplits.h"
+#include "../ml/BarrierMLStrategy.h"
+#include "../utils/Exceptions.h"
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+
+TEST(ModelUtilsTest, FlatMatrixMatchesNestedConversion) {
+    vector<map<string, double>> X = {
+        {{"b", 2.0}, {"a", 1.0}},
+        {{"a", 3.0}, {"c", 5.0}},
+        {{"b", -1.0}, {"c", 0.5}}
+    };
+    auto nested = toFloatMatrix(X);
+    auto flat = toFlatFloatMatrix(X);
+    ASSERT_EQ(flat.rows, 3u);
+    ASSERT_EQ(flat.cols, 3u);
+    EXPECT_EQ(flat.feature_names, (vector<string>{"a", "b", "c"}));
+    for (size_t i = 0; i < flat.rows; ++i) {
+        for (size_t j = 0; j < flat.cols; ++j) {
+            EXPECT_FLOAT_EQ(flat.view().at(i, j), nested[i][j]);
+        }
+    }
+}
+
+TEST(ModelUtilsTest, FlatMatrixRowSubsetKeepsFullColumnLayout) {
+    vector<map<string, double>> X = {
+        {{"a", 1.0}},
+        {{"a", 2.0}, {"b", 7.0}},
+        {{"a", 3.0}}
+    };
+    auto subset = toFlatFloatMatrix(X, vector<size_t>{2, 0});
+    ASSERT_EQ(subset.rows, 2u);
+    ASSERT_EQ(subset.cols, 2u);
+    EXPECT_FLOAT_EQ(subset.view().at(0, 0), 3.0f);
+    EXPECT_FLOAT_EQ(subset.view().at(0, 1), 0.0f);
+    EXPECT_FLOAT_EQ(subset.view().at(1, 0), 1.0f);
+}
+
+TEST(ModelUtilsTest, FlatMatrixValidationRejectsNaN) {
+    vector<map<string, double>> X = {{{"a", NAN}}};
+    EXPECT_THROW(ModelUtils::toFlatFloatMatrix(X, nullptr, true), std::invalid_argument);
+}
+
+TEST(ModelUtilsTest, DenseViewAddressesStridedRows) {
+    vector<float> buffer = {1, 2, 99, 3, 4, 99, 5, 6, 99};
+    DenseMatrixView view(buffer.data(), 3, 2, 3);
+    EXPECT_FALSE(view.contiguous());
+    EXPECT_FLOAT_EQ(view.at(1, 1), 4.0f);
+    auto tail = view.rowRange(1, 3);
+    EXPECT_EQ(tail.rows, 2u);
+    EXPECT_FLOAT_EQ(tail.row(1)[0], 5.0f);
+}
+
+TEST(ModelUtilsTest, DenseFitValidatesBeforeBuildingDMatrix) {
+    XGBoostModel model;
+    XGBoostConfig config;
+    vector<float> buffer = {1, NAN, 3, 4};
+    DenseMatrixView view(buffer.data(), 2, 2);
+    EXPECT_THROW(model.fit(view, {0.0f, 1.0f}, config), TripleBarrier::DataValidationException);
+    EXPECT_THROW(model.fit(view, {0.0f}, config), TripleBarrier::DataValidationException);
+    EXPECT_FALSE(model.is_trained());
+}
+
+TEST(ModelUtilsTest, TrainingDatasetRejectsBadDataBeforeBuildingDMatrix) {
+    vector<float> buffer = {1, 2, 3, INFINITY};
+    DenseMatrixView view(buffer.data(), 2, 2);
+    EXPECT_THROW(TrainingDataset(view, {0.0f, 1.0f}, "binary:logistic"), TripleBarrier::DataValidationException);
+
+    vector<float> clean = {1, 2, 3, 4};
+    DenseMatrixView clean_view(clean.data(), 2, 2);
+    EXPECT_THROW(TrainingDataset(clean_view, {0.0f}, "binary:logistic"), TripleBarrier::DataValidationException);
+    EXPECT_THROW(TrainingDataset(clean_view, {0.0f, NAN}, "binary:logistic"), TripleBarrier::DataValidationException);
+}
+
+TEST(ModelUtilsTest, BlockDatasetValidatesEveryBlockBeforeBuildingDMatrix) {
+    vector<float> buffer(20, 1.0f);
+    buffer[7 * 2 + 1] = NAN;
+    DenseMatrixView view(buffer.data(), 10, 2);
+    TrainingDataset::Options options;
+    options.use_quantile = true;
+
+    MLSplitUtils::RowRangeView rows(view, {{0, 3}, {6, 9}});
+    try {
+        TrainingDataset(rows, vector<float>(6, 0.0f), "binary:logistic", options);
+        FAIL() << "NaN in the second block was accepted";
+    } catch (const TripleBarrier::DataValidationException& e) {
+        EXPECT_NE(e.full_message().find("row 4, col 1"), string::npos) << e.full_message();
+    }
+    EXPECT_THROW(TrainingDataset(MLSplitUtils::RowRangeView(view, {{0, 3}}), {0.0f, 1.0f}, "binary:logistic", options),
+                 TripleBarrier::DataValidationException);
+    EXPECT_THROW(TrainingDataset(MLSplitUtils::RowRangeView(view, {}), {}, "binary:logistic", options),
+                 TripleBarrier::DataValidationException);
+}
+
+TEST(ModelUtilsTest, ParsesLastMetricOfEvalResult) {
+    string metric;
+    double value = 0.0;
+    ASSERT_TRUE(detail::parseEvalResult("[3]\teval-logloss:0.51234", metric, value));
+    EXPECT_EQ(metric, "logloss");
+    EXPECT_DOUBLE_EQ(value, 0.51234);
+
+    ASSERT_TRUE(detail::parseEvalResult("[12]\teval-logloss:0.4\teval-auc:0.875", metric, value));
+    EXPECT_EQ(metric, "auc");
+    EXPECT_DOUBLE_EQ(value, 0.875);
+
+    ASSERT_TRUE(detail::parseEvalResult("[0]\teval-ndcg@5:0.7", metric, value));
+    EXPECT_EQ(metric, "ndcg@5");
+
+    EXPECT_FALSE(detail::parseEvalResult("[0]", metric, value));
+    EXPECT_FALSE(detail::parseEvalResult("[0]\teval-rmse:", metric, value));
+}
+
+TEST(ModelUtilsTest, MetricDirectionForEarlyStopping) {
+    EXPECT_TRUE(detail::metricIsMaximized("auc"));
+    EXPECT_TRUE(detail::metricIsMaximized("aucpr"));
+    EXPECT_TRUE(detail::metricIsMaximized("ndcg@10"));
+    EXPECT_FALSE(detail::metricIsMaximized("logloss"));
+    EXPECT_FALSE(detail::metricIsMaximized("mlogloss"));
+    EXPECT_FALSE(detail::metricIsMaximized("rmse"));
+    EXPECT_FALSE(detail::metricIsMaximized("error"));
+}
+
+TEST(ModelUtilsTest, RejectsNegativeEarlyStoppingRounds) {
+    vector<float> buffer = {1, 2, 3, 4};
+    DenseMatrixView view(buffer.data(), 2, 2);
+    XGBoostConfig config;
+    config.early_stopping_rounds = -1;
+    XGBoostModel model;
+    EXPECT_THROW(model.fit(view, {0.0f, 1.0f}, config), TripleBarrier::HyperparameterException);
+    EXPECT_EQ(model.best_iteration(), -1);
+}
+
+TEST(ModelUtilsTest, PersistenceRequiresATrainedModel) {
+    XGBoostModel model;
+    EXPECT_THROW(model.save_to_buffer(), std::runtime_error);
+    EXPECT_THROW(model.load("/nonexistent/dir/model.ubj"), TripleBarrier::DataLoadException);
+    EXPECT_FALSE(model.is_trained());
+
+    vector<float> buffer = {1, 2, 3, 4};
+    EXPECT_THROW(model.continue_training(DenseMatrixView(buffer.data(), 2, 2), {0.0f, 1.0f}, 5), std::runtime_error);
+}
+
+TEST(ModelUtilsTest, FixedLabelMappingRejectsUnseenClasses) {
+    vector<float> buffer = {1, 2, 3, 4};
+    DenseMatrixView view(buffer.data(), 2, 2);
+    TrainingDataset::Options options;
+    map<float, int> mapping = {{-1.0f, 0}, {0.0f, 1}, {1.0f, 2}};
+    EXPECT_THROW(TrainingDataset(view, {1.0f, 2.0f}, "multi:softmax", mapping, options),
+                 TripleBarrier::DataValidationException);
+}
+
+TEST(ModelUtilsTest, InplacePredictionRequiresATrainedModel) {
+    XGBoostModel model;
+    vector<float> row = {1.0f, 2.0f};
+    EXPECT_THROW(model.predict_one(row.data()), std::runtime_error);
+    EXPECT_THROW(model.predict_batch_inplace(DenseMatrixView(row.data(), 1, 2)), std::runtime_error);
+}
+
+TEST(ModelUtilsTest, ConfidenceWeightedSignalsFollowTheProbabilityMatrix) {
+    ClassificationOutput output;
+    output.rows = 3;
+    output.num_classes = 3;
+    output.class_labels = {-1.0f, 0.0f, 1.0f};
+    output.probabilities = {0.1f, 0.2f, 0.7f,
+                            0.6f, 0.3f, 0.1f,
+                            0.2f, 0.6f, 0.2f};
+    output.class_indices = {2, 0, 1};
+    output.labels = {1, -1, 0};
+
+    auto signals = HardBarrierStrategy::convertClassificationToTradingSignals(output);
+    ASSERT_EQ(signals.size(), 3u);
+    EXPECT_NEAR(signals[0], 0.6, 1e-6);
+    EXPECT_NEAR(signals[1], -0.5, 1e-6);
+    EXPECT_NEAR(signals[2], 0.0, 1e-6);
+    EXPECT_FLOAT_EQ(output.confidence(0), 0.7f);
+    EXPECT_FLOAT_EQ(output.confidence(2), 0.6f);
+}
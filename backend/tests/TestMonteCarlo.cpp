@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "../ml/MonteCarlo.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+
+namespace {
+    vector<double> noisyReturns(size_t n) {
+        vector<double> returns(n);
+        for (size_t i = 0; i < n; ++i) returns[i] = 0.01 * std::sin(1.7 * i + 0.3) + (i % 4 == 0 ? -0.004 : 0.002);
+        return returns;
+    }
+}
+
+TEST(MonteCarloTest, BootstrapIntervalsBracketTheBacktest) {
+    auto returns = noisyReturns(400);
+    vector<double> signals(returns.size(), 1.0);
+    auto portfolio = simulate_portfolio(signals, returns);
+
+    MonteCarloConfig config;
+    config.simulations = 500;
+    config.max_threads = 4;
+    auto result = bootstrapTrades(portfolio, config);
+
+    EXPECT_EQ(result.simulations, 500u);
+    ASSERT_EQ(result.total_return.samples.size(), 500u);
+    EXPECT_TRUE(std::is_sorted(result.total_return.samples.begin(), result.total_return.samples.end()));
+    EXPECT_LE(result.total_return.lower, result.total_return.median);
+    EXPECT_LE(result.total_return.median, result.total_return.upper);
+    EXPECT_LT(result.total_return.lower, portfolio.total_return);
+    EXPECT_GT(result.total_return.upper, portfolio.total_return);
+    EXPECT_DOUBLE_EQ(result.total_return.observed, portfolio.total_return);
+    EXPECT_GE(result.max_drawdown.lower, 0.0);
+    EXPECT_GE(result.win_rate.lower, 0.0);
+    EXPECT_LE(result.win_rate.upper, 1.0);
+}
+
+TEST(MonteCarloTest, ResultsDependOnTheSeedNotTheThreadCount) {
+    auto returns = noisyReturns(120);
+    vector<double> signals(returns.size());
+    for (size_t i = 0; i < signals.size(); ++i) signals[i] = returns[i] > 0 ? 1.0 : -1.0;
+
+    MonteCarloConfig config;
+    config.simulations = 300;
+    config.max_threads = 1;
+    auto serial = permuteSignals(signals, returns, PortfolioConfig{}, config);
+    config.max_threads = 8;
+    auto parallel = permuteSignals(signals, returns, PortfolioConfig{}, config);
+    EXPECT_EQ(serial.total_return.samples, parallel.total_return.samples);
+
+    config.seed = 7;
+    auto reseeded = permuteSignals(signals, returns, PortfolioConfig{}, config);
+    EXPECT_NE(serial.total_return.samples, reseeded.total_return.samples);
+}
+
+TEST(MonteCarloTest, PermutationsRarelyBeatPerfectTiming) {
+    auto returns = noisyReturns(200);
+    vector<double> perfect(returns.size());
+    for (size_t i = 0; i < perfect.size(); ++i) perfect[i] = returns[i] > 0 ? 1.0 : -1.0;
+
+    MonteCarloConfig config;
+    config.simulations = 200;
+    auto result = permuteSignals(perfect, returns, PortfolioConfig{}, config);
+    EXPECT_DOUBLE_EQ(result.win_rate.observed, 1.0);
+    EXPECT_LT(result.total_return.p_value, 0.01);
+    EXPECT_LT(result.total_return.upper, result.total_return.observed);
+}
+
+TEST(MonteCarloTest, RejectsDegenerateInputs) {
+    auto portfolio = simulate_portfolio({0.0, 0.0}, {0.01, 0.02});
+    EXPECT_THROW(bootstrapTrades(portfolio), std::invalid_argument);
+
+    auto traded = simulate_portfolio({1.0, 1.0}, {0.01, 0.02});
+    MonteCarloConfig config;
+    config.simulations = 0;
+    EXPECT_THROW(bootstrapTrades(traded, config), std::invalid_argument);
+    config.simulations = 10;
+    config.mean_block_length = 0.5;
+    EXPECT_THROW(bootstrapTrades(traded, config), std::invalid_argument);
+    config.mean_block_length = 2.0;
+    config.confidence = 1.0;
+    EXPECT_THROW(bootstrapTrades(traded, config), std::invalid_argument);
+}
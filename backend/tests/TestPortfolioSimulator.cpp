@@ -0,0 +1,183 @@
+#include <gtest/gtest.h>
+#include "../ml/PortfolioSimulator.h"
+#include "../data/LabeledEvent.h"
+#include "../data/PreprocessedRow.h"
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+
+TEST(PortfolioSimulatorTest, RecordsDecisionsAsEnumsAndBooksOnlyTrades) {
+    vector<double> signals = {1.0, 0.1, -0.5, -0.2, 0.3};
+    vector<double> returns = {0.02, 0.05, -0.04, 0.01, -0.01};
+
+    auto result = simulate_portfolio(signals, returns);
+    ASSERT_EQ(result.trade_decisions.size(), 5u);
+    EXPECT_EQ(result.trade_decisions[0], TradeDecision::BUY);
+    EXPECT_EQ(result.trade_decisions[1], TradeDecision::HOLD);
+    EXPECT_EQ(result.trade_decisions[2], TradeDecision::SELL);
+    EXPECT_EQ(result.trade_decisions[3], TradeDecision::HOLD);
+    EXPECT_EQ(result.total_trades, 3);
+
+    ASSERT_EQ(result.trade_log.size(), 3u);
+    const auto& sell = result.trade_log[1];
+    EXPECT_EQ(sell.index, 2u);
+    EXPECT_EQ(sell.decision, TradeDecision::SELL);
+    EXPECT_DOUBLE_EQ(sell.position_pct, -0.125);
+    EXPECT_DOUBLE_EQ(sell.trade_return, -0.125 * sell.capital_before * -0.04);
+    EXPECT_DOUBLE_EQ(result.trade_log.back().capital_after, result.final_capital);
+    EXPECT_EQ(result.trade_returns.size(), 3u);
+    EXPECT_DOUBLE_EQ(result.win_rate, 2.0 / 3.0);
+}
+
+TEST(PortfolioSimulatorTest, WritesNothingUnlessASinkIsGiven) {
+    vector<double> signals(50, 1.0);
+    vector<double> returns(50, 0.01);
+
+    testing::internal::CaptureStdout();
+    auto quiet = simulate_portfolio(signals, returns);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    EXPECT_EQ(quiet.total_trades, 50);
+
+    PortfolioConfig config;
+    config.max_trade_decisions_logged = 10;
+    ostringstream out;
+    config.trade_sink = streamTradeSink(out);
+    auto logged = simulate_portfolio({0.0, 1.0}, {0.0, 0.04}, config);
+    EXPECT_EQ(logged.trade_decisions.size(), 2u);
+    EXPECT_EQ(out.str(), "Index 1: Trade 1: BUY 25.00%, PnL: 10.00, Capital: 1010.00\n");
+
+    int calls = 0;
+    config.trade_sink = [&calls](const TradeLogEntry& entry, int trade_number) {
+        EXPECT_EQ(++calls, trade_number);
+        EXPECT_NE(entry.decision, TradeDecision::HOLD);
+    };
+    auto counted = simulate_portfolio(signals, returns, config);
+    EXPECT_EQ(calls, 50);
+    EXPECT_EQ(counted.trade_decisions.size(), 10u);
+}
+
+TEST(PortfolioSimulatorTest, SweepMatchesOneSimulationPerConfiguration) {
+    vector<double> signals(300), returns(300);
+    for (size_t i = 0; i < signals.size(); ++i) {
+        signals[i] = std::sin(0.37 * i) * 1.2;
+        returns[i] = 0.01 * std::cos(0.11 * i) + (i % 7 == 0 ? -0.02 : 0.003);
+    }
+    // simulate_portfolio holds on a NaN signal; the sweep must too.
+    signals[17] = signals[150] = std::numeric_limits<double>::quiet_NaN();
+
+    vector<PortfolioConfig> configs;
+    for (int t = 0; t < 15; ++t) {
+        for (int p = 0; p < 10; ++p) {
+            PortfolioConfig config;
+            config.position_threshold = 0.07 * t;
+            config.hard_barrier_position_pct = 0.05 + 0.1 * p;
+            config.starting_capital = 1000.0 + 10 * p;
+            configs.push_back(config);
+        }
+    }
+
+    auto sweep = simulate_portfolio_sweep(signals, returns, configs, 3);
+    ASSERT_EQ(sweep.size(), configs.size());
+    for (size_t k = 0; k < configs.size(); ++k) {
+        auto single = simulate_portfolio(signals, returns, configs[k]);
+        EXPECT_NEAR(sweep.final_capital[k], single.final_capital, 1e-9 * single.final_capital) << k;
+        EXPECT_NEAR(sweep.total_return[k], single.total_return, 1e-12) << k;
+        EXPECT_NEAR(sweep.max_drawdown[k], single.max_drawdown, 1e-12) << k;
+        EXPECT_EQ(sweep.total_trades[k], single.total_trades) << k;
+        EXPECT_DOUBLE_EQ(sweep.win_rate[k], single.win_rate) << k;
+        EXPECT_NEAR(sweep.sharpe[k], single.sharpe, 1e-9) << k;
+        EXPECT_NEAR(sweep.sortino[k], single.sortino, 1e-9) << k;
+        EXPECT_TRUE(std::isfinite(sweep.final_capital[k])) << k;
+    }
+
+    EXPECT_EQ(simulate_portfolio_sweep(signals, returns, {}).size(), 0u);
+    EXPECT_THROW(simulate_portfolio_sweep({1.0}, {0.1, 0.2}, configs), std::invalid_argument);
+}
+
+TEST(PortfolioSimulatorTest, DrawdownIsMeasuredFromTheRunningPeak) {
+    // Capital rises to a peak, falls, recovers above the start, then dips again.
+    vector<double> signals(6, 1.0);
+    PortfolioConfig config;
+    config.hard_barrier_position_pct = 1.0;
+    auto result = simulate_portfolio(signals, {0.5, -0.2, -0.25, 0.1, 0.5, -0.1}, config);
+
+    // 1000 -> 1500 -> 1200 -> 900 -> 990 -> 1485 -> 1336.5
+    EXPECT_NEAR(result.max_drawdown, 600.0 / 1500.0, 1e-12);
+    EXPECT_EQ(result.max_drawdown_duration, 5u);
+    EXPECT_NEAR(result.turnover, 1.0, 1e-12);
+    EXPECT_GT(result.sharpe, 0.0);
+    EXPECT_GT(result.sortino, 0.0);
+}
+
+TEST(PortfolioSimulatorTest, EquityCurveStaysWithinItsPointBudget) {
+    vector<double> signals(1000, 1.0), returns(1000, 0.001);
+    PortfolioConfig config;
+    config.equity_curve_points = 64;
+    auto result = simulate_portfolio(signals, returns, config);
+
+    const auto& curve = result.equity_curve;
+    EXPECT_LE(curve.points.size(), 65u);
+    EXPECT_GE(curve.points.size(), 32u);
+    EXPECT_DOUBLE_EQ(curve.points.front(), 1000.0);
+    EXPECT_DOUBLE_EQ(curve.points.back(), result.final_capital);
+    EXPECT_NEAR(curve.points[3], 1000.0 * std::pow(1.00025, 3 * curve.stride), 1e-9);
+
+    config.equity_curve_points = 0;
+    EXPECT_TRUE(simulate_portfolio(signals, returns, config).equity_curve.points.empty());
+}
+
+TEST(PortfolioSimulatorTest, BarrierDiagnosticsMatchEventsByIndexOrTimestamp) {
+    vector<PreprocessedRow> rows(6);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i].timestamp = "t" + to_string(i);
+        rows[i].price = 100.0;
+        rows[i].volatility = 0.01 * (i + 1);
+    }
+
+    auto event = [](const string& entry, int label, double exit_price, int periods) {
+        LabeledEvent e;
+        e.entry_time = entry;
+        e.label = label;
+        e.exit_price = exit_price;
+        e.periods_to_exit = periods;
+        return e;
+    };
+    vector<LabeledEvent> events = {
+        event("t1", 1, 102.0, 2),
+        event("t3", -1, 99.0, 4),
+        event("missing", 0, 100.0, 120),
+    };
+    events[1].entry_index = 3;
+
+    BarrierHistogramConfig bins;
+    bins.time_bins = 10;
+    bins.distance_bins = 4;
+    bins.distance_bin_pct = 1.0;
+    auto diagnostics = analyzeBarriers(events, rows, bins);
+
+    EXPECT_EQ(diagnostics.profit_hits, 1);
+    EXPECT_EQ(diagnostics.stop_hits, 1);
+    EXPECT_EQ(diagnostics.time_hits, 1);
+    EXPECT_NEAR(diagnostics.avg_volatility, (0.02 + 0.04) / 3.0, 1e-12);
+    EXPECT_DOUBLE_EQ(diagnostics.min_volatility, 0.02);
+    EXPECT_DOUBLE_EQ(diagnostics.max_volatility, 0.04);
+    EXPECT_DOUBLE_EQ(diagnostics.avg_entry_price, 100.0);
+    EXPECT_DOUBLE_EQ(diagnostics.avg_profit_barrier, 101.5);
+    EXPECT_DOUBLE_EQ(diagnostics.avg_time_time, 120.0);
+
+    ASSERT_EQ(diagnostics.periods_to_exit.counts.size(), 10u);
+    EXPECT_EQ(diagnostics.periods_to_exit.counts[2], 1);
+    EXPECT_EQ(diagnostics.periods_to_exit.counts[4], 1);
+    EXPECT_EQ(diagnostics.periods_to_exit.counts[9], 1);  // overflow bin
+    EXPECT_EQ(diagnostics.barrier_distance_pct.counts, (vector<int>{0, 1, 1, 0}));
+
+    auto empty = analyzeBarriers({}, rows);
+    EXPECT_EQ(empty.periods_to_exit.counts.size(), 50u);
+    EXPECT_EQ(empty.profit_hits, 0);
+}
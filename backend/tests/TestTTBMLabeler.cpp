@@ -155,3 +155,25 @@ TEST(TTBMLabelerTest, MultipleEvents) {
     // Quick event should have higher magnitude than slower event
     EXPECT_GT(std::abs(result[0].ttbm_label), std::abs(result[1].ttbm_label));
 }
+
+TEST(TTBMLabelerTest, CarriesEntryAndExitRowIndices) {
+    TTBMLabeler labeler(BarrierConfig::Exponential, 1.0, 0.5, 1.0);
+    
+    std::vector<PreprocessedRow> data(10);
+    for (int i = 0; i < 10; ++i) {
+        data[i].timestamp = std::to_string(i);
+        data[i].price = 100.0;
+        data[i].volatility = 1.0;
+    }
+    data[7].price = 0.0;
+    
+    std::vector<size_t> events = {0, 5};
+    auto result = labeler.label(data, events, 2.0, 1.0, 4);
+    
+    ASSERT_EQ(result.size(), 2);
+    EXPECT_EQ(result[0].entry_index, 0);
+    EXPECT_EQ(result[0].exit_index, 4);
+    EXPECT_EQ(result[1].entry_index, 5);
+    EXPECT_EQ(result[1].exit_index, 7);
+    EXPECT_EQ(data[result[1].exit_index].timestamp, result[1].exit_time);
+}
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include "../ml/WalkForward.h"
+#include "../ml/TrainingDataset.h"
+#include "TestHelpers.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+using TestHelpers::SyntheticData;
+using TestHelpers::alternatingReturns;
+using TestHelpers::deterministicConfig;
+using TestHelpers::evenlySpacedWindows;
+using TestHelpers::makeSyntheticData;
+using MLSplitUtils::IndexRange;
+using MLSplitUtils::RangeList;
+
+namespace {
+    WalkForwardConfig windows(size_t train, size_t test, size_t embargo, WalkForwardWindow window) {
+        WalkForwardConfig config;
+        config.train_size = train;
+        config.test_size = test;
+        config.embargo = embargo;
+        config.window = window;
+        return config;
+    }
+}
+
+TEST(WalkForwardTest, ExpandingWindowsGrowFromTheFirstSample) {
+    auto steps = planWalkForward(25, windows(10, 4, 0, WalkForwardWindow::EXPANDING));
+    ASSERT_EQ(steps.size(), 4u);
+    EXPECT_EQ(steps[0].train, (IndexRange{0, 10}));
+    EXPECT_EQ(steps[0].test, (IndexRange{10, 14}));
+    EXPECT_EQ(steps[2].train, (IndexRange{0, 18}));
+    EXPECT_EQ(steps[3].test, (IndexRange{22, 25}));  // shorter final block
+}
+
+TEST(WalkForwardTest, RollingWindowsKeepTheirLengthBehindTheEmbargo) {
+    auto steps = planWalkForward(30, windows(8, 5, 2, WalkForwardWindow::ROLLING));
+    ASSERT_EQ(steps.size(), 4u);
+    for (const auto& step : steps) {
+        EXPECT_EQ(step.train.size(), 8u);
+        EXPECT_EQ(step.train.end + 2, step.test.begin);
+    }
+    EXPECT_EQ(steps[0].test, (IndexRange{10, 15}));
+    EXPECT_EQ(steps[1].train, (IndexRange{5, 13}));
+    EXPECT_EQ(steps[3].test, (IndexRange{25, 30}));
+}
+
+TEST(WalkForwardTest, RejectsWindowsThatLeaveNothingToTest) {
+    EXPECT_THROW(planWalkForward(20, windows(0, 5, 0, WalkForwardWindow::EXPANDING)), std::invalid_argument);
+    EXPECT_THROW(planWalkForward(20, windows(10, 0, 0, WalkForwardWindow::EXPANDING)), std::invalid_argument);
+    EXPECT_THROW(planWalkForward(20, windows(15, 5, 5, WalkForwardWindow::ROLLING)), std::invalid_argument);
+}
+
+TEST(WalkForwardTest, PurgesTrainingSamplesWhoseLabelsReachTheTestBlock) {
+    // Sample i spans bars [2i, 2i + 5]; sample 3 is held until bar 39.
+    auto events = evenlySpacedWindows(30, 5);
+    events[3].end = 39;
+    auto steps = planWalkForward(events, windows(10, 5, 0, WalkForwardWindow::EXPANDING));
+    ASSERT_EQ(steps.size(), 4u);
+
+    // The first test block starts at bar 20: samples 8 and 9 resolve at bars 21 and 23.
+    EXPECT_EQ(steps[0].train, (IndexRange{0, 10}));
+    EXPECT_EQ(steps[0].train_rows, (RangeList{{0, 3}, {4, 8}}));
+    EXPECT_EQ(steps[0].purged, 3u);
+    EXPECT_EQ(steps[1].train_rows, (RangeList{{0, 3}, {4, 13}}));
+    EXPECT_EQ(steps[2].train_rows, (RangeList{{0, 18}}));
+    for (const auto& step : steps) {
+        for (const auto& r : step.train_rows) {
+            for (size_t i = r.begin; i < r.end; ++i) EXPECT_LT(events[i].end, events[step.test.begin].start);
+        }
+    }
+
+    // Without windows nothing is purged.
+    auto unpurged = planWalkForward(events.size(), windows(10, 5, 0, WalkForwardWindow::EXPANDING));
+    EXPECT_EQ(unpurged[0].train_rows, (RangeList{{0, 10}}));
+    EXPECT_EQ(unpurged[0].purged, 0u);
+
+    auto long_held = evenlySpacedWindows(20, 30);
+    EXPECT_THROW(planWalkForward(long_held, windows(4, 4, 0, WalkForwardWindow::ROLLING)), std::invalid_argument);
+}
+
+TEST(WalkForwardTest, StitchesOutOfSampleSignalsIntoOnePortfolio) {
+    auto returns = alternatingReturns(40);
+    auto steps = planWalkForward(returns.size(), windows(12, 7, 1, WalkForwardWindow::ROLLING));
+    CoreBudget budget;
+    budget.jobs = 3;
+    budget.threads_per_job = 2;
+
+    atomic<int> calls{0};
+    auto predict = [&](const WalkForwardStep& step, int nthread) {
+        EXPECT_EQ(nthread, 2);
+        EXPECT_LT(step.train.end, step.test.begin);
+        ++calls;
+        vector<double> signals;
+        for (size_t i = step.test.begin; i < step.test.end; ++i) signals.push_back(returns[i] > 0 ? 1.0 : -1.0);
+        return signals;
+    };
+
+    auto result = runWalkForward(steps, returns, budget, predict);
+    EXPECT_EQ(calls.load(), static_cast<int>(steps.size()));
+    EXPECT_EQ(result.tested, (IndexRange{13, 40}));
+    ASSERT_EQ(result.signals.size(), 27u);
+    for (size_t i = 0; i < result.signals.size(); ++i) {
+        EXPECT_EQ(result.signals[i], returns[13 + i] > 0 ? 1.0 : -1.0) << "sample " << 13 + i;
+    }
+    EXPECT_GT(result.portfolio.total_return, 0.0);
+    EXPECT_GT(result.sharpe, 0.0);
+}
+
+TEST(WalkForwardTest, RejectsPredictorsThatMissSamples) {
+    auto returns = alternatingReturns(20);
+    auto steps = planWalkForward(returns.size(), windows(10, 5, 0, WalkForwardWindow::EXPANDING));
+    CoreBudget budget;
+    auto short_by_one = [](const WalkForwardStep& step, int) {
+        return vector<double>(step.test.size() - 1, 1.0);
+    };
+    EXPECT_THROW(runWalkForward(steps, returns, budget, short_by_one), std::runtime_error);
+
+    steps.erase(steps.begin());
+    steps.push_back(steps.front());
+    EXPECT_THROW(runWalkForward(steps, returns, budget, short_by_one), std::invalid_argument);
+}
+
+TEST(WalkForwardTest, ModelStepsTrainOnTheirPurgedRows) {
+    SyntheticData data = makeSyntheticData(200, 5, false, 3);
+    auto events = evenlySpacedWindows(data.rows, 7);
+    auto returns = alternatingReturns(data.rows);
+    WalkForwardConfig config = windows(80, 40, 0, WalkForwardWindow::ROLLING);
+    config.jobs = 2;
+    XGBoostConfig model_config = deterministicConfig("binary:logistic", 10);
+
+    auto raw_signals = [](const XGBoostModel& model, const DenseMatrixView& X) {
+        auto raw = model.predict_raw(X);
+        return vector<double>(raw.begin(), raw.end());
+    };
+    auto result = runModelWalkForward(data.view(), data.y, events, returns, model_config, config, raw_signals);
+    ASSERT_EQ(result.steps.size(), 3u);
+    EXPECT_EQ(result.tested, (IndexRange{80, 200}));
+    ASSERT_EQ(result.signals.size(), 120u);
+
+    // Step 1 by hand: the three samples before its test block are purged.
+    const auto& step = result.steps[1];
+    EXPECT_EQ(step.train_rows, (RangeList{{40, 117}}));
+    MLSplitUtils::RowRangeView rows(data.view(), step.train_rows);
+    TrainingDataset::Options options;
+    options.nthread = 1;
+    TrainingDataset train_data(rows, MLSplitUtils::selectRanges(data.y, step.train_rows), "binary:logistic", options);
+    XGBoostModel model;
+    model.fit(train_data, model_config);
+    auto expected = model.predict_raw(data.view().rowRange(step.test.begin, step.test.end));
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_DOUBLE_EQ(result.signals[40 + i], expected[i]) << "sample " << step.test.begin + i;
+    }
+}
+
+TEST(WalkForwardTest, WarmStartKeepsClassesThatOnlyAppearInLaterWindows) {
+    SyntheticData data = makeSyntheticData(240, 5, true, 5);
+    // No -1 labels until the second test block.
+    for (size_t i = 0; i < 120; ++i) data.y[i] = max(data.y[i], 0.0f);
+    ASSERT_NE(find(data.y.begin() + 120, data.y.end(), -1.0f), data.y.end());
+
+    auto events = evenlySpacedWindows(data.rows, 1);
+    auto returns = alternatingReturns(data.rows);
+    WalkForwardConfig config = windows(80, 40, 0, WalkForwardWindow::EXPANDING);
+    config.warm_start = true;
+    config.warm_start_rounds = 5;
+
+    vector<int> rounds;
+    vector<size_t> classes;
+    auto probe = [&](const XGBoostModel& model, const DenseMatrixView& X) {
+        rounds.push_back(model.boosted_rounds());
+        classes.push_back(model.predict_full(X).num_classes);
+        return vector<double>(X.rows, 0.0);
+    };
+    auto result = runModelWalkForward(data.view(), data.y, events, returns,
+                                      deterministicConfig("multi:softprob", 10), config, probe);
+    ASSERT_EQ(result.steps.size(), 4u);
+    EXPECT_EQ(rounds, (vector<int>{10, 15, 20, 25}));
+    EXPECT_EQ(classes, (vector<size_t>{3, 3, 3, 3}));
+}
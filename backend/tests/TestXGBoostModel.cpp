@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include "../ml/XGBoostModel.h"
+#include "../ml/TrainingDataset.h"
+#include "TestHelpers.h"
+#include <vector>
+
+using namespace std;
+using namespace MLPipeline;
+using TestHelpers::SyntheticData;
+using TestHelpers::makeSyntheticData;
+using TestHelpers::deterministicConfig;
+
+TEST(XGBoostModelTest, EarlyStoppingKeepsTreesUpToTheBestIteration) {
+    SyntheticData train = makeSyntheticData(600, 6, false, 1);
+    SyntheticData eval = makeSyntheticData(300, 6, false, 2);
+    // Inverted eval labels: every tree fitted to the training labels hurts the eval loss
+    // after the first few, so training stops well before n_rounds.
+    for (float& label : eval.y) label = 1.0f - label;
+
+    TrainingDataset train_data(train.view(), train.y, "binary:logistic");
+    TrainingDataset eval_data(eval.view(), eval.y, train_data);
+    XGBoostConfig config = deterministicConfig("binary:logistic", 200);
+    config.early_stopping_rounds = 5;
+
+    XGBoostModel model;
+    model.fit(train_data, eval_data, config);
+    ASSERT_GE(model.best_iteration(), 0);
+    EXPECT_LT(model.boosted_rounds(), config.n_rounds);
+    EXPECT_EQ(model.boosted_rounds(), model.best_iteration() + 1 + config.early_stopping_rounds);
+    EXPECT_EQ(model.prediction_rounds(), model.best_iteration() + 1);
+
+    // Predictions must equal those of a model boosted for exactly the best rounds.
+    XGBoostConfig truncated_config = deterministicConfig("binary:logistic", model.best_iteration() + 1);
+    XGBoostModel truncated;
+    truncated.fit(train_data, truncated_config);
+
+    SyntheticData test = makeSyntheticData(200, 6, false, 3);
+    auto raw = model.predict_raw(test.view());
+    auto expected = truncated.predict_raw(test.view());
+    ASSERT_EQ(raw.size(), expected.size());
+    for (size_t i = 0; i < raw.size(); ++i) EXPECT_FLOAT_EQ(raw[i], expected[i]) << i;
+
+    const auto& inplace = model.predict_batch_inplace(test.view());
+    ASSERT_EQ(inplace.size(), expected.size());
+    for (size_t i = 0; i < inplace.size(); ++i) EXPECT_FLOAT_EQ(inplace[i], expected[i]) << i;
+
+    EXPECT_EQ(model.predict(test.view()), truncated.predict(test.view()));
+}
+
+TEST(XGBoostModelTest, SavedModelsReloadWithIdenticalPredictions) {
+    SyntheticData binary = makeSyntheticData(500, 5, false, 4);
+    SyntheticData barrier = makeSyntheticData(500, 5, true, 5);
+    SyntheticData test = makeSyntheticData(100, 5, false, 6);
+
+    struct Case {
+        const SyntheticData* data;
+        string objective;
+        bool quantile;
+    };
+    for (const Case& c : {Case{&binary, "binary:logistic", false}, Case{&barrier, "multi:softprob", true}}) {
+        TrainingDataset::Options options;
+        options.nthread = 1;
+        options.use_quantile = c.quantile;
+        options.max_bin = 32;
+        TrainingDataset train_data(c.data->view(), c.data->y, c.objective, options);
+        XGBoostModel model;
+        model.fit(train_data, deterministicConfig(c.objective, 15));
+        model.set_feature_names({"f0", "f1", "f2", "f3", "f4"});
+
+        vector<char> buffer = model.save_to_buffer();
+        XGBoostModel loaded;
+        loaded.load_from_buffer(buffer.data(), buffer.size());
+
+        EXPECT_EQ(loaded.boosted_rounds(), model.boosted_rounds()) << c.objective;
+        EXPECT_EQ(loaded.quantile_max_bin(), c.quantile ? 32 : 0) << c.objective;
+        EXPECT_EQ(loaded.get_feature_names(), model.get_feature_names()) << c.objective;
+        EXPECT_EQ(loaded.predict_raw(test.view()), model.predict_raw(test.view())) << c.objective;
+        EXPECT_EQ(loaded.predict(test.view()), model.predict(test.view())) << c.objective;
+
+        // A reloaded model saves and reloads again with the same state.
+        vector<char> resaved = loaded.save_to_buffer();
+        XGBoostModel reloaded;
+        reloaded.load_from_buffer(resaved.data(), resaved.size());
+        EXPECT_EQ(reloaded.quantile_max_bin(), loaded.quantile_max_bin()) << c.objective;
+        EXPECT_EQ(reloaded.predict_raw(test.view()), model.predict_raw(test.view())) << c.objective;
+    }
+}
+
+TEST(XGBoostModelTest, ReloadedModelContinuesTrainingLikeTheOriginal) {
+    SyntheticData first = makeSyntheticData(400, 5, true, 7);
+    SyntheticData later = makeSyntheticData(200, 5, true, 8);
+    SyntheticData test = makeSyntheticData(100, 5, true, 9);
+
+    TrainingDataset::Options options;
+    options.nthread = 1;
+    options.use_quantile = true;
+    options.max_bin = 64;
+    TrainingDataset train_data(first.view(), first.y, "multi:softprob", options);
+    XGBoostModel original;
+    original.fit(train_data, deterministicConfig("multi:softprob", 10));
+
+    vector<char> buffer = original.save_to_buffer();
+    XGBoostModel reloaded;
+    reloaded.load_from_buffer(buffer.data(), buffer.size());
+
+    original.continue_training(later.view(), later.y, 5);
+    reloaded.continue_training(later.view(), later.y, 5);
+    EXPECT_EQ(reloaded.boosted_rounds(), 15);
+    EXPECT_EQ(reloaded.quantile_max_bin(), 64);
+    EXPECT_EQ(reloaded.predict_raw(test.view()), original.predict_raw(test.view()));
+}
+
+TEST(XGBoostModelTest, BlockDatasetTrainsLikeTheGatheredRows) {
+    SyntheticData data = makeSyntheticData(300, 5, true, 7);
+    SyntheticData test = makeSyntheticData(100, 5, true, 9);
+    MLSplitUtils::RowRangeView rows(data.view(), {{0, 80}, {120, 210}, {250, 300}});
+    vector<float> y = MLSplitUtils::selectRanges(data.y, rows.ranges);
+
+    TrainingDataset::Options options;
+    options.nthread = 1;
+    options.use_quantile = true;
+    TrainingDataset blocks(rows, y, "multi:softprob", options);
+    FlatFloatMatrix gathered = rows.gather();
+    TrainingDataset copy(gathered.view(), y, "multi:softprob", options);
+    EXPECT_EQ(blocks.rows(), 220u);
+    EXPECT_EQ(blocks.label_mapping(), copy.label_mapping());
+
+    XGBoostModel from_blocks, from_copy;
+    from_blocks.fit(blocks, deterministicConfig("multi:softprob", 10));
+    from_copy.fit(copy, deterministicConfig("multi:softprob", 10));
+    vector<float> expected = from_copy.predict_raw(test.view());
+    vector<float> actual = from_blocks.predict_raw(test.view());
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) EXPECT_NEAR(actual[i], expected[i], 1e-6) << i;
+}
+
+TEST(XGBoostModelTest, InplacePredictionMatchesDMatrixPrediction) {
+    SyntheticData binary = makeSyntheticData(500, 6, false, 10);
+    SyntheticData barrier = makeSyntheticData(500, 6, true, 11);
+    SyntheticData test = makeSyntheticData(150, 6, true, 12);
+    // Missing values take the trees' default directions on both paths.
+    for (size_t i = 0; i < test.rows; i += 7) test.X[i * test.cols + (i % test.cols)] = -1.0f;
+
+    auto check = [&](const XGBoostModel& model, const string& name) {
+        auto raw = model.predict_raw(test.view());
+        auto labels = model.predict(test.view());
+        const auto& inplace = model.predict_batch_inplace(test.view());
+        ASSERT_EQ(inplace.size(), raw.size()) << name;
+        for (size_t i = 0; i < raw.size(); ++i) EXPECT_FLOAT_EQ(inplace[i], raw[i]) << name << " output " << i;
+        ASSERT_EQ(labels.size(), test.rows) << name;
+        for (size_t i = 0; i < test.rows; ++i) {
+            EXPECT_EQ(model.predict_one(test.X.data() + i * test.cols), labels[i]) << name << " row " << i;
+        }
+    };
+
+    XGBoostModel binary_model;
+    binary_model.fit(binary.view(), binary.y, deterministicConfig("binary:logistic", 20));
+    check(binary_model, "binary:logistic");
+
+    for (const string objective : {"multi:softmax", "multi:softprob"}) {
+        XGBoostModel model;
+        model.fit(barrier.view(), barrier.y, deterministicConfig(objective, 20));
+        check(model, objective);
+    }
+
+    // Early stopping: in-place prediction must stop at the best iteration too.
+    SyntheticData eval = makeSyntheticData(200, 6, false, 13);
+    for (float& label : eval.y) label = 1.0f - label;
+    TrainingDataset train_data(binary.view(), binary.y, "binary:logistic");
+    TrainingDataset eval_data(eval.view(), eval.y, train_data);
+    XGBoostConfig config = deterministicConfig("binary:logistic", 200);
+    config.early_stopping_rounds = 5;
+    XGBoostModel early;
+    early.fit(train_data, eval_data, config);
+    ASSERT_GE(early.best_iteration(), 0);
+    ASSERT_LT(early.prediction_rounds(), early.boosted_rounds());
+    check(early, "early-stopped");
+}
+
+TEST(XGBoostModelTest, MulticlassPredictFullDecodesBarrierLabels) {
+    SyntheticData barrier = makeSyntheticData(900, 5, true, 14);
+    SyntheticData test = makeSyntheticData(200, 5, true, 15);
+
+    for (const string objective : {"multi:softprob", "multi:softmax"}) {
+        XGBoostModel model;
+        model.fit(barrier.view(), barrier.y, deterministicConfig(objective, 30));
+
+        ClassificationOutput full = model.predict_full(test.view());
+        ASSERT_EQ(full.num_classes, 3u) << objective;
+        EXPECT_EQ(full.class_labels, (vector<float>{-1.0f, 0.0f, 1.0f})) << objective;
+        ASSERT_EQ(full.labels.size(), test.rows) << objective;
+        EXPECT_EQ(full.labels, model.predict(test.view())) << objective;
+
+        size_t correct = 0;
+        for (size_t i = 0; i < test.rows; ++i) {
+            const float* row = full.row(i);
+            EXPECT_NEAR(row[0] + row[1] + row[2], 1.0f, 1e-5f) << objective << " row " << i;
+            EXPECT_EQ(full.labels[i], static_cast<int>(full.class_labels[full.class_indices[i]]));
+            EXPECT_TRUE(full.labels[i] >= -1 && full.labels[i] <= 1);
+            if (full.labels[i] == static_cast<int>(test.y[i])) ++correct;
+        }
+        // The labels follow the features, so decoding must line up with the true barriers.
+        EXPECT_GT(correct, test.rows / 2) << objective;
+    }
+}
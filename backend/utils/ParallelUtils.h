@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TripleBarrier {
+namespace Parallel {
+
+inline unsigned hardwareThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1u : n;
+}
+
+// Runs fn(i) for every i in [0, count) on at most maxThreads workers (0 = all cores).
+// Work is handed out one index at a time so uneven tasks balance across workers.
+// The first exception thrown by any task stops further scheduling and is rethrown here.
+template<typename Fn>
+void parallelFor(size_t count, unsigned maxThreads, Fn&& fn) {
+    if (count == 0) return;
+
+    unsigned workers = maxThreads == 0 ? hardwareThreads() : maxThreads;
+    workers = static_cast<unsigned>(std::min<size_t>(workers, count));
+
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        while (!failed.load(std::memory_order_relaxed)) {
+            size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) break;
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError) firstError = std::current_exception();
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (unsigned t = 1; t < workers; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (firstError) std::rethrow_exception(firstError);
+}
+
+} // namespace Parallel
+} // namespace TripleBarrier
@@ -25,7 +25,13 @@ FeatureSelectionDialog::FeatureSelectionDialog(QWidget* parent)
         "Current close price relative to 5-day high",
         "Slope of linear regression of close prices over 10 days",
         "Day of the week",
-        "Days since last event"
+        "Days since last event",
+        "Hour of the day",
+        "Minute of the day",
+        "Month of the year",
+        "Trading session",
+        "Events in the last 20 bars",
+        "Events in the last 50 bars"
     };
     for (const QString& feat : features) {
         QCheckBox* cb = new QCheckBox(feat, this);
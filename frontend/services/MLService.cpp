@@ -2,6 +2,7 @@
 #include "../../backend/data/PreprocessedRow.h"
 #include "../../backend/data/LabeledEvent.h"
 #include "../../backend/data/FeatureExtractor.h"
+#include "../../backend/data/EventIndexUtils.h"
 #include "../../backend/ml/MLPipeline.h"
 #include "../../backend/ml/PortfolioSimulator.h"
 #include "../../backend/ml/MLSplits.h"
@@ -31,20 +32,47 @@ MLServiceImpl::MLServiceImpl()
     ErrorHandlingStrategy::setMode(ErrorHandlingStrategy::Mode::MIXED);
 }
 
+FeatureServiceImpl::FeatureServiceImpl() {
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheDir.isEmpty()) {
+        feature_store_ = std::make_unique<FeatureStore>(QDir(cacheDir).filePath("features").toStdString());
+    }
+}
+
+FeatureExtractor::FeatureExtractionResult FeatureServiceImpl::extractWithCache(
+    FeatureStore::Mode mode,
+    const std::set<std::string>& features,
+    const std::vector<PreprocessedRow>& rows,
+    const std::vector<LabeledEvent>& labeledEvents) {
+    auto extract = [&]() {
+        return mode == FeatureStore::Mode::REGRESSION
+            ? FeatureExtractor::extractFeaturesForRegression(features, rows, labeledEvents)
+            : FeatureExtractor::extractFeaturesForClassification(features, rows, labeledEvents);
+    };
+    if (!feature_store_) {
+        return extract();
+    }
+    
+    uint64_t key = FeatureStore::computeKey(mode, FeatureExtractor::resolveBackendFeatures(features), rows, labeledEvents);
+    FeatureExtractor::FeatureExtractionResult result;
+    if (feature_store_->load(key, result)) {
+        return result;
+    }
+    
+    result = extract();
+    if (!result.features.empty() && !feature_store_->save(key, mode, result)) {
+        std::cerr << "[FeatureServiceImpl] WARNING: Could not cache features in " << feature_store_->directory() << std::endl;
+    }
+    return result;
+}
+
 void FeatureServiceImpl::validateEventAlignment(
     const std::vector<PreprocessedRow>& rows,
     const std::vector<LabeledEvent>& labeledEvents,
     ValidationFramework::ValidationAccumulator& accumulator) {
-    std::set<std::string> rowTimestamps;
-    for (const auto& row : rows) {
-        rowTimestamps.insert(row.timestamp);
-    }
-    size_t matchedEvents = 0;
-    for (const auto& event : labeledEvents) {
-        if (rowTimestamps.count(event.entry_time)) {
-            matchedEvents++;
-        }
-    }
+    std::vector<int> entryIndices = EventIndexUtils::resolveEntryIndices(rows, labeledEvents);
+    size_t matchedEvents = static_cast<size_t>(
+        std::count_if(entryIndices.begin(), entryIndices.end(), [](int idx) { return idx >= 0; }));
     if (matchedEvents != labeledEvents.size()) {
         std::cerr << "[FeatureServiceImpl] WARNING: Only " << matchedEvents << " out of " << labeledEvents.size() << " labeled events have matching data rows." << std::endl;
     }
@@ -82,7 +110,7 @@ FeatureExtractor::FeatureExtractionResult FeatureServiceImpl::extractFeaturesFor
         );
     }
     try {
-        auto result = FeatureExtractor::extractFeaturesForClassification(features, rows, labeledEvents);
+        auto result = extractWithCache(FeatureStore::Mode::CLASSIFICATION, features, rows, labeledEvents);
         if (result.features.empty()) {
             throw TripleBarrier::FeatureExtractionException(
                 "Feature extraction returned empty feature set",
@@ -134,7 +162,7 @@ FeatureExtractor::FeatureExtractionResult FeatureServiceImpl::extractFeaturesFor
         );
     }
     try {
-        auto result = FeatureExtractor::extractFeaturesForRegression(features, rows, labeledEvents);
+        auto result = extractWithCache(FeatureStore::Mode::REGRESSION, features, rows, labeledEvents);
         if (result.features.empty()) {
             throw TripleBarrier::FeatureExtractionException(
                 "Feature extraction returned empty feature set",
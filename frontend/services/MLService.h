@@ -12,6 +12,7 @@ struct PreprocessedRow;
 struct LabeledEvent;
 
 #include "../backend/data/FeatureExtractor.h"
+#include "../backend/data/FeatureStore.h"
 #include "../backend/ml/PortfolioSimulator.h"
 #include "../backend/ml/MLPipeline.h"
 #include "../utils/ValidationFramework.h"
@@ -173,6 +174,8 @@ signals:
 
 class FeatureServiceImpl : public FeatureService {
 public:
+    FeatureServiceImpl();
+    
     FeatureExtractor::FeatureExtractionResult extractFeaturesForClassification(
         const std::vector<PreprocessedRow>& rows,
         const std::vector<LabeledEvent>& labeledEvents,
@@ -189,6 +192,15 @@ public:
     void validateEventAlignment(const std::vector<PreprocessedRow>& rows,
                                const std::vector<LabeledEvent>& labeledEvents,
                                ValidationFramework::ValidationAccumulator& accumulator);
+
+private:
+    std::unique_ptr<FeatureStore> feature_store_;
+    
+    FeatureExtractor::FeatureExtractionResult extractWithCache(
+        FeatureStore::Mode mode,
+        const std::set<std::string>& features,
+        const std::vector<PreprocessedRow>& rows,
+        const std::vector<LabeledEvent>& labeledEvents);
 };
 
 class ModelServiceImpl : public ModelService {